@@ -0,0 +1,1298 @@
+/*
+ * bench.c - Benchmark harness for the partition generators.
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   CC = gcc #(or clang)
+ *   CFLAGS = -std=gnu11 -O3 #(or, -O2)
+ *   OBJS = partition.o perfctr.o qseries.o topology.o util.o
+ *   $(CC) $(CFLAGS) -o partnbench bench.c $(OBJS)
+ *
+ * Usage: ./partnbench [OPTIONS]
+ *
+ *   -a, --algos LIST         Generators to run (default: all).
+ *   -V, --visitors LIST      Visitors to run: none, len, sum
+ *                            (default: none,sum).
+ *   -n, --sweep LO[:HI[:ST]] Values of n (default: 50:80:10).
+ *   -w, --warmup W           Untimed runs per point (default: 1).
+ *   -r, --reps R             Timed runs per point (default: 5).
+ *   -c, --csv FILE           Write the results as CSV.
+ *   -j, --json FILE          Write the results as JSON.
+ *   -b, --baseline FILE      Compare with a CSV written by --csv.
+ *   -t, --tolerance PCT      Slowdown (in %) of the median that is
+ *                            flagged as a regression (default: 5).
+ *   -p, --perf               Also read the hardware performance
+ *                            counters (instructions, cycles, branch
+ *                            misses, L1d read misses) around each run.
+ *   -s, --scaling LIST       Instead, benchmark the accumulation of
+ *                            per-n counts by threads (as in partnid)
+ *                            with each number of threads in LIST
+ *                            (e.g. 8,16,32,64), for n = 0, ..., HI.
+ *   -P, --pin                With --scaling, pin the threads to CPUs
+ *                            (socket by socket, see topology.h).
+ *   -q, --qpow LIST          Instead, benchmark `pow_qseries` against
+ *                            repeated multiplication for each
+ *                            exponent in LIST (e.g. 1,10,100,1000).
+ *   -Q, --qbatch B           Instead, benchmark the batched q-series
+ *                            operations (see `qbatch_t`) on B series
+ *                            against the same operations one series
+ *                            at a time.
+ *   -o, --order M            Order of the series for --qpow and
+ *                            --qbatch (default: 500).
+ *   -L, --qlarge LIST        Instead, benchmark the q-series products,
+ *                            inverses and powers of each order in
+ *                            LIST (e.g. 100000,1000000,10000000) on
+ *                            one thread and on all the online CPUs.
+ *
+ *   LIST is a comma separated list of names.
+ *
+ * Each point (generator, visitor, n) is run W times untimed and then
+ * R times timed, in process, so that neither process startup nor the
+ * resolution of `time` gets into the numbers.  The median and the
+ * minimum over the R runs are reported per partition, both in
+ * nanoseconds and in time-stamp counter cycles.  With --perf, the
+ * medians of the hardware counters (see perfctr.h) are reported per
+ * partition as well.  The exit status is 1 if any point regressed
+ * against the baseline.
+ *
+ * The scaling benchmark runs the tasks n = HI, ..., 0 (merca3, as
+ * partnid does) on a pool of threads and counts the partitions of
+ * each n either "shared" (every partition increments the shared
+ * `count[n]`, as partnid used to) or "local" (a thread-local counter
+ * is added to `count[n]` at the end of the task), and reports the
+ * median wall-clock time per partition of both, and the speedup of
+ * "local" over its time with the first number of threads in LIST.
+ *
+ * The powering benchmark raises 1 - q (sparse) and the generating
+ * function of the partitions (dense) to each power k, both with
+ * `pow_qseries` and by multiplying k times (what it used to do), and
+ * reports the median times and whether the results agree.
+ *
+ * The batch benchmark runs add, scale, multiply by a sparse series
+ * (Euler's product), multiply by factors (1 - q)^(+-1) and compare
+ * (with a target series) on B series of order M, as one batch and
+ * one series at a time, and reports the throughput of both in
+ * coefficient operations (multiply-adds or comparisons) per
+ * time-stamp counter cycle, and whether the results agree.
+ *
+ * The large order benchmark multiplies two series with random 64-bit
+ * coefficients, squares one, inverts it and raises it to the 5th
+ * power, with the threads of the q-series set to 1 and to the online
+ * CPUs, and reports the median times, the speedup and whether the
+ * results agree (with each other, and with some terms summed
+ * directly).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "partition.h"
+#include "perfctr.h"
+#include "qseries.h"
+#include "topology.h"
+#include "util.h"
+
+/*******************************************************************\
+ * Types                                                           *
+\*******************************************************************/
+
+typedef enum {
+    E_SUCCESS,
+    E_REGRESSION,
+    E_INVALID_ARGS,
+    E_IO_FAILURE,
+    E_OUT_OF_MEMORY,
+} err_t;
+
+/* A visitor to benchmark the generators with. */
+typedef struct {
+    const char *name;
+    partn_visitor_f *visit;
+} bench_visitor_t;
+
+/* Result for one point (generator, visitor, n), per partition. */
+typedef struct {
+    const partn_algo_t *algo;
+    const bench_visitor_t *visitor;
+    int n;
+    uint64_t count;
+    int reps;
+    double med_ns;
+    double min_ns;
+    double med_cyc;
+    double min_cyc;
+    double ctr[PERFCTR_NUM];    /* Counter medians (-1 if unknown). */
+    double base_ns;     /* Baseline median (0 if there is none). */
+} result_t;
+
+/* Options. */
+typedef struct {
+    const partn_algo_t *algos[32];
+    size_t num_algos;
+    const bench_visitor_t *visitors[8];
+    size_t num_visitors;
+    int n_lo, n_hi, n_step;
+    int warmup;
+    int reps;
+    const char *csv;
+    const char *json;
+    const char *baseline;
+    double tolerance;
+    bool perf;
+    int threads[16];    /* Thread counts for --scaling. */
+    size_t num_threads;
+    bool pin;           /* Pin the threads of --scaling. */
+    int qpow[16];       /* Exponents for --qpow. */
+    size_t num_qpow;
+    size_t qbatch;      /* Series in a batch for --qbatch. */
+    size_t order;       /* Order of the series for --qpow, --qbatch. */
+    size_t qlarge[16];  /* Orders for --qlarge. */
+    size_t num_qlarge;
+} options_t;
+
+/*******************************************************************\
+ * Declarations                                                    *
+\*******************************************************************/
+
+static inline void usage(const char *com);
+static inline err_t parse_args(int argc, char *argv[], options_t *opt);
+
+static void visit_len(const partition_t *p, void *argres);
+static void visit_sum(const partition_t *p, void *argres);
+
+static inline void run_point(const options_t *opt, perfctr_t *pc,
+        result_t *res);
+static inline int load_baseline(const char *path, result_t res[],
+        size_t num);
+static inline void print_table(const result_t res[], size_t num,
+        double tolerance);
+static inline void print_counters(const result_t res[], size_t num);
+static inline int write_csv(const char *path, const result_t res[],
+        size_t num);
+static inline int write_json(const char *path, const result_t res[],
+        size_t num);
+static inline void run_scaling(const options_t *opt);
+static inline void run_qpow(const options_t *opt);
+static inline void run_qbatch(const options_t *opt);
+static inline void run_qlarge(const options_t *opt);
+
+static const bench_visitor_t bench_visitors[] = {
+    {"none", NULL},
+    {"len",  visit_len},
+    {"sum",  visit_sum},
+};
+
+#define NUM_VISITORS (sizeof(bench_visitors) / sizeof(bench_visitors[0]))
+
+/* Keeps the visitors' work observable. */
+static volatile uint64_t sink;
+
+/*******************************************************************\
+ * Main                                                            *
+\*******************************************************************/
+
+int main(int argc, char *argv[])
+{
+    options_t opt;
+    perfctr_t pc;
+    result_t *res;
+    size_t num = 0;
+    err_t err;
+
+    if ((err = parse_args(argc, argv, &opt))) {
+        usage(argv[0]);
+        return err;
+    }
+    if (opt.num_threads) {
+        run_scaling(&opt);
+        return E_SUCCESS;
+    }
+    if (opt.num_qpow) {
+        run_qpow(&opt);
+        return E_SUCCESS;
+    }
+    if (opt.qbatch) {
+        run_qbatch(&opt);
+        return E_SUCCESS;
+    }
+    if (opt.num_qlarge) {
+        run_qlarge(&opt);
+        return E_SUCCESS;
+    }
+    if (opt.perf && perfctr_open(&pc) < PERFCTR_NUM) {
+        fprintf(stderr, "[WARN] Some performance counters are not ");
+        fprintf(stderr, "available:");
+        for (int ev = 0; ev < PERFCTR_NUM; ev++)
+            if (! perfctr_available(&pc, ev))
+                fprintf(stderr, " %s", perfctr_names[ev]);
+        fprintf(stderr, "\n");
+    }
+    res = calloc(opt.num_algos * opt.num_visitors *
+            ((opt.n_hi - opt.n_lo) / opt.n_step + 1), sizeof(result_t));
+    if (res == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        return E_OUT_OF_MEMORY;
+    }
+
+    /* Interleave the generators so that they see the same drift. */
+    for (int n = opt.n_lo; n <= opt.n_hi; n += opt.n_step) {
+        for (size_t v = 0; v < opt.num_visitors; v++) {
+            for (size_t a = 0; a < opt.num_algos; a++) {
+                res[num].algo = opt.algos[a];
+                res[num].visitor = opt.visitors[v];
+                res[num].n = n;
+                run_point(&opt, opt.perf ? &pc : NULL, &res[num]);
+                num++;
+            }
+        }
+    }
+
+    if (opt.baseline && load_baseline(opt.baseline, res, num))
+        fprintf(stderr, "[WARN] Cannot read baseline %s (skipped).\n",
+                opt.baseline);
+    print_table(res, num, opt.tolerance);
+    if (opt.perf) {
+        print_counters(res, num);
+        perfctr_close(&pc);
+    }
+    if (opt.csv && write_csv(opt.csv, res, num)) {
+        fprintf(stderr, "[ERR] Cannot write %s!\n", opt.csv);
+        return E_IO_FAILURE;
+    }
+    if (opt.json && write_json(opt.json, res, num)) {
+        fprintf(stderr, "[ERR] Cannot write %s!\n", opt.json);
+        return E_IO_FAILURE;
+    }
+
+    err = E_SUCCESS;
+    for (size_t i = 0; i < num; i++)
+        if (res[i].base_ns > 0 &&
+                res[i].med_ns > res[i].base_ns * (1 + opt.tolerance/100))
+            err = E_REGRESSION;
+    free(res);
+    return err;
+}
+
+static inline void usage(const char *com)
+{
+    fprintf(stderr, "Benchmark the partition generators.\n\n");
+    fprintf(stderr, "Usage: %s [OPTIONS]\n\n", com);
+    fprintf(stderr, "  -a, --algos LIST\tGenerators to run ");
+    fprintf(stderr, "(default: all).\n");
+    fprintf(stderr, "  -V, --visitors LIST\tVisitors to run: none, ");
+    fprintf(stderr, "len, sum (default: none,sum).\n");
+    fprintf(stderr, "  -n, --sweep LO[:HI[:STEP]]\n");
+    fprintf(stderr, "\t\t\tValues of n (default: 50:80:10).\n");
+    fprintf(stderr, "  -w, --warmup W\t");
+    fprintf(stderr, "Untimed runs per point (default: 1).\n");
+    fprintf(stderr, "  -r, --reps R\t\t");
+    fprintf(stderr, "Timed runs per point (default: 5).\n");
+    fprintf(stderr, "  -c, --csv FILE\tWrite the results as CSV.\n");
+    fprintf(stderr, "  -j, --json FILE\tWrite the results as JSON.\n");
+    fprintf(stderr, "  -b, --baseline FILE\tCompare with a CSV ");
+    fprintf(stderr, "written by --csv.\n");
+    fprintf(stderr, "  -t, --tolerance PCT\tSlowdown flagged as a ");
+    fprintf(stderr, "regression (default: 5).\n");
+    fprintf(stderr, "  -p, --perf\t\tAlso read the hardware ");
+    fprintf(stderr, "performance counters.\n");
+    fprintf(stderr, "  -s, --scaling LIST\tInstead, benchmark the ");
+    fprintf(stderr, "per-n accumulation of partnid\n\t\t\twith ");
+    fprintf(stderr, "these numbers of threads (e.g. 8,16,32,64).\n");
+    fprintf(stderr, "  -P, --pin\t\tWith --scaling, pin the threads ");
+    fprintf(stderr, "to CPUs.\n");
+    fprintf(stderr, "  -q, --qpow LIST\tInstead, benchmark pow_qseries ");
+    fprintf(stderr, "with these\n\t\t\texponents (e.g. 1,10,100,1000).\n");
+    fprintf(stderr, "  -Q, --qbatch B\tInstead, benchmark the batched ");
+    fprintf(stderr, "q-series\n\t\t\toperations on B series.\n");
+    fprintf(stderr, "  -o, --order M\t\tOrder of the series for ");
+    fprintf(stderr, "--qpow, --qbatch\n\t\t\t(default: 500).\n");
+    fprintf(stderr, "  -L, --qlarge LIST\tInstead, benchmark the ");
+    fprintf(stderr, "q-series products of\n\t\t\tthese orders (e.g. ");
+    fprintf(stderr, "100000,1000000,10000000).\n");
+}
+
+static inline err_t parse_args(int argc, char *argv[], options_t *opt)
+{
+    static const struct option longopts[] = {
+        {"algos",     required_argument, NULL, 'a'},
+        {"visitors",  required_argument, NULL, 'V'},
+        {"sweep",     required_argument, NULL, 'n'},
+        {"warmup",    required_argument, NULL, 'w'},
+        {"reps",      required_argument, NULL, 'r'},
+        {"csv",       required_argument, NULL, 'c'},
+        {"json",      required_argument, NULL, 'j'},
+        {"baseline",  required_argument, NULL, 'b'},
+        {"tolerance", required_argument, NULL, 't'},
+        {"perf",      no_argument,       NULL, 'p'},
+        {"scaling",   required_argument, NULL, 's'},
+        {"pin",       no_argument,       NULL, 'P'},
+        {"qpow",      required_argument, NULL, 'q'},
+        {"qbatch",    required_argument, NULL, 'Q'},
+        {"order",     required_argument, NULL, 'o'},
+        {"qlarge",    required_argument, NULL, 'L'},
+        {"help",      no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    const char *algos = NULL;
+    const char *visitors = "none,sum";
+    char *list, *tok, *saveptr;
+    int c;
+
+    memset(opt, 0, sizeof(*opt));
+    opt->n_lo = 50;
+    opt->n_hi = 80;
+    opt->n_step = 10;
+    opt->warmup = 1;
+    opt->reps = 5;
+    opt->tolerance = 5;
+    opt->order = 500;
+
+    while ((c = getopt_long(argc, argv, "a:V:n:w:r:c:j:b:t:ps:Pq:Q:o:L:h",
+                    longopts, NULL)) != -1) {
+        switch (c) {
+            case 'a':
+                algos = optarg;
+                break;
+            case 'V':
+                visitors = optarg;
+                break;
+            case 'n':
+                c = sscanf(optarg, "%d:%d:%d",
+                        &opt->n_lo, &opt->n_hi, &opt->n_step);
+                if (c < 1)
+                    return E_INVALID_ARGS;
+                if (c < 2)
+                    opt->n_hi = opt->n_lo;
+                if (c < 3)
+                    opt->n_step = 10;
+                break;
+            case 'w':
+                opt->warmup = atoi(optarg);
+                break;
+            case 'r':
+                opt->reps = atoi(optarg);
+                break;
+            case 'c':
+                opt->csv = optarg;
+                break;
+            case 'j':
+                opt->json = optarg;
+                break;
+            case 'b':
+                opt->baseline = optarg;
+                break;
+            case 't':
+                opt->tolerance = atof(optarg);
+                break;
+            case 'p':
+                opt->perf = true;
+                break;
+            case 'P':
+                opt->pin = true;
+                break;
+            case 's':
+                list = strdup(optarg);
+                for (tok = strtok_r(list, ",", &saveptr); tok;
+                        tok = strtok_r(NULL, ",", &saveptr)) {
+                    if (opt->num_threads == 16 || atoi(tok) < 1) {
+                        fprintf(stderr, "[Error] Invalid threads: %s\n",
+                                tok);
+                        free(list);
+                        return E_INVALID_ARGS;
+                    }
+                    opt->threads[opt->num_threads++] = atoi(tok);
+                }
+                free(list);
+                break;
+            case 'q':
+                list = strdup(optarg);
+                for (tok = strtok_r(list, ",", &saveptr); tok;
+                        tok = strtok_r(NULL, ",", &saveptr)) {
+                    if (opt->num_qpow == 16) {
+                        fprintf(stderr, "[Error] Too many exponents.\n");
+                        free(list);
+                        return E_INVALID_ARGS;
+                    }
+                    opt->qpow[opt->num_qpow++] = atoi(tok);
+                }
+                free(list);
+                break;
+            case 'Q':
+                opt->qbatch = strtoul(optarg, NULL, 10);
+                if (opt->qbatch < 1)
+                    return E_INVALID_ARGS;
+                break;
+            case 'o':
+                opt->order = strtoul(optarg, NULL, 10);
+                break;
+            case 'L':
+                list = strdup(optarg);
+                for (tok = strtok_r(list, ",", &saveptr); tok;
+                        tok = strtok_r(NULL, ",", &saveptr)) {
+                    if (opt->num_qlarge == 16 || atol(tok) < 1) {
+                        fprintf(stderr, "[Error] Invalid order: %s\n",
+                                tok);
+                        free(list);
+                        return E_INVALID_ARGS;
+                    }
+                    opt->qlarge[opt->num_qlarge++] = atol(tok);
+                }
+                free(list);
+                break;
+            default:
+                return E_INVALID_ARGS;
+        }
+    }
+    if (optind != argc || opt->n_lo < 0 || opt->n_hi < opt->n_lo ||
+            opt->n_step < 1 || opt->warmup < 0 || opt->reps < 1 ||
+            opt->order < 1) {
+        fprintf(stderr, "[Error] Invalid arguments.\n");
+        return E_INVALID_ARGS;
+    }
+
+    if (algos == NULL) {
+        for (size_t i = 0; i < num_partn_algos; i++)
+            opt->algos[opt->num_algos++] = &partn_algos[i];
+    } else {
+        list = strdup(algos);
+        for (tok = strtok_r(list, ",", &saveptr); tok;
+                tok = strtok_r(NULL, ",", &saveptr)) {
+            if (opt->num_algos == 32 ||
+                    ! (opt->algos[opt->num_algos] = find_partn_algo(tok))) {
+                fprintf(stderr, "[Error] Invalid algorithm: %s\n", tok);
+                free(list);
+                return E_INVALID_ARGS;
+            }
+            opt->num_algos++;
+        }
+        free(list);
+    }
+
+    list = strdup(visitors);
+    for (tok = strtok_r(list, ",", &saveptr); tok;
+            tok = strtok_r(NULL, ",", &saveptr)) {
+        size_t v;
+        for (v = 0; v < NUM_VISITORS; v++)
+            if (strcmp(bench_visitors[v].name, tok) == 0)
+                break;
+        if (v == NUM_VISITORS || opt->num_visitors == 8) {
+            fprintf(stderr, "[Error] Invalid visitor: %s\n", tok);
+            free(list);
+            return E_INVALID_ARGS;
+        }
+        opt->visitors[opt->num_visitors++] = &bench_visitors[v];
+    }
+    free(list);
+    if (opt->num_algos == 0 || opt->num_visitors == 0)
+        return E_INVALID_ARGS;
+    return E_SUCCESS;
+}
+
+/*******************************************************************\
+ * Visitors                                                        *
+\*******************************************************************/
+
+/* Accumulate the number of parts (constant work per partition). */
+static void visit_len(const partition_t *p, void *argres)
+{
+    *((uint64_t *) argres) += p->len;
+}
+
+/* Accumulate the sum of the parts (reads every part). */
+static void visit_sum(const partition_t *p, void *argres)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < p->len; i++)
+        sum += p->a[i];
+    *((uint64_t *) argres) += sum;
+}
+
+/*******************************************************************\
+ * Measurement                                                     *
+\*******************************************************************/
+
+static int cmp_uint64(const void *x, const void *y)
+{
+    uint64_t a = *((const uint64_t *) x);
+    uint64_t b = *((const uint64_t *) y);
+    return (a > b) - (a < b);
+}
+
+/* Median of `num` values (sorts `a`). */
+static inline double median_uint64(size_t num, uint64_t a[num])
+{
+    qsort(a, num, sizeof(uint64_t), cmp_uint64);
+    if (num % 2)
+        return a[num / 2];
+    return (a[num/2 - 1] + a[num/2]) / 2.0;
+}
+
+/*
+ * Run one point, reading the counters `pc` around each timed run
+ * (unless `pc` is NULL).
+ */
+static inline void run_point(const options_t *opt, perfctr_t *pc,
+        result_t *res)
+{
+    partn_generator_f *gen = res->algo->gen;
+    partn_visitor_f *visit = res->visitor->visit;
+    uint64_t ns[opt->reps], cyc[opt->reps];
+    uint64_t ctr[PERFCTR_NUM][opt->reps], val[PERFCTR_NUM];
+    uint64_t t0, c0, acc = 0;
+    int *buf;
+
+    if ((buf = malloc(PARTN_BUFLEN(res->n) * sizeof(int))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    for (int i = 0; i < opt->warmup; i++)
+        gen(res->n, buf, visit, &acc);
+    for (int i = 0; i < opt->reps; i++) {
+        if (pc)
+            perfctr_start(pc);
+        t0 = nanotime();
+        c0 = cpucycles();
+        res->count = gen(res->n, buf, visit, &acc);
+        cyc[i] = cpucycles() - c0;
+        ns[i] = nanotime() - t0;
+        if (pc) {
+            perfctr_stop(pc, val);
+            for (int ev = 0; ev < PERFCTR_NUM; ev++)
+                ctr[ev][i] = val[ev];
+        }
+    }
+    sink += acc;
+    free(buf);
+
+    res->reps = opt->reps;
+    res->med_ns = median_uint64(opt->reps, ns) / res->count;
+    res->min_ns = (double) ns[0] / res->count;
+    res->med_cyc = median_uint64(opt->reps, cyc) / res->count;
+    res->min_cyc = (double) cyc[0] / res->count;
+    for (int ev = 0; ev < PERFCTR_NUM; ev++)
+        res->ctr[ev] = (pc && perfctr_available(pc, ev)) ?
+            median_uint64(opt->reps, ctr[ev]) / res->count : -1;
+    res->base_ns = 0;
+}
+
+/*******************************************************************\
+ * Accumulation Scaling                                            *
+\*******************************************************************/
+
+/* How the tasks accumulate their counts. */
+typedef enum {
+    ACC_SHARED,     /* Increment count[n] for every partition. */
+    ACC_LOCAL,      /* Count locally, add to count[n] once per task. */
+} acc_mode_t;
+
+static const char *acc_mode_names[] = {"shared", "local"};
+
+/* Work shared by the threads (the task counter on its own line). */
+typedef struct {
+    int next;
+    char pad[CACHE_LINE - sizeof(int)];
+    acc_mode_t mode;
+    int N;
+    int64_t *count;
+    const topology_t *topo;     /* Pin the threads (NULL: do not). */
+} __attribute__((aligned(CACHE_LINE))) scaling_job_t;
+
+static void visit_count(const partition_t *p, void *argres)
+{
+    (*(int64_t *) argres)++;
+}
+
+static void *scaling_thread(void *arg)
+{
+    scaling_job_t *job = arg;
+    int64_t local;
+    int *buf;
+    int n;
+
+    if ((buf = malloc(PARTN_BUFLEN(job->N) * sizeof(int))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    while ((n = __sync_fetch_and_sub(&job->next, 1)) >= 0) {
+        if (job->mode == ACC_SHARED) {
+            merca3(n, buf, visit_count, &job->count[n]);
+        } else {
+            local = 0;
+            merca3(n, buf, visit_count, &local);
+            __sync_fetch_and_add(&job->count[n], local);
+        }
+    }
+    free(buf);
+    return NULL;
+}
+
+/* Wall-clock time (ns) of one run of all the tasks; total in *total. */
+static inline uint64_t scaling_run(scaling_job_t *job, int threads,
+        uint64_t *total)
+{
+    pthread_t tid[threads];
+    uint64_t t0;
+
+    job->next = job->N;
+    memset(job->count, 0, (job->N + 1) * sizeof(int64_t));
+    t0 = nanotime();
+    for (int t = 0; t < threads; t++) {
+        if (pthread_create(&tid[t], NULL, scaling_thread, job)) {
+            fprintf(stderr, "[ERR] Failed to create thread!\n");
+            exit(E_OUT_OF_MEMORY);
+        }
+        if (job->topo)
+            pin_thread(tid[t],
+                    job->topo->cpus[t % job->topo->num_cpus].cpu);
+    }
+    for (int t = 0; t < threads; t++)
+        pthread_join(tid[t], NULL);
+    t0 = nanotime() - t0;
+    *total = 0;
+    for (int n = 0; n <= job->N; n++)
+        *total += job->count[n];
+    return t0;
+}
+
+static inline void run_scaling(const options_t *opt)
+{
+    scaling_job_t job;
+    topology_t topo = {0, NULL, 0};
+    double med[2], first = 0;
+    uint64_t ns[opt->reps], total = 0, check;
+
+    job.N = opt->n_hi;
+    job.topo = NULL;
+    if (opt->pin) {
+        if (read_topology(&topo)) {
+            fprintf(stderr, "[ERR] Out of memory!\n");
+            exit(E_OUT_OF_MEMORY);
+        }
+        job.topo = &topo;
+    }
+    if ((job.count = aligned_alloc(CACHE_LINE, ((job.N + 1) *
+                        sizeof(int64_t) + CACHE_LINE - 1) / CACHE_LINE
+                    * CACHE_LINE)) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    printf("Tasks n = %d, ..., 0 (merca3), median of %d runs", job.N,
+            opt->reps);
+    if (opt->pin)
+        printf(", pinned (%zu CPUs on %d sockets)", topo.num_cpus,
+                topo.num_sockets);
+    else
+        printf(" (%d CPUs)", online_cpus());
+    printf(":\n\n");
+    printf("  %7s %12s %12s %9s %9s\n", "threads", "shared ns/p",
+            "local ns/p", "speedup", "scaling");
+    for (int i = 0; i < 54; i++)
+        printf("=");
+    printf("\n");
+    for (size_t t = 0; t < opt->num_threads; t++) {
+        for (int mode = ACC_SHARED; mode <= ACC_LOCAL; mode++) {
+            job.mode = mode;
+            for (int i = 0; i < opt->warmup; i++)
+                scaling_run(&job, opt->threads[t], &total);
+            for (int i = 0; i < opt->reps; i++) {
+                ns[i] = scaling_run(&job, opt->threads[t], &check);
+                if (check != total) {
+                    fprintf(stderr, "[ERR] %s: wrong count!\n",
+                            acc_mode_names[mode]);
+                    exit(E_REGRESSION);
+                }
+            }
+            med[mode] = median_uint64(opt->reps, ns) / total;
+        }
+        if (t == 0)
+            first = med[ACC_LOCAL];
+        printf("  %7d %12.3f %12.3f %8.2fx %8.2fx\n", opt->threads[t],
+                med[ACC_SHARED], med[ACC_LOCAL],
+                med[ACC_SHARED] / med[ACC_LOCAL], first / med[ACC_LOCAL]);
+    }
+    free(job.count);
+    free_topology(&topo);
+}
+
+/*******************************************************************\
+ * Powering                                                        *
+\*******************************************************************/
+
+/* `s`^k (k >= 0) by multiplying k times: the old `pow_qseries`. */
+static void pow_by_multiplication(const qseries_t *s, int k,
+        qseries_t *tmp, qseries_t *ans)
+{
+    init_qseries(ans, 0);
+    ans->c[0] = 1;
+    for (int i = 0; i < k; i++) {
+        cp_qseries(ans, tmp);
+        multiply_qseries(tmp, s, ans);
+    }
+}
+
+static inline void run_qpow(const options_t *opt)
+{
+    static const char *names[] = {"1-q", "1/(q;q)"};
+    qseries_t s[2], old, new, tmp;
+    uint64_t ns[2][opt->reps], t0;
+    size_t ord = opt->order;
+
+    if (alloc_qseries(&s[0], ord) || alloc_qseries(&s[1], ord) ||
+            alloc_qseries(&old, ord) || alloc_qseries(&new, ord) ||
+            alloc_qseries(&tmp, ord)) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    s[0].c[0] = 1;
+    if (ord > 1)
+        s[0].c[1] = -1;
+    pow_qseries(&s[0], 0, &tmp);
+    for (size_t n = 1; n < ord; n++)
+        for (size_t deg = n; deg < ord; deg++)
+            tmp.c[deg] += tmp.c[deg - n];
+    cp_qseries(&tmp, &s[1]);
+
+    printf("Order %zu, median of %d runs:\n\n", ord, opt->reps);
+    printf("  %-8s %5s %12s %12s %9s %6s\n", "series", "k", "mult ms",
+            "pow ms", "speedup", "agree");
+    for (int i = 0; i < 58; i++)
+        printf("=");
+    printf("\n");
+    for (int j = 0; j < 2; j++) {
+        for (size_t i = 0; i < opt->num_qpow; i++) {
+            int k = opt->qpow[i];
+            double med[2];
+            if (k < 0)
+                continue;
+            for (int w = 0; w < opt->warmup; w++) {
+                pow_by_multiplication(&s[j], k, &tmp, &old);
+                pow_qseries(&s[j], k, &new);
+            }
+            for (int r = 0; r < opt->reps; r++) {
+                t0 = nanotime();
+                pow_by_multiplication(&s[j], k, &tmp, &old);
+                ns[0][r] = nanotime() - t0;
+                t0 = nanotime();
+                pow_qseries(&s[j], k, &new);
+                ns[1][r] = nanotime() - t0;
+            }
+            med[0] = median_uint64(opt->reps, ns[0]) / 1e6;
+            med[1] = median_uint64(opt->reps, ns[1]) / 1e6;
+            printf("  %-8s %5d %12.3f %12.3f %8.1fx %6s\n", names[j], k,
+                    med[0], med[1], med[0] / med[1],
+                    memcmp(old.c, new.c, ord * sizeof(int64_t)) ?
+                    "NO" : "yes");
+        }
+    }
+    free_qseries(&s[0]);
+    free_qseries(&s[1]);
+    free_qseries(&old);
+    free_qseries(&new);
+    free_qseries(&tmp);
+}
+
+/*******************************************************************\
+ * Batched Series                                                  *
+\*******************************************************************/
+
+/* The operations of the batch benchmark. */
+typedef enum {
+    QB_ADD,
+    QB_SCALE,
+    QB_SPARSE,
+    QB_FACTORS,
+    QB_COMPARE,
+    QB_NUM,
+} qbatch_op_t;
+
+static const char *qbatch_op_names[QB_NUM] = {
+    "add", "scale", "sparse", "factors", "compare",
+};
+
+/* Operands of the batch benchmark, as a batch and one by one. */
+typedef struct {
+    size_t num;
+    qbatch_t s, t, ans;
+    qseries_t *x, *y, *z;
+    qseries_t target;
+    sparse_qseries_t e;     /* Euler's product. */
+    int *k;                 /* Exponents of the factors (+-1). */
+    size_t *first[2];
+} qbatch_job_t;
+
+/* Run the operation `op` on the batch, or on the series one by one. */
+static void qbatch_run(qbatch_job_t *job, qbatch_op_t op, bool batched)
+{
+    size_t B = job->num;
+
+    switch (op) {
+        case QB_ADD:
+            if (batched)
+                add_qbatch(&job->s, &job->t, &job->ans);
+            else
+                for (size_t b = 0; b < B; b++)
+                    add_qseries(&job->x[b], &job->y[b], &job->z[b]);
+            break;
+        case QB_SCALE:
+            if (batched)
+                scale_qbatch(3, &job->s, &job->ans);
+            else
+                for (size_t b = 0; b < B; b++)
+                    scale_qseries(3, &job->x[b], &job->z[b]);
+            break;
+        case QB_SPARSE:
+            if (batched)
+                multiply_sparse_qbatch(&job->e, &job->s, &job->ans);
+            else
+                for (size_t b = 0; b < B; b++)
+                    multiply_sparse_qseries(&job->e, &job->x[b],
+                            &job->z[b]);
+            break;
+        case QB_FACTORS:
+            /* In place: each run multiplies the results further. */
+            if (batched)
+                multiply_factors_qbatch(&job->ans, 1, job->k);
+            else
+                for (size_t b = 0; b < B; b++)
+                    multiply_factor_inplace_qseries(&job->z[b], 1, 1,
+                            job->k[b]);
+            break;
+        case QB_COMPARE:
+            if (batched) {
+                compare_qbatch(&job->s, &job->target, job->first[1]);
+            } else {
+                for (size_t b = 0; b < B; b++) {
+                    size_t deg = 0;
+                    while (deg < job->x[b].ord &&
+                            job->x[b].c[deg] == job->target.c[deg])
+                        deg++;
+                    job->first[0][b] = deg;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/* Coefficient operations of one run of `op`. */
+static inline double qbatch_ops(const qbatch_job_t *job, qbatch_op_t op)
+{
+    size_t ord = job->s.ord, terms = 0;
+
+    if (op == QB_SPARSE) {
+        for (size_t deg = 0; deg < ord; deg++)
+            for (size_t i = 0; i < job->e.num && job->e.deg[i] <= deg; i++)
+                terms++;
+        return (double) terms * job->num;
+    }
+    if (op == QB_FACTORS)
+        return (double) (ord - 1) * job->num;
+    if (op == QB_COMPARE) {
+        /* Up to the first difference (the one-by-one loop stops). */
+        for (size_t b = 0; b < job->num; b++)
+            terms += (job->first[0][b] < ord) ? job->first[0][b] + 1 : ord;
+        return terms;
+    }
+    return (double) ord * job->num;
+}
+
+/* Do the results of the batch and of the series one by one agree? */
+static inline bool qbatch_agree(const qbatch_job_t *job, qbatch_op_t op)
+{
+    for (size_t b = 0; b < job->num; b++) {
+        if (op == QB_COMPARE) {
+            if (job->first[0][b] != job->first[1][b])
+                return false;
+            continue;
+        }
+        for (size_t deg = 0; deg < job->ans.ord; deg++)
+            if (job->ans.c[deg * job->num + b] != job->z[b].c[deg])
+                return false;
+    }
+    return true;
+}
+
+static inline void run_qbatch(const options_t *opt)
+{
+    qbatch_job_t job;
+    size_t B = opt->qbatch, ord = opt->order;
+    uint64_t cyc[2][opt->reps], c0, rnd = 88172645463325252ULL;
+    bool ok = true;
+
+    memset(&job, 0, sizeof(job));
+    job.num = B;
+    job.x = calloc(B, sizeof(qseries_t));
+    job.y = calloc(B, sizeof(qseries_t));
+    job.z = calloc(B, sizeof(qseries_t));
+    job.k = malloc(B * sizeof(int));
+    job.first[0] = malloc(B * sizeof(size_t));
+    job.first[1] = malloc(B * sizeof(size_t));
+    ok = job.x && job.y && job.z && job.k && job.first[0] &&
+        job.first[1] && alloc_qbatch(B, ord, &job.s) == 0 &&
+        alloc_qbatch(B, ord, &job.t) == 0 &&
+        alloc_qbatch(B, ord, &job.ans) == 0 &&
+        alloc_qseries(&job.target, ord) == 0 &&
+        euler_sparse(1, ord, &job.e) == 0;
+    for (size_t b = 0; ok && b < B; b++)
+        ok = alloc_qseries(&job.x[b], ord) == 0 &&
+            alloc_qseries(&job.y[b], ord) == 0 &&
+            alloc_qseries(&job.z[b], ord) == 0;
+    if (! ok) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    /*
+     * Small random coefficients (xorshift); as in screening, most
+     * series differ from the target early, and one in 16 not at all.
+     */
+    for (size_t deg = 0; deg < ord; deg++)
+        job.target.c[deg] = deg % 7;
+    for (size_t b = 0; b < B; b++) {
+        for (size_t deg = 0; deg < ord; deg++) {
+            rnd ^= rnd << 13;
+            rnd ^= rnd >> 7;
+            rnd ^= rnd << 17;
+            job.x[b].c[deg] = (b % 16 == 0 || deg < b % 5) ?
+                job.target.c[deg] :
+                (int64_t) (rnd % 19) - 9;
+            job.y[b].c[deg] = (int64_t) (rnd >> 32) % 5;
+        }
+        set_qbatch(&job.s, b, &job.x[b]);
+        set_qbatch(&job.t, b, &job.y[b]);
+        job.k[b] = (b % 2) ? 1 : -1;
+    }
+
+    printf("Order %zu, %zu series, median of %d runs:\n\n", ord, B,
+            opt->reps);
+    printf("  %-8s %14s %14s %9s %6s\n", "op", "one ops/cyc",
+            "batch ops/cyc", "speedup", "agree");
+    for (int i = 0; i < 57; i++)
+        printf("=");
+    printf("\n");
+    for (int op = 0; op < QB_NUM; op++) {
+        double ops, med[2];
+        for (int w = 0; w < opt->warmup; w++) {
+            qbatch_run(&job, op, false);
+            qbatch_run(&job, op, true);
+        }
+        for (int r = 0; r < opt->reps; r++) {
+            for (int batched = 0; batched < 2; batched++) {
+                c0 = cpucycles();
+                qbatch_run(&job, op, batched);
+                cyc[batched][r] = cpucycles() - c0;
+            }
+        }
+        ops = qbatch_ops(&job, op);
+        med[0] = median_uint64(opt->reps, cyc[0]);
+        med[1] = median_uint64(opt->reps, cyc[1]);
+        printf("  %-8s %14.3f %14.3f %8.1fx %6s\n", qbatch_op_names[op],
+                ops / med[0], ops / med[1], med[0] / med[1],
+                qbatch_agree(&job, op) ? "yes" : "NO");
+    }
+    for (size_t b = 0; b < B; b++) {
+        free_qseries(&job.x[b]);
+        free_qseries(&job.y[b]);
+        free_qseries(&job.z[b]);
+    }
+    free(job.x);
+    free(job.y);
+    free(job.z);
+    free(job.k);
+    free(job.first[0]);
+    free(job.first[1]);
+    free_qbatch(&job.s);
+    free_qbatch(&job.t);
+    free_qbatch(&job.ans);
+    free_qseries(&job.target);
+    free_sparse_qseries(&job.e);
+}
+
+/*******************************************************************\
+ * Large Orders                                                    *
+\*******************************************************************/
+
+/* The operations of the large order benchmark. */
+typedef enum {
+    QL_MULTIPLY,
+    QL_SQUARE,
+    QL_INVERT,
+    QL_POW,
+    QL_NUM,
+} qlarge_op_t;
+
+static const char *qlarge_op_names[QL_NUM] = {
+    "multiply", "square", "invert", "pow 5",
+};
+
+static inline void qlarge_run(qlarge_op_t op, const qseries_t *s,
+        const qseries_t *t, qseries_t *ans)
+{
+    switch (op) {
+        case QL_MULTIPLY:
+            multiply_qseries(s, t, ans);
+            break;
+        case QL_SQUARE:
+            multiply_qseries(s, s, ans);
+            break;
+        case QL_INVERT:
+            invert_qseries(s, ans);
+            break;
+        default:
+            pow_qseries(s, 5, ans);
+            break;
+    }
+}
+
+/*
+ * Check the terms of q^0, q^(ord/3) and q^(ord-1) of the result `ans`
+ * of `op`, each summed directly in O(ord) (not the powers).
+ */
+static inline bool qlarge_check(qlarge_op_t op, const qseries_t *s,
+        const qseries_t *t, const qseries_t *ans)
+{
+    size_t ord = ans->ord, degs[3] = {0, ord / 3, ord - 1};
+    const int64_t *a = op == QL_INVERT ? ans->c : s->c;
+    const int64_t *b = op == QL_MULTIPLY ? t->c : s->c;
+
+    if (op == QL_POW)
+        return true;
+    for (int i = 0; i < 3; i++) {
+        size_t deg = degs[i];
+        uint64_t sum = 0;
+        for (size_t k = 0; k <= deg; k++)
+            sum += (uint64_t) a[k] * b[deg - k];
+        /* For the inverse, s * ans = 1. */
+        if ((int64_t) sum != (op == QL_INVERT ? (deg == 0) : ans->c[deg]))
+            return false;
+    }
+    return true;
+}
+
+static inline void run_qlarge(const options_t *opt)
+{
+    uint64_t ns[opt->reps], t0, rnd = 88172645463325252ULL;
+    int T = online_cpus();
+    char label[32];
+
+    snprintf(label, sizeof(label), "%d threads ms", T);
+    printf("Median of %d runs:\n\n", opt->reps);
+    printf("  %9s %-8s %12s %14s %8s %6s\n", "order", "op",
+            "1 thread ms", label, "speedup", "agree");
+    for (int i = 0; i < 64; i++)
+        printf("=");
+    printf("\n");
+    for (size_t o = 0; o < opt->num_qlarge; o++) {
+        size_t ord = opt->qlarge[o];
+        qseries_t s, t, ans[2];
+        if (alloc_qseries(&s, ord) || alloc_qseries(&t, ord) ||
+                alloc_qseries(&ans[0], ord) ||
+                alloc_qseries(&ans[1], ord)) {
+            fprintf(stderr, "[ERR] Out of memory!\n");
+            exit(E_OUT_OF_MEMORY);
+        }
+        /* Random coefficients (xorshift), constant terms 1. */
+        for (size_t deg = 0; deg < ord; deg++) {
+            rnd ^= rnd << 13;
+            rnd ^= rnd >> 7;
+            rnd ^= rnd << 17;
+            s.c[deg] = rnd;
+            t.c[deg] = rnd * 0x9e3779b97f4a7c15ULL;
+        }
+        s.c[0] = t.c[0] = 1;
+        for (qlarge_op_t op = 0; op < QL_NUM; op++) {
+            double med[2];
+            for (int i = 0; i < 2; i++) {
+                set_qseries_threads(i ? T : 1);
+                for (int w = 0; w < opt->warmup; w++)
+                    qlarge_run(op, &s, &t, &ans[i]);
+                for (int r = 0; r < opt->reps; r++) {
+                    t0 = nanotime();
+                    qlarge_run(op, &s, &t, &ans[i]);
+                    ns[r] = nanotime() - t0;
+                }
+                med[i] = median_uint64(opt->reps, ns) / 1e6;
+            }
+            printf("  %9zu %-8s %12.1f %14.1f %7.1fx %6s\n", ord,
+                    qlarge_op_names[op], med[0], med[1], med[0] / med[1],
+                    ! memcmp(ans[0].c, ans[1].c, ord * sizeof(int64_t)) &&
+                    qlarge_check(op, &s, &t, &ans[1]) ? "yes" : "NO");
+            fflush(stdout);
+        }
+        free_qseries(&s);
+        free_qseries(&t);
+        free_qseries(&ans[0]);
+        free_qseries(&ans[1]);
+    }
+    set_qseries_threads(0);
+}
+
+/*******************************************************************\
+ * Output                                                          *
+\*******************************************************************/
+
+#define CSV_HEADER "algorithm,visitor,n,partitions,reps,"    \
+    "median_ns,min_ns,median_cycles,min_cycles,"                \
+    "instructions,cycles_hw,branch_misses,l1d_misses"
+
+/*
+ * Read the medians of a CSV file written by `write_csv` into the
+ * `base_ns` of the matching results.  Returns -1 if the file cannot
+ * be read.
+ */
+static inline int load_baseline(const char *path, result_t res[],
+        size_t num)
+{
+    char line[512], algo[64], visitor[64];
+    uint64_t count;
+    double med_ns;
+    int n;
+    FILE *fp;
+
+    if ((fp = fopen(path, "r")) == NULL)
+        return -1;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "%63[^,],%63[^,],%d,%" SCNu64 ",%*d,%lf",
+                    algo, visitor, &n, &count, &med_ns) != 5)
+            continue;
+        for (size_t i = 0; i < num; i++)
+            if (res[i].n == n && res[i].count == count &&
+                    strcmp(res[i].algo->name, algo) == 0 &&
+                    strcmp(res[i].visitor->name, visitor) == 0)
+                res[i].base_ns = med_ns;
+    }
+    fclose(fp);
+    return 0;
+}
+
+static inline void print_table(const result_t res[], size_t num,
+        double tolerance)
+{
+    int regressions = 0;
+    double ratio;
+
+    printf("%-11s %-7s %4s %12s %9s %9s %9s %9s %9s\n",
+           "algorithm", "visitor", "n", "partitions",
+           "med ns/p", "min ns/p", "med cyc/p", "min cyc/p", "vs base");
+    for (int i = 0; i < 87; i++)
+        printf("=");
+    printf("\n");
+    for (size_t i = 0; i < num; i++) {
+        printf("%-11s %-7s %4d %12" PRIu64 " %9.3f %9.3f %9.2f %9.2f",
+               res[i].algo->name, res[i].visitor->name, res[i].n,
+               res[i].count, res[i].med_ns, res[i].min_ns,
+               res[i].med_cyc, res[i].min_cyc);
+        if (res[i].base_ns > 0) {
+            ratio = res[i].med_ns / res[i].base_ns;
+            printf(" %+8.1f%%", (ratio - 1) * 100);
+            if (ratio > 1 + tolerance/100) {
+                printf(" **");
+                regressions++;
+            }
+        }
+        printf("\n");
+    }
+    if (regressions)
+        printf("\n%d regression(s) beyond %.1f%%.\n",
+               regressions, tolerance);
+}
+
+/* Print a counter median in a column of width `w` (n/a if unknown). */
+static inline void print_ctr(int w, int prec, double x)
+{
+    if (x < 0)
+        printf(" %*s", w, "n/a");
+    else
+        printf(" %*.*f", w, prec, x);
+}
+
+static inline void print_counters(const result_t res[], size_t num)
+{
+    const double *ctr;
+
+    printf("\n%-11s %-7s %4s %9s %9s %6s %9s %9s\n",
+           "algorithm", "visitor", "n", "instr/p", "cyc/p", "IPC",
+           "brmiss/p", "L1dmiss/p");
+    for (int i = 0; i < 71; i++)
+        printf("=");
+    printf("\n");
+    for (size_t i = 0; i < num; i++) {
+        ctr = res[i].ctr;
+        printf("%-11s %-7s %4d", res[i].algo->name,
+               res[i].visitor->name, res[i].n);
+        print_ctr(9, 2, ctr[PERFCTR_INSTRUCTIONS]);
+        print_ctr(9, 2, ctr[PERFCTR_CYCLES]);
+        print_ctr(6, 2, (ctr[PERFCTR_INSTRUCTIONS] < 0 ||
+                    ctr[PERFCTR_CYCLES] <= 0) ? -1 :
+                ctr[PERFCTR_INSTRUCTIONS] / ctr[PERFCTR_CYCLES]);
+        print_ctr(9, 4, ctr[PERFCTR_BRANCH_MISSES]);
+        print_ctr(9, 4, ctr[PERFCTR_L1D_MISSES]);
+        printf("\n");
+    }
+}
+
+/* Print a counter median to a CSV file (empty if unknown). */
+static inline void fprint_csv_ctr(FILE *fp, double x)
+{
+    if (x < 0)
+        fprintf(fp, ",");
+    else
+        fprintf(fp, ",%.4f", x);
+}
+
+static inline int write_csv(const char *path, const result_t res[],
+        size_t num)
+{
+    FILE *fp;
+
+    if ((fp = fopen(path, "w")) == NULL)
+        return -1;
+    fprintf(fp, "%s\n", CSV_HEADER);
+    for (size_t i = 0; i < num; i++) {
+        fprintf(fp, "%s,%s,%d,%" PRIu64 ",%d,%.4f,%.4f,%.3f,%.3f",
+                res[i].algo->name, res[i].visitor->name, res[i].n,
+                res[i].count, res[i].reps, res[i].med_ns, res[i].min_ns,
+                res[i].med_cyc, res[i].min_cyc);
+        for (int ev = 0; ev < PERFCTR_NUM; ev++)
+            fprint_csv_ctr(fp, res[i].ctr[ev]);
+        fprintf(fp, "\n");
+    }
+    return fclose(fp) ? -1 : 0;
+}
+
+static inline int write_json(const char *path, const result_t res[],
+        size_t num)
+{
+    FILE *fp;
+
+    if ((fp = fopen(path, "w")) == NULL)
+        return -1;
+    fprintf(fp, "[\n");
+    for (size_t i = 0; i < num; i++) {
+        fprintf(fp, "  {\"algorithm\": \"%s\", \"visitor\": \"%s\", "
+                "\"n\": %d, \"partitions\": %" PRIu64 ", \"reps\": %d,\n"
+                "   \"median_ns\": %.4f, \"min_ns\": %.4f, "
+                "\"median_cycles\": %.3f, \"min_cycles\": %.3f",
+                res[i].algo->name, res[i].visitor->name, res[i].n,
+                res[i].count, res[i].reps, res[i].med_ns, res[i].min_ns,
+                res[i].med_cyc, res[i].min_cyc);
+        for (int ev = 0; ev < PERFCTR_NUM; ev++)
+            if (res[i].ctr[ev] >= 0)
+                fprintf(fp, ",\n   \"%s\": %.4f",
+                        perfctr_names[ev], res[i].ctr[ev]);
+        if (res[i].base_ns > 0)
+            fprintf(fp, ",\n   \"baseline_median_ns\": %.4f",
+                    res[i].base_ns);
+        fprintf(fp, "}%s\n", (i + 1 < num) ? "," : "");
+    }
+    fprintf(fp, "]\n");
+    return fclose(fp) ? -1 : 0;
+}
@@ -3,29 +3,53 @@
  *
  * Author: Debajyoti Nandi <debajyoti.nandi@gmail.com>
  * Created: 2016-07-05
- * Modified: 2016-07-13
+ * Modified: 2026-10-18
  * License: MIT License (see LICENSE.txt)
  *
  * Compilation Suggestions:
  *   CC = gcc #(or clang)
  *   CFLAGS = -std=gnu11 -O3 #(or, -O2)
- *   OBJS = partition.o
- *   $(CC) $(CFLAGS) -o genpartn genpartn.c $(OBJS)
+ *   OBJS = partition.o shard.o stats.o topology.o
+ *   LIBS = -lpthread
+ *   $(CC) $(CFLAGS) -o genpartn genpartn.c $(OBJS) $(LIBS)
  *
- * Usage: ./genpartn ALGORITHM ACTION N
+ * Usage: ./genpartn [OPTIONS] ALGORITHM ACTION N
  *
  *   ALGORITHM   Algorithm to generate partitions (rule_asc,
  *               rule_desc, accel_asc, accel_desc, merca1, merca2,
- *               merca3, zs1, or zs2).
- *   ACTION      Action for each partition (none, or print).
+ *               merca3, zs1, or zs2), or auto_asc (also: auto) or
+ *               auto_desc for the fastest ascending or descending
+ *               algorithm on this machine (see auto_partn_algo).
+ *   ACTION      Action for each partition (none, print, or stats
+ *               for histograms, see stats.h).
  *   N           The number to be partitioned.
  *
+ * Options:
+ *   --shard I/K     Only generate shard I (0 <= I < K) of K (see
+ *                   shard.h) and write a result file for partnmerge.
+ *                   Shards are generated by accel_asc_subtree, so
+ *                   ALGORITHM is not used.
+ *   --result FILE   The result file (default:
+ *                   genpartn-N.shard-I-of-K); without --shard, write
+ *                   a result file for all the partitions.
+ *   --stats LIST    Statistics for ACTION stats (comma separated:
+ *                   parts, largest, distinct, mult, sizes, durfee;
+ *                   default: all).
+ *   --threads T     Threads for ACTION stats (default: the number of
+ *                   online CPUs).  Statistics are generated by
+ *                   accel_asc_subtree, so ALGORITHM is not used.
+ *
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
 #include <string.h>
+#include <getopt.h>
+#include <unistd.h>
 #include "partition.h"
+#include "shard.h"
+#include "stats.h"
+#include "topology.h"
 
 /* Type: Algorithms */
 typedef enum {
@@ -34,25 +58,16 @@ typedef enum {
     E_INVALID_N,
     E_INVALID_METHOD,
     E_INVALID_ACTION,
+    E_INVALID_SHARD,
+    E_OUT_OF_MEMORY,
+    E_IO_FAILURE,
 } err_t;
 
-/* Type: algorithms */
-typedef enum {
-    ALGO_RULE_ASC,
-    ALGO_RULE_DESC,
-    ALGO_ACCEL_ASC,
-    ALGO_ACCEL_DESC,
-    ALGO_MERCA1,
-    ALGO_MERCA2,
-    ALGO_MERCA3,
-    ALGO_ZS1,
-    ALGO_ZS2,
-} algo_t;
-
 /* Type: Actions */
 typedef enum {
     ACTION_NONE,
     ACTION_PRINT,
+    ACTION_STATS,
 } action_t;
 
 /* Print usage info. */
@@ -61,52 +76,125 @@ static inline void usage(const char *command);
 /* Parse command line arguments. */
 static inline err_t parse_args(
         char *argv[],
-        algo_t *algp,
         action_t *axnp,
         int *np);
 
+/*
+ * The algorithm `name` for `action` (NULL if there is none); "auto"
+ * times the generators (see auto_partn_algo), so it is only looked up
+ * where it is used.
+ */
+static inline const partn_algo_t *select_algo(const char *name,
+        action_t action);
+
+/*
+ * Generate shard `shard` of `shards` of the partitions of `n` and
+ * write the result file `path` (NULL for the default name).
+ */
+static inline err_t gen_shard(int n, action_t action,
+        int shard, int shards, const char *path);
+
 /* Print (with newline) a visited partition. Ignore `argres`. */
 static inline void partn_println(const partition_t *p, void *argres);
 
 partn_visitor_f *visitors[] = {
     NULL,
     partn_println,
-};
-
-partn_generator_f *generators[] = {
-    rule_asc,
-    rule_desc,
-    accel_asc,
-    accel_desc,
-    merca1,
-    merca2,
-    merca3,
-    zs1,
-    zs2,
+    NULL,
 };
 
 int main(int argc, char *argv[])
 {
-    int n;
+    const char *prog = argv[0];
+    int n, c;
+    int shard = 0, shards = 0;
+    const char *result = NULL;
+    unsigned kinds = PSTAT_ALL;
+    int threads = online_cpus();
+    partn_stats_t st;
     uint64_t count;
-    algo_t algo;
+    const partn_algo_t *algo;
     action_t action;
     err_t error;
+    static const struct option longopts[] = {
+        {"shard",  required_argument, NULL, 's'},
+        {"result", required_argument, NULL, 'o'},
+        {"stats",  required_argument, NULL, 'S'},
+        {"threads", required_argument, NULL, 'T'},
+        {NULL, 0, NULL, 0},
+    };
 
+    while ((c = getopt_long(argc, argv, "+", longopts, NULL)) != -1) {
+        switch (c) {
+            case 's':
+                if (! parse_shard(optarg, &shard, &shards)) {
+                    fprintf(stderr, "[Error] Invalid shard (I/K).\n\n");
+                    usage(prog);
+                    exit(E_INVALID_SHARD);
+                }
+                break;
+            case 'o':
+                result = optarg;
+                break;
+            case 'S':
+                if (! parse_pstat_kinds(optarg, &kinds)) {
+                    fprintf(stderr, "[Error] Invalid statistics.\n\n");
+                    usage(prog);
+                    exit(E_INVALID_ACTION);
+                }
+                break;
+            case 'T':
+                if ((threads = atoi(optarg)) < 1) {
+                    fprintf(stderr, "[Error] Invalid threads.\n\n");
+                    usage(prog);
+                    exit(E_INVALID_ACTION);
+                }
+                break;
+            default:
+                usage(prog);
+                exit(E_WRONG_NUM_ARGS);
+        }
+    }
+    argc -= optind - 1;
+    argv += optind - 1;
     if (argc != 4) {
-        usage(argv[0]);
+        usage(prog);
         exit(E_WRONG_NUM_ARGS);
     }
-    if ((error = parse_args(argv, &algo, &action, &n))) {
+    if ((error = parse_args(argv, &action, &n))) {
         fprintf(stderr, "\n");
-        usage(argv[0]);
+        usage(prog);
         exit(error);
     }
 
+    if (action == ACTION_STATS) {
+        if (shards || result) {
+            fprintf(stderr, "[Error] Statistics are not sharded.\n");
+            exit(E_INVALID_SHARD);
+        }
+        if (partn_stats(n, kinds, threads, &st)) {
+            fprintf(stderr, "[Error] Out of memory.\n");
+            exit(E_OUT_OF_MEMORY);
+        }
+        printf("n = %d\n", n);
+        printf("p[%d] = %" PRIu64 "\n\n", n, st.count);
+        print_partn_stats(&st);
+        free_partn_stats(&st);
+        return 0;
+    }
+    if (shards || result) {
+        if ((error = gen_shard(n, action, shard, shards ? shards : 1,
+                        result)))
+            exit(error);
+        return 0;
+    }
+    algo = select_algo(argv[1], action);
+    if (strncmp(argv[1], "auto", 4) == 0)
+        fprintf(stderr, "Using %s.\n", algo->name);
     printf("n = %d\n", n);
     if (action == ACTION_PRINT)
         printf("\n");
-    count = generators[algo](n, visitors[action], NULL);
+    count = algo->gen(n, NULL, visitors[action], NULL);
     if (action == ACTION_PRINT)
         printf("\n");
     printf("p[%d] = %" PRIu64 "\n", n, count);
@@ -115,55 +203,51 @@ int main(int argc, char *argv[])
 
 static inline void usage(const char *com)
 {
-    fprintf(stderr, "Generate all partitions of N (0-199).\n\n");
-    fprintf(stderr, "Usage: %s ALGORITHM ACTION N\n\n", com);
+    fprintf(stderr, "Generate all partitions of N.\n\n");
+    fprintf(stderr, "Usage: %s [OPTIONS] ALGORITHM ACTION N\n\n", com);
     fprintf(stderr, "  ALGORITHM\tAlgorithm to generate partitions ");
     fprintf(stderr, "(rule_asc, rule_desc,\n\t\taccel_asc, ");
     fprintf(stderr, "accel_desc, merca1, merca2, merca3, zs1, ");
-    fprintf(stderr, "or zs2).\n");
+    fprintf(stderr, "or zs2,\n\t\tor auto_asc (or auto), or ");
+    fprintf(stderr, "auto_desc for the fastest on this\n\t\tmachine).\n");
     fprintf(stderr, "  ACTION\tAction for each partition ");
-    fprintf(stderr, "(none, or print).\n");
-    fprintf(stderr, "  N\t\tThe number to be partitioned.\n");
+    fprintf(stderr, "(none, print, or stats).\n");
+    fprintf(stderr, "  N\t\tThe number to be partitioned.\n\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --shard I/K\tOnly shard I (0 <= I < K) of K ");
+    fprintf(stderr, "(ALGORITHM is not used).\n");
+    fprintf(stderr, "  --result FILE\tResult file for partnmerge ");
+    fprintf(stderr, "(default:\n\t\tgenpartn-N.shard-I-of-K).\n");
+    fprintf(stderr, "  --stats LIST\tStatistics for stats (parts, ");
+    fprintf(stderr, "largest, distinct,\n\t\tmult, sizes, durfee; ");
+    fprintf(stderr, "default: all).\n");
+    fprintf(stderr, "  --threads T\tThreads for stats (default: ");
+    fprintf(stderr, "online CPUs).\n");
 }
 
 static inline err_t parse_args(
         char *argv[],
-        algo_t *algp,
         action_t *axnp,
         int *np)
 {
-    if (strcmp(argv[1], "rule_asc") == 0) {
-        *algp = ALGO_RULE_ASC;
-    } else if (strcmp(argv[1], "rule_desc") == 0) {
-        *algp = ALGO_RULE_DESC;
-    } else if (strcmp(argv[1], "accel_asc") == 0) {
-        *algp = ALGO_ACCEL_ASC;
-    } else if (strcmp(argv[1], "accel_desc") == 0) {
-        *algp = ALGO_ACCEL_DESC;
-    } else if (strcmp(argv[1], "merca1") == 0) {
-        *algp = ALGO_MERCA1;
-    } else if (strcmp(argv[1], "merca2") == 0) {
-        *algp = ALGO_MERCA2;
-    } else if (strcmp(argv[1], "merca3") == 0) {
-        *algp = ALGO_MERCA3;
-    } else if (strcmp(argv[1], "zs1") == 0) {
-        *algp = ALGO_ZS1;
-    } else if (strcmp(argv[1], "zs2") == 0) {
-        *algp = ALGO_ZS2;
-    } else {
-        fprintf(stderr, "[Error] Invalid METHOD.\n");
-        return E_INVALID_METHOD;
-    }
-
     if (strcmp(argv[2], "none") == 0) {
         *axnp = ACTION_NONE;
     } else if (strcmp(argv[2], "print") == 0) {
         *axnp = ACTION_PRINT;
+    } else if (strcmp(argv[2], "stats") == 0) {
+        *axnp = ACTION_STATS;
     } else {
         fprintf(stderr, "[Error] Invalid ACTION.\n");
         return E_INVALID_ACTION;
     }
 
+    if (strcmp(argv[1], "auto") && strcmp(argv[1], "auto_asc") &&
+            strcmp(argv[1], "auto_desc") &&
+            find_partn_algo(argv[1]) == NULL) {
+        fprintf(stderr, "[Error] Invalid METHOD.\n");
+        return E_INVALID_METHOD;
+    }
+
     if (! sscanf(argv[3], "%d", np)) {
         fprintf(stderr, "[Error] Bad argument for N.\n");
         return E_INVALID_N;
@@ -175,6 +259,19 @@ static inline err_t parse_args(
     return E_SUCCESS;
 }
 
+static inline const partn_algo_t *select_algo(const char *name,
+        action_t action)
+{
+    partn_visit_t visit = (action == ACTION_NONE) ?
+        PARTN_VISIT_NONE : PARTN_VISIT_PARTS;
+
+    if (strcmp(name, "auto") == 0 || strcmp(name, "auto_asc") == 0)
+        return auto_partn_algo(PARTN_ASCENDING, visit);
+    if (strcmp(name, "auto_desc") == 0)
+        return auto_partn_algo(PARTN_DESCENDING, visit);
+    return find_partn_algo(name);
+}
+
 static inline void partn_println(const partition_t *p, void *argres)
 {
     printf("[");
@@ -186,3 +283,71 @@ static inline void partn_println(const partition_t *p, void *argres)
     printf("]");
     printf("\n");
 }
+
+/* Accumulator of the visitor of a shard. */
+typedef struct {
+    action_t action;
+    uint64_t fingerprint;
+} shard_acc_t;
+
+static void shard_visit(const partition_t *p, void *argres)
+{
+    shard_acc_t *acc = argres;
+
+    acc->fingerprint += partn_fingerprint(p);
+    if (acc->action == ACTION_PRINT)
+        println_partition(p);
+}
+
+static inline err_t gen_shard(int n, action_t action,
+        int shard, int shards, const char *path)
+{
+    char name[64];
+    shard_plan_t plan;
+    shard_result_t res;
+    shard_row_t *row;
+    shard_acc_t acc = {action, 0};
+    size_t first, last;
+    uint64_t count = 0;
+    int *buf;
+
+    if (plan_shards(&plan, n, shards) ||
+            alloc_shard_result(&res, "genpartn", shard, shards, 1) ||
+            (buf = malloc(PARTN_BUFLEN(n) * sizeof(int))) == NULL) {
+        fprintf(stderr, "[Error] Out of memory.\n");
+        return E_OUT_OF_MEMORY;
+    }
+    shard_range(&plan, shard, shards, &first, &last);
+    printf("n = %d\n", n);
+    printf("shard %d/%d: units %zu to %zu of %zu\n", shard, shards,
+            first, last, plan.num_units);
+    if (action == ACTION_PRINT)
+        printf("\n");
+    for (size_t u = first; u < last; u++)
+        count += gen_shard_unit(&plan, u, buf, shard_visit, &acc);
+    if (action == ACTION_PRINT)
+        printf("\n");
+    printf("p[%d] (shard %d/%d) = %" PRIu64 "\n", n, shard, shards, count);
+
+    row = &res.rows[0];
+    row->n = n;
+    row->first = first;
+    row->last = last;
+    row->total = plan.num_units;
+    row->count = count;
+    row->sum = count;
+    row->fingerprint = acc.fingerprint;
+    if (path == NULL) {
+        snprintf(name, sizeof(name), "genpartn-%d.shard-%d-of-%d",
+                n, shard, shards);
+        path = name;
+    }
+    if (write_shard_result(path, &res)) {
+        fprintf(stderr, "[Error] Cannot write %s.\n", path);
+        return E_IO_FAILURE;
+    }
+    free(buf);
+    free_shard_result(&res);
+    free_shard_plan(&plan);
+    return E_SUCCESS;
+}
@@ -0,0 +1,125 @@
+/*
+ * merge.c - Merge the result files of sharded runs (partnmerge).
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   CC = gcc #(or clang)
+ *   CFLAGS = -std=gnu11 -O3 #(or, -O2)
+ *   OBJS = partition.o shard.o
+ *   $(CC) $(CFLAGS) -o partnmerge merge.c $(OBJS)
+ *
+ * Usage: ./partnmerge [-o OUTPUT] FILE...
+ *
+ *   FILE        Result files written by `genpartn --shard` or
+ *               `partnid verify --shard` (or earlier merges).
+ *   -o OUTPUT   Write the merged result file to OUTPUT.
+ *
+ * Prints, for each n, the units covered, the number of partitions,
+ * the sum and the fingerprint of the merged results (see shard.h).
+ * Exits with 0 if the results cover all the units exactly once, and
+ * with 1 if some are missing (a partial merge, which can be merged
+ * again later).  Overlapping or mismatched results are errors.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include "shard.h"
+
+typedef enum {
+    E_SUCCESS,
+    E_INCOMPLETE,
+    E_INVALID_ARGS,
+    E_BAD_RESULT,
+    E_IO_FAILURE,
+    E_OUT_OF_MEMORY,
+} err_t;
+
+static inline void usage(const char *com)
+{
+    fprintf(stderr, "Merge the result files of sharded runs.\n\n");
+    fprintf(stderr, "Usage: %s [-o OUTPUT] FILE...\n\n", com);
+    fprintf(stderr, "  FILE\t\tResult file of genpartn --shard, ");
+    fprintf(stderr, "partnid verify --shard\n\t\tor partnmerge.\n");
+    fprintf(stderr, "  -o OUTPUT\tWrite the merged result file.\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *output = NULL;
+    shard_result_t *res, out;
+    shard_merge_t status;
+    size_t num;
+    int c;
+
+    while ((c = getopt(argc, argv, "o:h")) != -1) {
+        switch (c) {
+            case 'o':
+                output = optarg;
+                break;
+            case 'h':
+                usage(argv[0]);
+                return E_SUCCESS;
+            default:
+                usage(argv[0]);
+                return E_INVALID_ARGS;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return E_INVALID_ARGS;
+    }
+    num = argc - optind;
+    if ((res = calloc(num, sizeof(shard_result_t))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        return E_OUT_OF_MEMORY;
+    }
+    for (size_t f = 0; f < num; f++)
+        if (read_shard_result(argv[optind + f], &res[f]))
+            return E_BAD_RESULT;
+
+    status = merge_shard_results(res, num, &out);
+    switch (status) {
+        case SHARD_MERGE_COMPLETE:
+        case SHARD_MERGE_PARTIAL:
+            break;
+        case SHARD_MERGE_NOMEM:
+            fprintf(stderr, "[ERR] Out of memory!\n");
+            return E_OUT_OF_MEMORY;
+        default:
+            return E_BAD_RESULT;
+    }
+
+    printf("program %s, %d shards, %zu files\n", out.program,
+            out.shards, num);
+    printf("  %4s %17s %20s %20s %16s\n",
+            "n", "units", "count", "sum", "fingerprint");
+    for (size_t r = 0; r < out.num_rows; r++) {
+        const shard_row_t *row = &out.rows[r];
+        char units[40];
+        snprintf(units, sizeof(units), "%zu-%zu/%zu",
+                row->first, row->last, row->total);
+        printf("%s %4d %17s %20" PRIu64 " %20" PRId64 " %016" PRIx64 "\n",
+                (row->first == 0 && row->last == row->total) ? "  " : "**",
+                row->n, units, row->count, row->sum, row->fingerprint);
+    }
+    if (status == SHARD_MERGE_COMPLETE)
+        printf("Complete: every unit is covered exactly once.\n");
+    else
+        printf("Incomplete: some units are missing (see above).\n");
+
+    if (output && write_shard_result(output, &out)) {
+        fprintf(stderr, "[ERR] Cannot write %s!\n", output);
+        return E_IO_FAILURE;
+    }
+    for (size_t f = 0; f < num; f++)
+        free_shard_result(&res[f]);
+    free(res);
+    free_shard_result(&out);
+    return (status == SHARD_MERGE_COMPLETE) ? E_SUCCESS : E_INCOMPLETE;
+}
@@ -3,7 +3,7 @@
  *
  * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
  * Created:  2016-07-05
- * Modified: 2016-07-13
+ * Modified: 2026-10-18
  * License:  MIT License (see LICENSE.txt)
  *
  * Compilation Suggestions:
@@ -14,8 +14,10 @@
 
 #include <stdio.h>
 #include <string.h>
-/*#include <stdlib.h>*/
+#include <stdlib.h>
 #include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
 /*#include <inttypes.h>*/
 #include "partition.h"
 
@@ -48,7 +50,7 @@ void println_partition(const partition_t *p)
 
 void init_partition(partition_t *p, int initial_val)
 {
-    for (size_t i = 0; i <= MAXNUMP; i++)
+    for (int i = 0; i <= p->n; i++)
         p->a[i] = initial_val;
 }
 
@@ -62,7 +64,34 @@ void mk_partition(partition_t *p, const int a[],
 
 void cp_partition(const partition_t *p, partition_t *q)
 {
-    memcpy(q, p, sizeof(partition_t));
+    q->n = p->n;
+    q->len = p->len;
+    memcpy(q->a, p->a, p->len * sizeof(int));
+}
+
+/*
+ * Point `p` at the work buffer for the partitions of `n` (n > 0):
+ * `buf` if given, otherwise a freshly allocated one which is also
+ * returned in `*mem` (NULL otherwise) for the caller to free.  The
+ * guard slot `p->a[-1]` is zeroed.  Returns false if the allocation
+ * failed.  The size is checked here, once, so that the generators
+ * can index the buffer freely in their inner loops.
+ */
+static inline bool open_partition(partition_t *p, int n, int buf[],
+        int **mem)
+{
+    *mem = NULL;
+    if (buf == NULL) {
+        buf = malloc(PARTN_BUFLEN(n) * sizeof(int));
+        if (buf == NULL)
+            return false;
+        *mem = buf;
+    }
+    buf[0] = 0;
+    p->n = n;
+    p->len = 0;
+    p->a = buf + 1;
+    return true;
 }
 
 
@@ -85,10 +114,12 @@ void cp_partition(const partition_t *p, partition_t *q)
  *       https://arxiv.org/abs/0909.2331
  */
 
-uint64_t rule_asc(int n, partn_visitor_f *visit, void *argres)
+uint64_t rule_asc(int n, int buf[],
+        partn_visitor_f *visit, void *argres)
 {
     uint64_t count = 0;
     int k, x, y;
+    int *a, *mem;
     partition_t p;
 
     p.n = n;
@@ -96,35 +127,42 @@ uint64_t rule_asc(int n, partn_visitor_f *visit, void *argres)
         return count;
     } else if (n == 0) {
         p.len = 0;
+        p.a = NULL;
         if (visit)
             visit(&p, argres);
         return ++count;
     }
+    if (! open_partition(&p, n, buf, &mem))
+        return count;
+    a = p.a;
     init_partition(&p, 0);
-    p.a[1] = n;
+    a[1] = n;
     k = 1;
     while (k != 0) {
-        y = p.a[k] - 1;
+        y = a[k] - 1;
         k--;
-        x = p.a[k] + 1;
+        x = a[k] + 1;
         while (x <= y) {
-            p.a[k] = x;
+            a[k] = x;
             y -= x;
             k++;
         }
-        p.a[k] = x + y;
+        a[k] = x + y;
         p.len = k + 1;
         if (visit)
             visit(&p, argres);
         count++;
     }
+    free(mem);
     return count;
 }
 
-uint64_t rule_desc(int n, partn_visitor_f *visit, void *argres)
+uint64_t rule_desc(int n, int buf[],
+        partn_visitor_f *visit, void *argres)
 {
     uint64_t count = 0;
     int k, l, m, n1;
+    int *a, *mem;
     partition_t p;
 
     p.n = n;
@@ -132,12 +170,16 @@ uint64_t rule_desc(int n, partn_visitor_f *visit, void *argres)
         return count;
     } else if (n == 0) {
         p.len = 0;
+        p.a = NULL;
         if (visit)
             visit(&p, argres);
         return ++count;
     }
+    if (! open_partition(&p, n, buf, &mem))
+        return count;
+    a = p.a;
     init_partition(&p, 0);
-    p.a[0] = n;
+    a[0] = n;
     p.len = 1;
     if (visit)
         visit(&p, argres);
@@ -145,31 +187,34 @@ uint64_t rule_desc(int n, partn_visitor_f *visit, void *argres)
     k = 0;
     while (k != n-1) {
         l = k;
-        m = p.a[k];
+        m = a[k];
         while (m == 1) {
             k--;
-            m = p.a[k];
+            m = a[k];
         }
         n1 = m + l - k;
         m--;
         while (m < n1) {
-            p.a[k] = m;
+            a[k] = m;
             n1 -= m;
             k++;
         }
-        p.a[k] = n1;
+        a[k] = n1;
         p.len = k + 1;
         if (visit)
             visit(&p, argres);
         count++;
     }
+    free(mem);
     return count;
 }
 
-uint64_t accel_asc(int n, partn_visitor_f *visit, void *argres)
+uint64_t accel_asc(int n, int buf[],
+        partn_visitor_f *visit, void *argres)
 {
     uint64_t count = 0;
     int k, l, x, y;
+    int *a, *mem;
     partition_t p;
 
     p.n = n;
@@ -177,25 +222,92 @@ uint64_t accel_asc(int n, partn_visitor_f *visit, void *argres)
         return count;
     } else if (n == 0) {
         p.len = 0;
+        p.a = NULL;
         if (visit)
             visit(&p, argres);
         return ++count;
     }
+    if (! open_partition(&p, n, buf, &mem))
+        return count;
+    a = p.a;
     init_partition(&p, 0);
     k = 1;
     y = n - 1;
     while (k != 0) {
         k--;
-        x = p.a[k] + 1;
+        x = a[k] + 1;
+        while (2*x <= y) {
+            a[k] = x;
+            y -= x;
+            k++;
+        }
+        l = k + 1;
+        while (x <= y) {
+            a[k] = x;
+            a[l] = y;
+            p.len = l + 1;
+            if (visit)
+                visit(&p, argres);
+            count++;
+            x++;
+            y--;
+        }
+        y += x - 1;
+        a[k] = y + 1;
+        p.len = k + 1;
+        if (visit)
+            visit(&p, argres);
+        count++;
+    }
+    free(mem);
+    return count;
+}
+
+uint64_t accel_asc_subtree(int n, const int prefix[], size_t plen,
+        int lo, int buf[], partn_visitor_f *visit, void *argres)
+{
+    uint64_t count = 0;
+    int j, k, l, m, x, y;
+    int *a, *mem;
+    partition_t p;
+
+    m = n;
+    for (size_t i = 0; i < plen; i++)
+        m -= prefix[i];
+    if (lo < 1)
+        lo = 1;
+    if (m < 0 || (m > 0 && m < lo))
+        return count;
+    if (! open_partition(&p, n, buf, &mem))
+        return count;
+    a = p.a;
+    j = plen;
+    if (plen)
+        memcpy(a, prefix, plen * sizeof(int));
+    if (m == 0) {
+        p.len = j;
+        if (visit)
+            visit(&p, argres);
+        free(mem);
+        return ++count;
+    }
+    /* As accel_asc, with a[j] about to become `lo` and the parts
+     * before `j` fixed. */
+    a[j] = lo - 1;
+    k = j + 1;
+    y = m - lo;
+    while (k != j) {
+        k--;
+        x = a[k] + 1;
         while (2*x <= y) {
-            p.a[k] = x;
+            a[k] = x;
             y -= x;
             k++;
         }
         l = k + 1;
         while (x <= y) {
-            p.a[k] = x;
-            p.a[l] = y;
+            a[k] = x;
+            a[l] = y;
             p.len = l + 1;
             if (visit)
                 visit(&p, argres);
@@ -204,19 +316,22 @@ uint64_t accel_asc(int n, partn_visitor_f *visit, void *argres)
             y--;
         }
         y += x - 1;
-        p.a[k] = y + 1;
+        a[k] = y + 1;
         p.len = k + 1;
         if (visit)
             visit(&p, argres);
         count++;
     }
+    free(mem);
     return count;
 }
 
-uint64_t accel_desc(int n, partn_visitor_f *visit, void *argres)
+uint64_t accel_desc(int n, int buf[],
+        partn_visitor_f *visit, void *argres)
 {
     uint64_t count = 0;
     int k, m, n1, q;
+    int *a, *mem;
     partition_t p;
 
     p.n = n;
@@ -224,35 +339,41 @@ uint64_t accel_desc(int n, partn_visitor_f *visit, void *argres)
         return count;
     } else if (n == 0) {
         p.len = 0;
+        p.a = NULL;
         if (visit)
             visit(&p, argres);
         return ++count;
-    } else if (n == 1) {
-        p.a[0] = 1;
+    }
+    if (! open_partition(&p, n, buf, &mem))
+        return count;
+    a = p.a;
+    if (n == 1) {
+        a[0] = 1;
         p.len = 1;
         if (visit)
             visit(&p, argres);
+        free(mem);
         return ++count;
     }
     init_partition(&p, 1);
-    p.a[0] = n;
+    a[0] = n;
     p.len = 1;
     if (visit)
         visit(&p, argres);
     count++;
     k = q = 0;
     while (q != -1) {
-        if (p.a[q] == 2) {
+        if (a[q] == 2) {
             k++;
-            p.a[q] = 1;
+            a[q] = 1;
             q--;
         } else {
-            m = p.a[q] - 1;
+            m = a[q] - 1;
             n1 = k - q + 1;
-            p.a[q] = m;
+            a[q] = m;
             while (n1 >= m) {
                 q++;
-                p.a[q] = m;
+                a[q] = m;
                 n1 -= m;
             }
             if (n1 == 0) {
@@ -261,7 +382,7 @@ uint64_t accel_desc(int n, partn_visitor_f *visit, void *argres)
                 k = q + 1;
                 if (n1 > 1) {
                     q++;
-                    p.a[q] = n1;
+                    a[q] = n1;
                 }
             }
         }
@@ -270,6 +391,7 @@ uint64_t accel_desc(int n, partn_visitor_f *visit, void *argres)
             visit(&p, argres);
         count++;
     }
+    free(mem);
     return count;
 }
 
@@ -284,11 +406,13 @@ uint64_t accel_desc(int n, partn_visitor_f *visit, void *argres)
  *       DOI:10.1007/s10852-011-9168-y
  */
 
-uint64_t merca1(int n, partn_visitor_f *visit, void *argres)
+uint64_t merca1(int n, int buf[],
+        partn_visitor_f *visit, void *argres)
 {
     uint64_t count = 0;
     int k, x, y;
     bool c;
+    int *a, *mem;
     partition_t p;
 
     p.n = n;
@@ -296,10 +420,14 @@ uint64_t merca1(int n, partn_visitor_f *visit, void *argres)
         return count;
     } else if (n == 0) {
         p.len = 0;
+        p.a = NULL;
         if (visit)
             visit(&p, argres);
         return ++count;
     }
+    if (! open_partition(&p, n, buf, &mem))
+        return count;
+    a = p.a;
     init_partition(&p, 0);
     k = -1;
     x = 1;
@@ -308,14 +436,14 @@ uint64_t merca1(int n, partn_visitor_f *visit, void *argres)
     while (c) {
         while (2*x <= y) {
             k++;
-            p.a[k] = x;
+            a[k] = x;
             y -= x;
         }
         while (x <= y) {
             k++;
-            p.a[k] = x;
+            a[k] = x;
             k++;
-            p.a[k] = y;
+            a[k] = y;
             p.len = k + 1;
             if (visit)
                 visit(&p, argres);
@@ -325,7 +453,7 @@ uint64_t merca1(int n, partn_visitor_f *visit, void *argres)
             y--;
         }
         k++;
-        p.a[k] = x + y;
+        a[k] = x + y;
         p.len = k + 1;
         if (visit)
             visit(&p, argres);
@@ -333,7 +461,7 @@ uint64_t merca1(int n, partn_visitor_f *visit, void *argres)
         k--;
         if (k >= 0) {
             y += x;
-            x = p.a[k];
+            x = a[k];
             k--;
             x++;
             y--;
@@ -341,13 +469,16 @@ uint64_t merca1(int n, partn_visitor_f *visit, void *argres)
             c = false;
         }
     }
+    free(mem);
     return count;
 }
 
-uint64_t merca2(int n, partn_visitor_f *visit, void *argres)
+uint64_t merca2(int n, int buf[],
+        partn_visitor_f *visit, void *argres)
 {
     uint64_t count = 0;
     int k, t, x, y;
+    int *a, *mem;
     partition_t p;
 
     p.n = n;
@@ -355,24 +486,28 @@ uint64_t merca2(int n, partn_visitor_f *visit, void *argres)
         return count;
     } else if (n == 0) {
         p.len = 0;
+        p.a = NULL;
         if (visit)
             visit(&p, argres);
         return ++count;
     }
+    if (! open_partition(&p, n, buf, &mem))
+        return count;
+    a = p.a;
     init_partition(&p, 0);
     k = 0;
     x = 1;
     y = n - 1;
     while (k >= 0) {
         while (2*x <= y) {
-            p.a[k] = x;
+            a[k] = x;
             y -= x;
             k++;
         }
         t = k + 1;
         while (x <= y) {
-            p.a[k] = x;
-            p.a[t] = y;
+            a[k] = x;
+            a[t] = y;
             p.len = t + 1;
             if (visit)
                 visit(&p, argres);
@@ -381,21 +516,24 @@ uint64_t merca2(int n, partn_visitor_f *visit, void *argres)
             y--;
         }
         y += x - 1;
-        p.a[k] = y + 1;
+        a[k] = y + 1;
         p.len = k + 1;
         if (visit)
             visit(&p, argres);
         count++;
         k--;
-        x = p.a[k] + 1;
+        x = a[k] + 1;
     }
+    free(mem);
     return count;
 }
 
-uint64_t merca3(int n, partn_visitor_f *visit, void *argres)
+uint64_t merca3(int n, int buf[],
+        partn_visitor_f *visit, void *argres)
 {
     uint64_t count = 0;
     int k, r, s, t, u, x, y;
+    int *a, *mem;
     partition_t p;
 
     p.n = n;
@@ -403,26 +541,30 @@ uint64_t merca3(int n, partn_visitor_f *visit, void *argres)
         return count;
     } else if (n == 0) {
         p.len = 0;
+        p.a = NULL;
         if (visit)
             visit(&p, argres);
         return ++count;
     }
+    if (! open_partition(&p, n, buf, &mem))
+        return count;
+    a = p.a;
     init_partition(&p, 0);
     k = 0;
     x = 1;
     y = n - 1;
     while (k >= 0) {
         while (3*x <= y) {
-            p.a[k] = x;
+            a[k] = x;
             y -= x;
             k++;
         }
         t = k + 1;
         u = k + 2;
         while (2*x <= y) {
-            p.a[k] = x;
-            p.a[t] = x;
-            p.a[u] = y - x;
+            a[k] = x;
+            a[t] = x;
+            a[u] = y - x;
             p.len = u + 1;
             if (visit)
                 visit(&p, argres);
@@ -430,8 +572,8 @@ uint64_t merca3(int n, partn_visitor_f *visit, void *argres)
             r = x + 1;
             s = y - r;
             while (r <= s) {
-                p.a[t] = r;
-                p.a[u] = s;
+                a[t] = r;
+                a[u] = s;
                 p.len = u + 1;
                 if (visit)
                     visit(&p, argres);
@@ -439,7 +581,7 @@ uint64_t merca3(int n, partn_visitor_f *visit, void *argres)
                 r++;
                 s--;
             }
-            p.a[t] = y;
+            a[t] = y;
             p.len = t + 1;
             if (visit)
                 visit(&p, argres);
@@ -448,8 +590,8 @@ uint64_t merca3(int n, partn_visitor_f *visit, void *argres)
             y--;
         }
         while (x <= y) {
-            p.a[k] = x;
-            p.a[t] = y;
+            a[k] = x;
+            a[t] = y;
             p.len = t + 1;
             if (visit)
                 visit(&p, argres);
@@ -458,14 +600,15 @@ uint64_t merca3(int n, partn_visitor_f *visit, void *argres)
             y--;
         }
         y += x - 1;
-        p.a[k] = y + 1;
+        a[k] = y + 1;
         p.len = k + 1;
         if (visit)
             visit(&p, argres);
         count++;
         k--;
-        x = p.a[k] + 1;
+        x = a[k] + 1;
     }
+    free(mem);
     return count;
 }
 
@@ -481,10 +624,12 @@ uint64_t merca3(int n, partn_visitor_f *visit, void *argres)
  *       http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.42.1287&rep1&type=pdf
  */
 
-uint64_t zs1(int n, partn_visitor_f *visit, void *argres)
+uint64_t zs1(int n, int buf[],
+        partn_visitor_f *visit, void *argres)
 {
     uint64_t count = 0;
     int h, m, r, t;
+    int *a, *mem;
     partition_t p;
 
     p.n = n;
@@ -492,30 +637,34 @@ uint64_t zs1(int n, partn_visitor_f *visit, void *argres)
         return count;
     } else if (n == 0) {
         p.len = 0;
+        p.a = NULL;
         if (visit)
             visit(&p, argres);
         return ++count;
     }
+    if (! open_partition(&p, n, buf, &mem))
+        return count;
+    a = p.a;
     init_partition(&p, 1);
-    p.a[0] = n;
+    a[0] = n;
     m = 1;
     h = 0;
     p.len = 1;
     if (visit)
         visit(&p, argres);
     count++;
-    while (p.a[0] != 1) {
-        if (p.a[h] == 2) {
+    while (a[0] != 1) {
+        if (a[h] == 2) {
             m++;
-            p.a[h] = 1;
+            a[h] = 1;
             h--;
         } else {
-            r = p.a[h] - 1;
+            r = a[h] - 1;
             t = m - h;
-            p.a[h] = r;
+            a[h] = r;
             while (t >= r) {
                 h++;
-                p.a[h] = r;
+                a[h] = r;
                 t -= r;
             }
             if (t == 0) {
@@ -524,7 +673,7 @@ uint64_t zs1(int n, partn_visitor_f *visit, void *argres)
                 m = h + 2;
                 if (t > 1) {
                     h++;
-                    p.a[h] = t;
+                    a[h] = t;
                 }
             }
         }
@@ -533,14 +682,16 @@ uint64_t zs1(int n, partn_visitor_f *visit, void *argres)
             visit(&p, argres);
         count++;
     }
+    free(mem);
     return count;
 }
 
-uint64_t zs2(int n, partn_visitor_f *visit, void *argres)
+uint64_t zs2(int n, int buf[],
+        partn_visitor_f *visit, void *argres)
 {
     uint64_t count = 0;
     int h, j, m, r;
-    int x[MAXNUMP+1];
+    int *x, *mem;
     partition_t p;
 
     p.n = n;
@@ -548,19 +699,26 @@ uint64_t zs2(int n, partn_visitor_f *visit, void *argres)
         return count;
     } else if (n == 0) {
         p.len = 0;
+        p.a = NULL;
         if (visit)
             visit(&p, argres);
         return ++count;
-    } else if (n == 1) {
+    }
+    if (! open_partition(&p, n, buf, &mem))
+        return count;
+    /* The parts are x[1], ..., x[m], so the partition is a view. */
+    x = p.a - 1;
+    if (n == 1) {
         p.len = 1;
-        p.a[0] = 1;
+        x[1] = 1;
         if (visit)
             visit(&p, argres);
+        free(mem);
         return ++count;
     }
     for (int i = 1; i < n+1; i++)
         x[i] = 1;
-    mk_partition(&p, x, 1, n);
+    p.len = n;
     if (visit)
         visit(&p, argres);
     count++;
@@ -568,7 +726,7 @@ uint64_t zs2(int n, partn_visitor_f *visit, void *argres)
     x[1] = 2;
     h = 1;
     m = n - 1;
-    mk_partition(&p, x, 1, m);
+    p.len = m;
     if (visit)
         visit(&p, argres);
     count++;
@@ -591,10 +749,193 @@ uint64_t zs2(int n, partn_visitor_f *visit, void *argres)
                 x[m-1] = 1;
             m = h + r - 1;
         }
-        mk_partition(&p, x, 1, m);
+        p.len = m;
         if (visit)
             visit(&p, argres);
         count++;
     }
+    free(mem);
     return count;
 }
+
+
+/*******************************************************************\
+ *  Registry                                                       *
+\*******************************************************************/
+
+const partn_algo_t partn_algos[] = {
+    {"rule_asc",   rule_asc,   PARTN_ASCENDING},
+    {"rule_desc",  rule_desc,  PARTN_DESCENDING},
+    {"accel_asc",  accel_asc,  PARTN_ASCENDING},
+    {"accel_desc", accel_desc, PARTN_DESCENDING},
+    {"merca1",     merca1,     PARTN_ASCENDING},
+    {"merca2",     merca2,     PARTN_ASCENDING},
+    {"merca3",     merca3,     PARTN_ASCENDING},
+    {"zs1",        zs1,        PARTN_DESCENDING},
+    {"zs2",        zs2,        PARTN_DESCENDING},
+};
+
+const size_t num_partn_algos = sizeof(partn_algos) / sizeof(partn_algos[0]);
+
+const partn_algo_t *find_partn_algo(const char *name)
+{
+    for (size_t i = 0; i < num_partn_algos; i++)
+        if (strcmp(partn_algos[i].name, name) == 0)
+            return &partn_algos[i];
+    return NULL;
+}
+
+
+/*******************************************************************\
+ *  Automatic Selection                                            *
+\*******************************************************************/
+
+/* Size of the micro-benchmark (p(60) = 966467 partitions). */
+#define AUTO_N 60
+#define AUTO_REPS 3
+
+static const char *auto_build = __VERSION__ " " __DATE__ " " __TIME__;
+static const char *auto_orders[] = {"asc", "desc"};
+static const char *auto_visits[] = {"none", "parts"};
+static const partn_algo_t *auto_cache[2][2];
+
+/* Stand-in visitor for PARTN_VISIT_PARTS: reads every part. */
+static void auto_visit(const partition_t *p, void *argres)
+{
+    int sum = 0;
+    for (size_t i = 0; i < p->len; i++)
+        sum += p->a[i];
+    *((int *) argres) += sum;
+}
+
+static inline uint64_t auto_nanotime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Path of the profile file (NULL if there is none). */
+static inline const char *auto_profile_path(char *buf, size_t size)
+{
+    const char *path = getenv("PARTN_PROFILE");
+    const char *home;
+
+    if (path && *path)
+        return path;
+    if ((home = getenv("HOME")) == NULL)
+        return NULL;
+    snprintf(buf, size, "%s/.partn_profile", home);
+    return buf;
+}
+
+/*
+ * Look up the winner for (`order`, `visit`) of this build in the
+ * profile (NULL if there is none).
+ */
+static inline const partn_algo_t *auto_load(const char *path,
+        partn_order_t order, partn_visit_t visit)
+{
+    char line[512], *build, *ord, *vis, *name, *saveptr;
+    const partn_algo_t *algo = NULL;
+    FILE *fp;
+
+    if (path == NULL || (fp = fopen(path, "r")) == NULL)
+        return NULL;
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] == '#')
+            continue;
+        build = strtok_r(line, "\t\n", &saveptr);
+        ord = strtok_r(NULL, "\t\n", &saveptr);
+        vis = strtok_r(NULL, "\t\n", &saveptr);
+        name = strtok_r(NULL, "\t\n", &saveptr);
+        if (name && strcmp(build, auto_build) == 0 &&
+                strcmp(ord, auto_orders[order]) == 0 &&
+                strcmp(vis, auto_visits[visit]) == 0)
+            algo = find_partn_algo(name);
+    }
+    fclose(fp);
+    return (algo && algo->order == order) ? algo : NULL;
+}
+
+/*
+ * Record the winner in the profile, replacing stale entries for the
+ * same (`order`, `visit`).  The file is rewritten into a temporary
+ * file and renamed, so that concurrent readers never see a partial
+ * profile.
+ */
+static inline void auto_store(const char *path, partn_order_t order,
+        partn_visit_t visit, const partn_algo_t *algo, double ns)
+{
+    char line[512], copy[512], tmp[4096], *build, *ord, *vis, *saveptr;
+    FILE *in, *out;
+
+    if (path == NULL)
+        return;
+    if (snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long) getpid())
+            >= (int) sizeof(tmp) || (out = fopen(tmp, "w")) == NULL)
+        return;
+    fprintf(out, "# Fastest partition generators (see auto_partn_algo).\n");
+    fprintf(out, "# build\torder\tvisitor\tgenerator\tns/partition\n");
+    if ((in = fopen(path, "r")) != NULL) {
+        while (fgets(line, sizeof(line), in)) {
+            if (line[0] == '#')
+                continue;
+            strcpy(copy, line);
+            build = strtok_r(copy, "\t\n", &saveptr);
+            ord = strtok_r(NULL, "\t\n", &saveptr);
+            vis = strtok_r(NULL, "\t\n", &saveptr);
+            if (vis && strcmp(ord, auto_orders[order]) == 0 &&
+                    strcmp(vis, auto_visits[visit]) == 0)
+                continue;
+            if (build)
+                fputs(line, out);
+        }
+        fclose(in);
+    }
+    fprintf(out, "%s\t%s\t%s\t%s\t%.3f\n", auto_build, auto_orders[order],
+            auto_visits[visit], algo->name, ns);
+    if (fclose(out) || rename(tmp, path))
+        remove(tmp);
+}
+
+const partn_algo_t *auto_partn_algo(partn_order_t order,
+        partn_visit_t visit)
+{
+    const partn_algo_t *best = NULL;
+    double best_ns = 0, ns;
+    uint64_t t0, dt, count;
+    char buf[4096];
+    const char *path;
+    int *mem, acc = 0;
+
+    if (auto_cache[order][visit])
+        return auto_cache[order][visit];
+    path = auto_profile_path(buf, sizeof(buf));
+    if ((best = auto_load(path, order, visit)))
+        return auto_cache[order][visit] = best;
+
+    /* Benchmark the candidates: best of AUTO_REPS runs each. */
+    if ((mem = malloc(PARTN_BUFLEN(AUTO_N) * sizeof(int))) == NULL)
+        return NULL;
+    for (size_t i = 0; i < num_partn_algos; i++) {
+        if (partn_algos[i].order != order)
+            continue;
+        ns = 0;
+        for (int r = 0; r < AUTO_REPS; r++) {
+            t0 = auto_nanotime();
+            count = partn_algos[i].gen(AUTO_N, mem,
+                    (visit == PARTN_VISIT_NONE) ? NULL : auto_visit, &acc);
+            dt = auto_nanotime() - t0;
+            if (r == 0 || (double) dt / count < ns)
+                ns = (double) dt / count;
+        }
+        if (best == NULL || ns < best_ns) {
+            best = &partn_algos[i];
+            best_ns = ns;
+        }
+    }
+    free(mem);
+    auto_store(path, order, visit, best, best_ns);
+    return auto_cache[order][visit] = best;
+}
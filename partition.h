@@ -3,7 +3,7 @@
  *
  * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
  * Created:  2016-07-05
- * Modified: 2016-07-20
+ * Modified: 2026-10-18
  * License:  MIT License (see LICENSE.txt)
  *
  * Algorithms:
@@ -25,20 +25,30 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 /*******************************************************************\
  *  Constants and Types                                            *
 \*******************************************************************/
 
-/* The maximum number to be partitioned. */
-#define MAXNUMP 200
+/*
+ * The number of `int`s in the work buffer of a generator for the
+ * partitions of `n`: one guard slot (some algorithms read one slot
+ * before the first part when they terminate) followed by `n + 1`
+ * slots for the parts.
+ */
+#define PARTN_BUFLEN(n) ((size_t) (n) + 2)
 
-/* Data type for partitions. */
+/*
+ * Data type for partitions.
+ *   The parts `a[0]`, ..., `a[len-1]` live in a buffer owned by
+ *   whoever created the partition (usually a generator).
+ */
 typedef struct {
     int n;
     size_t len;
-    int a[MAXNUMP+1];
+    int *a;
 } partition_t;
 
 /*
@@ -54,11 +64,15 @@ typedef void partn_visitor_f(const partition_t *p, void *argres);
  * Generator:
  *   This is the function type for a partition generating function.
  *   `n`      - The number to be partitioned
+ *   `buf`    - A work buffer of (at least) PARTN_BUFLEN(n) ints, or
+ *              NULL to let the generator allocate one itself.
  *   `visit`  - A visitor function.
  *   `argres` - A generic pointer for argument/result for the
  *              visitor.
+ *   Returns the number of partitions generated (0 if `buf` is NULL
+ *   and the buffer could not be allocated).
  */
-typedef uint64_t partn_generator_f(int n,
+typedef uint64_t partn_generator_f(int n, int buf[],
        partn_visitor_f *visit, void *argres);
 
 
@@ -72,7 +86,10 @@ void print_partition(const partition_t *p);
 /* Print a partition with a newline. */
 void println_partition(const partition_t *p);
 
-/* Initialize a partition with an initial value for all parts. */
+/*
+ * Initialize the `p->n + 1` slots `p->a[0]`, ..., `p->a[p->n]` of a
+ * partition with an initial value.
+ */
 void init_partition(partition_t *p, int initial_val);
 
 /*
@@ -83,7 +100,10 @@ void init_partition(partition_t *p, int initial_val);
 void mk_partition(partition_t *p, const int a[],
                                 size_t start, size_t len);
 
-/* Copy partition `p` into `q`. */
+/*
+ * Copy partition `p` into `q`.  The parts are copied into the
+ * buffer of `q`, which must have room for `p->len` parts.
+ */
 void cp_partition(const partition_t *p, partition_t *q);
 
 
@@ -105,10 +125,14 @@ void cp_partition(const partition_t *p, partition_t *q);
  *       ArXiv:0909.2331, 2009,
  *       https://arxiv.org/abs/0909.2331
  */
-uint64_t rule_asc(int n, partn_visitor_f *visit, void *argres);
-uint64_t rule_desc(int n, partn_visitor_f *visit, void *argres);
-uint64_t accel_asc(int n, partn_visitor_f *visit, void *argres);
-uint64_t accel_desc(int n, partn_visitor_f *visit, void *argres);
+uint64_t rule_asc(int n, int buf[],
+        partn_visitor_f *visit, void *argres);
+uint64_t rule_desc(int n, int buf[],
+        partn_visitor_f *visit, void *argres);
+uint64_t accel_asc(int n, int buf[],
+        partn_visitor_f *visit, void *argres);
+uint64_t accel_desc(int n, int buf[],
+        partn_visitor_f *visit, void *argres);
 
 /*
  * Merca's Algorithms (ascending compositions).
@@ -119,9 +143,12 @@ uint64_t accel_desc(int n, partn_visitor_f *visit, void *argres);
  *       J Math Model Algor (2012) 11:89--104, 2012
  *       DOI:10.1007/s10852-011-9168-y
  */
-uint64_t merca1(int n, partn_visitor_f *visit, void *argres);
-uint64_t merca2(int n, partn_visitor_f *visit, void *argres);
-uint64_t merca3(int n, partn_visitor_f *visit, void *argres);
+uint64_t merca1(int n, int buf[],
+        partn_visitor_f *visit, void *argres);
+uint64_t merca2(int n, int buf[],
+        partn_visitor_f *visit, void *argres);
+uint64_t merca3(int n, int buf[],
+        partn_visitor_f *visit, void *argres);
 
 /*
  * Zoghbi-Stojmenovic's algorithms (descending compositions).
@@ -133,5 +160,70 @@ uint64_t merca3(int n, partn_visitor_f *visit, void *argres);
  *       DOI:10.1080/00207169808804755
  *       http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.42.1287&rep1&type=pdf
  */
-uint64_t zs1(int n, partn_visitor_f *visit, void *argres);
-uint64_t zs2(int n, partn_visitor_f *visit, void *argres);
+uint64_t zs1(int n, int buf[],
+        partn_visitor_f *visit, void *argres);
+uint64_t zs2(int n, int buf[],
+        partn_visitor_f *visit, void *argres);
+
+/*
+ * Subtree generator (ascending compositions, based on accel_asc):
+ *   The partitions of `n` that start with the `plen` parts `prefix`
+ *   (ascending) and continue with parts `>= lo`, where `lo` is at
+ *   least the last part of the prefix.  They are produced in the
+ *   same (lexicographically increasing) order as accel_asc, so the
+ *   subtrees of consecutive prefixes concatenate to a contiguous
+ *   stretch of the output of accel_asc.  `buf` as for generators.
+ */
+uint64_t accel_asc_subtree(int n, const int prefix[], size_t plen,
+        int lo, int buf[], partn_visitor_f *visit, void *argres);
+
+
+/*******************************************************************\
+ *  Registry                                                       *
+\*******************************************************************/
+
+/* Order of the parts in the partitions produced by a generator. */
+typedef enum {
+    PARTN_ASCENDING,
+    PARTN_DESCENDING,
+} partn_order_t;
+
+/* A named partition generator. */
+typedef struct {
+    const char *name;
+    partn_generator_f *gen;
+    partn_order_t order;
+} partn_algo_t;
+
+/* All of the generators above (in the order listed above). */
+extern const partn_algo_t partn_algos[];
+extern const size_t num_partn_algos;
+
+/* Look up a generator by name (NULL if there is no such generator). */
+const partn_algo_t *find_partn_algo(const char *name);
+
+
+/*******************************************************************\
+ *  Automatic Selection                                            *
+\*******************************************************************/
+
+/* Kind of visitor a generator is selected for. */
+typedef enum {
+    PARTN_VISIT_NONE,       /* No visitor (counting only). */
+    PARTN_VISIT_PARTS,      /* A visitor that reads the parts. */
+} partn_visit_t;
+
+/*
+ * Select the fastest generator producing partitions in `order` for
+ * visitors of kind `visit`.
+ *
+ * The candidates are micro-benchmarked the first time a combination
+ * is asked for, and the winner is cached in a profile file: the file
+ * named by the environment variable PARTN_PROFILE, or else
+ * ~/.partn_profile.  Entries are keyed by the build of this library
+ * (compiler version and build time), so a rebuild with a different
+ * compiler or optimization level is benchmarked afresh.  If the
+ * profile cannot be written, the result is only cached in memory.
+ */
+const partn_algo_t *auto_partn_algo(partn_order_t order,
+        partn_visit_t visit);
@@ -0,0 +1,479 @@
+/*
+ * partitionmodule.c - Python extension wrapping the C generators.
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   python3 setup.py build_ext --inplace   #(or, make python)
+ *
+ * Usage (Python 3, NumPy):
+ *
+ *   import cpartition
+ *   for offsets, values in cpartition.batches(60, "merca1"):
+ *       # Partition i is values[offsets[i]:offsets[i+1]].
+ *       ...
+ *   cpartition.count(60)                   # -> 966467
+ *   offsets, values = cpartition.partitions(20)
+ *
+ * The partitions are delivered as ragged arrays: `values` (int32)
+ * holds the parts of all the partitions of a batch back to back and
+ * `offsets` (int64, one longer than the number of partitions) the
+ * index at which each partition starts.  The arrays own the memory the
+ * generator wrote into, so nothing is copied and no Python object is
+ * made per partition.
+ *
+ * Generation runs in a producer thread, without the GIL, one batch
+ * ahead of the consumer.  The generators cannot be stopped from a
+ * visitor, so an iterator that is dropped before it is exhausted
+ * unwinds its producer with `longjmp` out of the visitor.  This is
+ * safe because the producer owns every buffer the generator touches.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdbool.h>
+#include <string.h>
+#include "partition.h"
+
+/* Default number of parts per batch (16 MiB of values). */
+#define DEFAULT_BATCH (1 << 22)
+
+/*******************************************************************\
+ * Batches                                                         *
+\*******************************************************************/
+
+/* A batch of partitions as ragged arrays. */
+typedef struct {
+    int64_t *offsets;   /* num + 1 entries */
+    int *values;        /* offsets[num] entries */
+    size_t num;
+} batch_t;
+
+static inline bool alloc_batch(batch_t *b, size_t cap)
+{
+    b->offsets = malloc((cap + 2) * sizeof(int64_t));
+    b->values = malloc((cap ? cap : 1) * sizeof(int));
+    b->num = 0;
+    if (b->offsets == NULL || b->values == NULL) {
+        free(b->offsets);
+        free(b->values);
+        b->offsets = NULL;
+        b->values = NULL;
+        return false;
+    }
+    b->offsets[0] = 0;
+    return true;
+}
+
+static inline void free_batch(batch_t *b)
+{
+    free(b->offsets);
+    free(b->values);
+    b->offsets = NULL;
+    b->values = NULL;
+}
+
+static void free_capsule(PyObject *capsule)
+{
+    free(PyCapsule_GetPointer(capsule, NULL));
+}
+
+/*
+ * Wrap `len` elements of `data` (of NumPy type `type`) in an array
+ * that takes ownership of `data`.  On failure `data` is freed.
+ */
+static PyObject *own_array(void *data, npy_intp len, int type)
+{
+    PyObject *arr, *capsule;
+
+    arr = PyArray_SimpleNewFromData(1, &len, type, data);
+    if (arr == NULL) {
+        free(data);
+        return NULL;
+    }
+    if ((capsule = PyCapsule_New(data, NULL, free_capsule)) == NULL) {
+        Py_DECREF(arr);
+        free(data);
+        return NULL;
+    }
+    if (PyArray_SetBaseObject((PyArrayObject *) arr, capsule)) {
+        Py_DECREF(arr);
+        return NULL;
+    }
+    return arr;
+}
+
+/* Hand a batch over to Python as a tuple (offsets, values). */
+static PyObject *batch_to_tuple(batch_t *b)
+{
+    PyObject *offsets, *values;
+
+    offsets = own_array(b->offsets, b->num + 1, NPY_INT64);
+    values = own_array(b->values, b->offsets ? b->offsets[b->num] : 0,
+            NPY_INT32);
+    b->offsets = NULL;
+    b->values = NULL;
+    if (offsets == NULL || values == NULL) {
+        Py_XDECREF(offsets);
+        Py_XDECREF(values);
+        return NULL;
+    }
+    return Py_BuildValue("(NN)", offsets, values);
+}
+
+/*******************************************************************\
+ * Batch Iterator                                                  *
+\*******************************************************************/
+
+typedef struct {
+    PyObject_HEAD
+    int n;
+    partn_generator_f *gen;
+    size_t cap;             /* Parts per batch. */
+    pthread_t thread;
+    bool started;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    /* Shared (under `lock`). */
+    batch_t ready;          /* Handed over (offsets == NULL if none). */
+    bool done;
+    bool cancel;
+    bool nomem;
+    /* Producer only. */
+    batch_t cur;
+    jmp_buf unwind;
+} BatchIter;
+
+/*
+ * Hand the current batch over to the consumer (waiting until it has
+ * taken the previous one) and start a new one.  Unwinds the producer
+ * if the iterator is being dropped or memory runs out.
+ */
+static void flush(BatchIter *it, bool last)
+{
+    pthread_mutex_lock(&it->lock);
+    while (it->ready.offsets && ! it->cancel)
+        pthread_cond_wait(&it->cond, &it->lock);
+    if (it->cancel) {
+        pthread_mutex_unlock(&it->lock);
+        longjmp(it->unwind, 1);
+    }
+    it->ready = it->cur;
+    pthread_cond_broadcast(&it->cond);
+    pthread_mutex_unlock(&it->lock);
+    it->cur.offsets = NULL;
+    it->cur.values = NULL;
+    if (! last && ! alloc_batch(&it->cur, it->cap)) {
+        pthread_mutex_lock(&it->lock);
+        it->nomem = true;
+        pthread_mutex_unlock(&it->lock);
+        longjmp(it->unwind, 1);
+    }
+}
+
+static void visit_batch(const partition_t *p, void *argres)
+{
+    BatchIter *it = argres;
+    batch_t *b = &it->cur;
+    size_t used = b->offsets[b->num];
+
+    if (used + p->len > it->cap || b->num > it->cap) {
+        flush(it, false);
+        used = 0;
+    }
+    memcpy(b->values + used, p->a, p->len * sizeof(int));
+    b->num++;
+    b->offsets[b->num] = used + p->len;
+}
+
+static void *produce(void *arg)
+{
+    BatchIter *it = arg;
+    int *buf;
+
+    if ((buf = malloc(PARTN_BUFLEN(it->n) * sizeof(int))) == NULL) {
+        pthread_mutex_lock(&it->lock);
+        it->nomem = true;
+        pthread_mutex_unlock(&it->lock);
+    } else if (setjmp(it->unwind) == 0) {
+        it->gen(it->n, buf, visit_batch, it);
+        if (it->cur.num)
+            flush(it, true);
+    }
+    free(buf);
+    free_batch(&it->cur);
+    pthread_mutex_lock(&it->lock);
+    it->done = true;
+    pthread_cond_broadcast(&it->cond);
+    pthread_mutex_unlock(&it->lock);
+    return NULL;
+}
+
+static void BatchIter_dealloc(BatchIter *it)
+{
+    if (it->started) {
+        pthread_mutex_lock(&it->lock);
+        it->cancel = true;
+        pthread_cond_broadcast(&it->cond);
+        pthread_mutex_unlock(&it->lock);
+        Py_BEGIN_ALLOW_THREADS
+        pthread_join(it->thread, NULL);
+        Py_END_ALLOW_THREADS
+    }
+    free_batch(&it->ready);
+    free_batch(&it->cur);
+    pthread_mutex_destroy(&it->lock);
+    pthread_cond_destroy(&it->cond);
+    Py_TYPE(it)->tp_free((PyObject *) it);
+}
+
+static PyObject *BatchIter_next(BatchIter *it)
+{
+    batch_t b = {NULL, NULL, 0};
+    bool nomem;
+
+    if (! it->started) {
+        if (! alloc_batch(&it->cur, it->cap))
+            return PyErr_NoMemory();
+        if (pthread_create(&it->thread, NULL, produce, it)) {
+            free_batch(&it->cur);
+            PyErr_SetString(PyExc_RuntimeError,
+                    "cannot start the generator thread");
+            return NULL;
+        }
+        it->started = true;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&it->lock);
+    while (! it->ready.offsets && ! it->done)
+        pthread_cond_wait(&it->cond, &it->lock);
+    b = it->ready;
+    it->ready.offsets = NULL;
+    it->ready.values = NULL;
+    nomem = it->nomem;
+    pthread_cond_broadcast(&it->cond);
+    pthread_mutex_unlock(&it->lock);
+    Py_END_ALLOW_THREADS
+    if (b.offsets)
+        return batch_to_tuple(&b);
+    if (nomem)
+        return PyErr_NoMemory();
+    return NULL;    /* StopIteration */
+}
+
+static PyTypeObject BatchIterType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "cpartition.BatchIterator",
+    .tp_basicsize = sizeof(BatchIter),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Iterator over batches (offsets, values) of partitions.",
+    .tp_dealloc = (destructor) BatchIter_dealloc,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc) BatchIter_next,
+};
+
+/*******************************************************************\
+ * Module Functions                                                *
+\*******************************************************************/
+
+/*
+ * Look up a generator ("auto", "auto_asc" or "auto_desc" select the
+ * fastest one, see auto_partn_algo).  Sets an exception on failure.
+ */
+static partn_generator_f *lookup(const char *name, partn_visit_t visit)
+{
+    const partn_algo_t *algo;
+
+    if (strcmp(name, "auto") == 0 || strcmp(name, "auto_asc") == 0)
+        algo = auto_partn_algo(PARTN_ASCENDING, visit);
+    else if (strcmp(name, "auto_desc") == 0)
+        algo = auto_partn_algo(PARTN_DESCENDING, visit);
+    else
+        algo = find_partn_algo(name);
+    if (algo == NULL) {
+        PyErr_Format(PyExc_ValueError, "unknown algorithm: %s", name);
+        return NULL;
+    }
+    return algo->gen;
+}
+
+static PyObject *cp_batches(PyObject *self, PyObject *args,
+        PyObject *kwds)
+{
+    static char *kwlist[] = {"n", "algorithm", "batch", NULL};
+    const char *name = "auto";
+    Py_ssize_t batch = DEFAULT_BATCH;
+    BatchIter *it;
+    partn_generator_f *gen;
+    int n;
+
+    if (! PyArg_ParseTupleAndKeywords(args, kwds, "i|sn", kwlist,
+                &n, &name, &batch))
+        return NULL;
+    if (n < 0) {
+        PyErr_SetString(PyExc_ValueError, "n must be non-negative");
+        return NULL;
+    }
+    if (batch < 1)
+        batch = 1;
+    if (batch < n)
+        batch = n;
+    if ((gen = lookup(name, PARTN_VISIT_PARTS)) == NULL)
+        return NULL;
+    if ((it = PyObject_New(BatchIter, &BatchIterType)) == NULL)
+        return NULL;
+    it->n = n;
+    it->gen = gen;
+    it->cap = batch;
+    it->started = false;
+    it->done = false;
+    it->cancel = false;
+    it->nomem = false;
+    it->ready = (batch_t) {NULL, NULL, 0};
+    it->cur = (batch_t) {NULL, NULL, 0};
+    pthread_mutex_init(&it->lock, NULL);
+    pthread_cond_init(&it->cond, NULL);
+    return (PyObject *) it;
+}
+
+/* Visitor appending to one growing batch (for `partitions`). */
+typedef struct {
+    batch_t b;
+    size_t cap_parts;
+    size_t cap_values;
+    bool nomem;
+} grow_t;
+
+static void visit_grow(const partition_t *p, void *argres)
+{
+    grow_t *g = argres;
+    size_t used = g->b.offsets[g->b.num];
+    void *tmp;
+
+    if (g->nomem)
+        return;
+    if (g->b.num + 2 > g->cap_parts) {
+        g->cap_parts *= 2;
+        if ((tmp = realloc(g->b.offsets,
+                        g->cap_parts * sizeof(int64_t))) == NULL) {
+            g->nomem = true;
+            return;
+        }
+        g->b.offsets = tmp;
+    }
+    if (used + p->len > g->cap_values) {
+        g->cap_values = 2 * (used + p->len);
+        if ((tmp = realloc(g->b.values,
+                        g->cap_values * sizeof(int))) == NULL) {
+            g->nomem = true;
+            return;
+        }
+        g->b.values = tmp;
+    }
+    memcpy(g->b.values + used, p->a, p->len * sizeof(int));
+    g->b.num++;
+    g->b.offsets[g->b.num] = used + p->len;
+}
+
+static PyObject *cp_partitions(PyObject *self, PyObject *args,
+        PyObject *kwds)
+{
+    static char *kwlist[] = {"n", "algorithm", NULL};
+    const char *name = "auto";
+    partn_generator_f *gen;
+    grow_t g;
+    int n;
+
+    if (! PyArg_ParseTupleAndKeywords(args, kwds, "i|s", kwlist,
+                &n, &name))
+        return NULL;
+    if (n < 0) {
+        PyErr_SetString(PyExc_ValueError, "n must be non-negative");
+        return NULL;
+    }
+    if ((gen = lookup(name, PARTN_VISIT_PARTS)) == NULL)
+        return NULL;
+    g.cap_parts = 1024;
+    g.cap_values = 1024;
+    g.nomem = false;
+    if (! alloc_batch(&g.b, g.cap_values))
+        return PyErr_NoMemory();
+    Py_BEGIN_ALLOW_THREADS
+    gen(n, NULL, visit_grow, &g);
+    Py_END_ALLOW_THREADS
+    if (g.nomem) {
+        free_batch(&g.b);
+        return PyErr_NoMemory();
+    }
+    return batch_to_tuple(&g.b);
+}
+
+static PyObject *cp_count(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"n", "algorithm", NULL};
+    const char *name = "auto";
+    partn_generator_f *gen;
+    uint64_t count;
+    int n;
+
+    if (! PyArg_ParseTupleAndKeywords(args, kwds, "i|s", kwlist,
+                &n, &name))
+        return NULL;
+    if ((gen = lookup(name, PARTN_VISIT_NONE)) == NULL)
+        return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    count = gen(n, NULL, NULL, NULL);
+    Py_END_ALLOW_THREADS
+    return PyLong_FromUnsignedLongLong(count);
+}
+
+static PyObject *cp_algorithms(PyObject *self, PyObject *unused)
+{
+    PyObject *list = PyList_New(num_partn_algos);
+
+    if (list == NULL)
+        return NULL;
+    for (size_t i = 0; i < num_partn_algos; i++)
+        PyList_SET_ITEM(list, i, PyUnicode_FromString(partn_algos[i].name));
+    return list;
+}
+
+static PyMethodDef cp_methods[] = {
+    {"batches", (PyCFunction) cp_batches, METH_VARARGS | METH_KEYWORDS,
+     "batches(n, algorithm='auto', batch=4194304)\n\n"
+     "Iterate over the partitions of n in batches (offsets, values) of\n"
+     "at most `batch` parts; partition i of a batch is\n"
+     "values[offsets[i]:offsets[i+1]]."},
+    {"partitions", (PyCFunction) cp_partitions,
+     METH_VARARGS | METH_KEYWORDS,
+     "partitions(n, algorithm='auto')\n\n"
+     "All the partitions of n as one pair (offsets, values)."},
+    {"count", (PyCFunction) cp_count, METH_VARARGS | METH_KEYWORDS,
+     "count(n, algorithm='auto')\n\nThe number of partitions of n."},
+    {"algorithms", cp_algorithms, METH_NOARGS,
+     "algorithms()\n\nNames of the available generators."},
+    {NULL, NULL, 0, NULL},
+};
+
+static struct PyModuleDef cp_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "cpartition",
+    .m_doc = "Fast integer partition generators (C, NumPy batches).",
+    .m_size = -1,
+    .m_methods = cp_methods,
+};
+
+PyMODINIT_FUNC PyInit_cpartition(void)
+{
+    import_array();
+    if (PyType_Ready(&BatchIterType) < 0)
+        return NULL;
+    return PyModule_Create(&cp_module);
+}
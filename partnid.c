@@ -3,13 +3,14 @@
  *
  * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
  * Created:  2016-07-15
- * Modified: 2016-07-15
+ * Modified: 2026-10-18
  * License:  MIT License (see LICENSE.txt)
  *
  * Compilation Suggestions:
  *   CC = gcc #(or clang)
  *   CFLAGS = -std=gnu11 -Ofast #(or, -O2, -O3)
- *   OBJS = qseries.o util.o
+ *   OBJS = partition.o pcache.o qexpr.o qseries.o shard.o topology.o \
+ *          util.o vdb.o
  *   LIBS = -lpthread
  *   $(CC) $(CFLAGS) -o partnid partnid.c $(OBJS) $(LIBS)
  *
@@ -25,34 +26,51 @@
 #include <stdbool.h>
 #include <inttypes.h>
 #include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include "partition.h"
+#include "pcache.h"
+#include "qexpr.h"
 #include "qseries.h"
+#include "shard.h"
+#include "topology.h"
 #include "util.h"
+#include "vdb.h"
 
 /*******************************************************************\
  * MACRO DEFINITIONS                                               *
 \*******************************************************************/
 
-#define MAXN 199
-#define MAXNUMP MAXN
-#define NUMTHREADS 8
+/* Default seconds between progress reports (see --progress). */
+#define PROGRESS_INTERVAL 10
+/* Partitions between publications of the progress of a thread. */
+#define PROGRESS_BATCH 65536
+/* Sum sides in the fingerprint of the filter (see --db). */
+#define FINGERPRINT_N 20
 
 #define PSIDEF pside_new_06
+#define HSIDEF hside_none
 #define FILTER_PARTN filter_new_06
-#define GEN_PARTN merca3
+/* Version of FILTER_PARTN in the database (--db): change it with it. */
+#define FILTER_SPEC "1"
+#define GEN_PARTN filtered_merca3
+
+#define XSTR(x) #x
+#define STR(x) XSTR(x)
+/* Name of the program (and identity) in result files. */
+#define PROGRAM ("partnid:" STR(FILTER_PARTN))
 
 /*******************************************************************\
  * PARTITION (HEADER)                                              *
 \*******************************************************************/
 
-typedef struct {
-    int n;
-    size_t len;
-    int a[MAXNUMP+1];
-} partition_t;
+/* Progress of a thread, see PROGRESS. */
+typedef struct progress progress_t;
 
-static inline void print_partition(const partition_t *p);
-static inline void println_partition(const partition_t *p);
-static inline uint64_t merca3(int n);
+static inline uint64_t filtered_merca3(int n, progress_t *pg);
+static inline uint64_t filtered_shard(int n, progress_t *pg);
 
 static inline bool filter_none(const partition_t *p);
 static inline bool filter_new_01(const partition_t *p);
@@ -70,21 +88,29 @@ static inline bool filter_new_10(const partition_t *p);
 static inline bool filter_new_11(const partition_t *p);
 static inline bool filter_new_12(const partition_t *p);
 
-static inline void pside_none(qseries_t s);
-static inline void pside_new_01(qseries_t s);
-static inline void pside_new_02(qseries_t s);
-static inline void pside_new_03(qseries_t s);
-static inline void pside_new_04(qseries_t s);
-static inline void pside_new_05(qseries_t s);
-static inline void pside_new_06(qseries_t s);
-static inline void pside_new_6x(qseries_t s);
-static inline void pside_new_6y(qseries_t s);
-static inline void pside_new_07(qseries_t s);
-static inline void pside_new_08(qseries_t s);
-static inline void pside_new_09(qseries_t s);
-static inline void pside_new_10(qseries_t s);
-static inline void pside_new_11(qseries_t s);
-static inline void pside_new_12(qseries_t s);
+static inline void make_product_side(void);
+static inline void set_product_side(int mod, const int cong[mod],
+        qseries_t *s);
+static inline int64_t prod_coef(int n);
+
+static inline void pside_none(qseries_t *s);
+static inline bool hside_none(qseries_t *s);
+static inline bool hside_rr1(qseries_t *s);
+static inline bool hside_rr2(qseries_t *s);
+static inline void pside_new_01(qseries_t *s);
+static inline void pside_new_02(qseries_t *s);
+static inline void pside_new_03(qseries_t *s);
+static inline void pside_new_04(qseries_t *s);
+static inline void pside_new_05(qseries_t *s);
+static inline void pside_new_06(qseries_t *s);
+static inline void pside_new_6x(qseries_t *s);
+static inline void pside_new_6y(qseries_t *s);
+static inline void pside_new_07(qseries_t *s);
+static inline void pside_new_08(qseries_t *s);
+static inline void pside_new_09(qseries_t *s);
+static inline void pside_new_10(qseries_t *s);
+static inline void pside_new_11(qseries_t *s);
+static inline void pside_new_12(qseries_t *s);
 
 /*******************************************************************\
  * OTHER (HEADER)                                                  *
@@ -97,12 +123,18 @@ typedef enum {
     E_SCAN_FAILURE,
     E_OUT_OF_RANGE,
     E_THREAD_FAILURE,
+    E_OUT_OF_MEMORY,
+    E_IO_FAILURE,
+    E_BAD_RESULT,
+    E_DISCREPANCY,
 } error_t;
 
 typedef enum {
     COMMAND_HELP,
     COMMAND_SHOW,
     COMMAND_VERIFY,
+    COMMAND_REPORT,
+    COMMAND_PRODMAKE,
 } command_t;
 
 typedef enum {
@@ -118,22 +150,125 @@ static inline error_t parse_args(
         command_t *com_p,
         int *n_p);
 
+static inline void alloc_sides(int N);
 static inline void show(int n);
-static inline void verify(int N);
-static inline void report(int N);
-
+static inline error_t verify(int N, bool product_form);
+static inline bool report(int N);
+static inline void report_product_form(int N);
+static inline void write_result(int N);
+static inline void load_db(int N);
+static inline void store_db(int n, int64_t sum, uint64_t count,
+        uint64_t ns);
+static inline error_t report_result(const char *path);
+
+static inline void plan_groups(int N);
 static inline void *run_thread(void *arg);
 
+static inline void start_monitor(int N);
+static inline void stop_monitor(void);
+static inline bool cancelled(int n);
+static inline void fail_at(int n);
+static inline double partitions(int n);
+
 /*******************************************************************\
  * GLOBAL VARIABLES                                                *
 \*******************************************************************/
 
-static int64_t sum_side[MAXN+1];
+static int64_t *sum_side;
 static qseries_t prod_side;
-static int64_t diff[MAXN+1];
-static int current;
+/* Analytic sum side (HSIDEF), if the identity has one. */
+static qseries_t hyper_side;
+static bool have_hside;
+static int64_t *diff;
 static action_t action;
 
+/*
+ * Progress of a thread.  The thread publishes the number of
+ * partitions it has visited now and then (not for every partition)
+ * and the monitor samples it; each one is on a cache line of its own.
+ * It also holds the work group of the thread.
+ */
+struct progress {
+    int n;                  /* Current task (-1 if none). */
+    double task_total;      /* Partitions in the task (approximate). */
+    uint64_t task_start;    /* `visited` when the task started. */
+    uint64_t visited;       /* Partitions visited by the thread. */
+    int group;              /* Its work group. */
+    int cpu;                /* CPU it is pinned to (-1 if not pinned). */
+    int64_t *sums;          /* Sum side of its group. */
+} __attribute__((aligned(CACHE_LINE)));
+
+/* Threads (--threads, default: the online CPUs) and their progress. */
+static int num_threads;
+static progress_t *progress;
+
+/*
+ * A work group: the tasks (n) run by the threads pinned to one
+ * socket, and the sum side they count into.  Threads take the tasks
+ * of their own group first and then help the other groups.  Without
+ * --pin (or on one socket) there is a single group, and its sum side
+ * is `sum_side` itself.
+ */
+typedef struct {
+    int next;           /* Index of the next task in `tasks`. */
+    int num_tasks;
+    int *tasks;         /* Decreasing n (increasing with --fail-fast). */
+    int threads;        /* Threads in the group. */
+    int leader;         /* Thread allocating `sums` (on its socket). */
+    double load;        /* Partitions per thread (for planning). */
+    int64_t *sums;
+} __attribute__((aligned(CACHE_LINE))) group_t;
+
+static bool pin;                /* --pin */
+static topology_t topo;
+static int num_groups;
+static group_t *groups;
+static pthread_barrier_t groups_ready;
+
+/* Sharded verification (see shard.h). */
+static int shard, shards;
+static const char *result_path;
+static shard_row_t *rows;
+
+/* Progress reports (see PROGRESS). */
+static int progress_interval = PROGRESS_INTERVAL;
+static const char *status_path;
+
+/*
+ * Fail-fast verification (--fail-fast): the tasks are run in
+ * increasing n and the first n found with a discrepancy cancels all
+ * the tasks for larger n.
+ */
+static bool fail_fast;
+static int first_failure = INT_MAX;
+
+/*
+ * With --fail-fast the product side is lazy (see lazy_qseries_t), so
+ * that it is only computed up to the first discrepancy; the threads
+ * read it through `prod_coef`.  If it fails (a coefficient beyond 64
+ * bits), the full product side of (`lazy_mod`, `lazy_cong`) is made
+ * instead, wrapping modulo 2^64 as without --fail-fast.
+ */
+static lazy_qseries_t lazy_prod;
+static pthread_mutex_t lazy_prod_lock = PTHREAD_MUTEX_INITIALIZER;
+static int lazy_mod;
+static int *lazy_cong;
+static bool lazy_dense;     /* Read `prod_side` instead. */
+
+/* Product side given as an expression (--pside, see qexpr.h). */
+static const char *pside_expr;
+
+/*
+ * Database of verified sum sides (--db, see vdb.h): the n found there
+ * (`stored[n]`) are not counted again, the others are added to it.
+ * Its spec is PROGRAM, FILTER_SPEC and a fingerprint of the filter
+ * (see `filter_fingerprint`).
+ */
+static const char *db_path;
+static char db_spec[128];
+static vdb_t db;
+static bool *stored;
+
 /*******************************************************************\
  * FUNCTION DEFINITIONS                                            *
 \*******************************************************************/
@@ -161,8 +296,11 @@ int main(int argc, char *argv[]) {
             show(n);
             break;
         case COMMAND_VERIFY:
-            verify(n);
-            break;
+            return verify(n, false);
+        case COMMAND_PRODMAKE:
+            return verify(n, true);
+        case COMMAND_REPORT:
+            return report_result(result_path);
         default:
             usage(argv[0]);
             exit(E_UNKNOWN_COMMAND);
@@ -178,13 +316,50 @@ static inline void usage(const char *com)
     fprintf(stderr, "Check partition identities (need to recompile");
     fprintf(stderr, " for different identities).\n\n");
     fprintf(stderr, "Usage:\n");
-    fprintf(stderr, "  %s [ show N | verify N | help ]\n\n", com);
+    fprintf(stderr, "  %s [ show N | verify N [OPTIONS] | report FILE "
+            "|\n\t\tprodmake N [OPTIONS] | help ]\n\n", com);
     fprintf(stderr, "Commands:\n");
     fprintf(stderr, "  show");
-    fprintf(stderr, "\t\tShow the sumside for N (0-199).\n");
+    fprintf(stderr, "\t\tShow the sumside for N.\n");
     fprintf(stderr, "  verify");
-    fprintf(stderr, "\tVerify partition identity upto N (0-199).\n");
-    fprintf(stderr, "  help\t\tShow this help.\n");
+    fprintf(stderr, "\tVerify partition identity upto N.\n");
+    fprintf(stderr, "  report");
+    fprintf(stderr, "\tVerify with the sum side from a (merged) result ");
+    fprintf(stderr, "file.\n");
+    fprintf(stderr, "  prodmake");
+    fprintf(stderr, "\tFind the product form of the sum side upto N ");
+    fprintf(stderr, "(the period\n\t\tand cong[] of a pside).\n");
+    fprintf(stderr, "  help\t\tShow this help.\n\n");
+    fprintf(stderr, "Options (verify, and all but --shard, --result ");
+    fprintf(stderr, "and --fail-fast for prodmake):\n");
+    fprintf(stderr, "  --shard I/K\tOnly shard I (0 <= I < K) of K of the ");
+    fprintf(stderr, "partitions of each n.\n");
+    fprintf(stderr, "  --result FILE\tResult file for partnmerge ");
+    fprintf(stderr, "(default:\n\t\tpartnid-N.shard-I-of-K).\n");
+    fprintf(stderr, "  --progress SECS\tReport the progress to stderr ");
+    fprintf(stderr, "every SECS seconds\n\t\t(default: %d; 0: only ",
+            PROGRESS_INTERVAL);
+    fprintf(stderr, "on SIGUSR1).\n");
+    fprintf(stderr, "  --status FILE\tAlso write the progress as JSON ");
+    fprintf(stderr, "to FILE.\n");
+    fprintf(stderr, "  --fail-fast\tGo through n in increasing order ");
+    fprintf(stderr, "and stop at the first\n\t\tdiscrepancy ");
+    fprintf(stderr, "(not with --shard).\n");
+    fprintf(stderr, "  --threads T\tNumber of threads (default: the ");
+    fprintf(stderr, "online CPUs, %d).\n", online_cpus());
+    fprintf(stderr, "  --db FILE\tTake the sum sides known in the ");
+    fprintf(stderr, "database FILE, and\n\t\tadd the new ones to it ");
+    fprintf(stderr, "(not with --shard).\n");
+    fprintf(stderr, "  --pside EXPR\tThe product side as an expression, ");
+    fprintf(stderr, "e.g. '1/(q,q^4;q^5)_inf'\n\t\t(see qexpr.h), ");
+    fprintf(stderr, "instead of the one compiled in.\n");
+    fprintf(stderr, "  --pin\t\tPin the threads to CPUs, filling one ");
+    fprintf(stderr, "socket at a time,\n\t\tand group the work and ");
+    fprintf(stderr, "the sums by socket.\n\n");
+    fprintf(stderr, "Exit status of verify (except with --shard) and ");
+    fprintf(stderr, "report: 0 if the sides\nagree upto N, %d if ",
+            E_DISCREPANCY);
+    fprintf(stderr, "there is a discrepancy (a non-zero diff).\n");
 }
 
 static inline error_t parse_args(
@@ -203,96 +378,553 @@ static inline error_t parse_args(
             return E_WRONG_NUM_ARGS;
         if (! sscanf(argv[2], "%d", n_p))
             return E_SCAN_FAILURE;
-        if (*n_p < 0 || *n_p > MAXN)
+        if (*n_p < 0)
             return E_OUT_OF_RANGE;
-    } else if (strcmp(argv[1], "verify") == 0) {
-        *com_p = COMMAND_VERIFY;
+    } else if (strcmp(argv[1], "verify") == 0 ||
+            strcmp(argv[1], "prodmake") == 0) {
+        *com_p = (argv[1][0] == 'v') ? COMMAND_VERIFY : COMMAND_PRODMAKE;
         if (argc < 3)
             return E_WRONG_NUM_ARGS;
         if (! sscanf(argv[2], "%d", n_p))
             return E_SCAN_FAILURE;
-        if (*n_p < 0 || *n_p > MAXN)
+        if (*n_p < 0)
             return E_OUT_OF_RANGE;
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "--shard") == 0 && i + 1 < argc) {
+                if (! parse_shard(argv[++i], &shard, &shards))
+                    return E_OUT_OF_RANGE;
+            } else if (strcmp(argv[i], "--result") == 0 && i + 1 < argc) {
+                result_path = argv[++i];
+            } else if (strcmp(argv[i], "--progress") == 0 &&
+                    i + 1 < argc) {
+                if (sscanf(argv[++i], "%d", &progress_interval) != 1 ||
+                        progress_interval < 0)
+                    return E_OUT_OF_RANGE;
+            } else if (strcmp(argv[i], "--status") == 0 && i + 1 < argc) {
+                status_path = argv[++i];
+            } else if (strcmp(argv[i], "--fail-fast") == 0) {
+                fail_fast = true;
+            } else if (strcmp(argv[i], "--threads") == 0 &&
+                    i + 1 < argc) {
+                if (sscanf(argv[++i], "%d", &num_threads) != 1 ||
+                        num_threads < 1)
+                    return E_OUT_OF_RANGE;
+            } else if (strcmp(argv[i], "--pin") == 0) {
+                pin = true;
+            } else if (strcmp(argv[i], "--db") == 0 && i + 1 < argc) {
+                db_path = argv[++i];
+            } else if (strcmp(argv[i], "--pside") == 0 && i + 1 < argc) {
+                pside_expr = argv[++i];
+            } else {
+                return E_UNKNOWN_COMMAND;
+            }
+        }
+        if (result_path && ! shards)
+            shards = 1;
+        if ((fail_fast || db_path) && shards)
+            return E_UNKNOWN_COMMAND;
+        if (*com_p == COMMAND_PRODMAKE && (fail_fast || shards))
+            return E_UNKNOWN_COMMAND;
+    } else if (strcmp(argv[1], "report") == 0) {
+        *com_p = COMMAND_REPORT;
+        if (argc < 3)
+            return E_WRONG_NUM_ARGS;
+        result_path = argv[2];
     } else {
         return E_UNKNOWN_COMMAND;
     }
     return E_SUCCESS;
 }
 
+static inline void alloc_sides(int N)
+{
+    sum_side = calloc(N + 1, sizeof(int64_t));
+    diff = calloc(N + 1, sizeof(int64_t));
+    if (sum_side == NULL || diff == NULL ||
+            alloc_qseries(&prod_side, N + 1) ||
+            alloc_qseries(&hyper_side, N + 1)) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+}
+
 static inline void show(int n)
 {
 #ifdef DEBUG
     fprintf(stderr, "show(n=%d): entering...\n", n);
 #endif
-    PSIDEF(prod_side);
+    alloc_sides(n);
+    make_product_side();
     action = ACTION_PRINT;
-    GEN_PARTN(n);
+    GEN_PARTN(n, NULL);
     printf("\n");
-    diff[n] = sum_side[n] - prod_side[n];
-    printf("n=%d  s(n)=%" PRId64 "  p(n)=%" PRId64 "  diff=%" PRId64 "\n",
-            n, sum_side[n], prod_side[n], diff[n]);
+    diff[n] = sum_side[n] - prod_side.c[n];
+    printf("n=%d  s(n)=%" PRId64, n, sum_side[n]);
+    if (have_hside)
+        printf("  h(n)=%" PRId64, hyper_side.c[n]);
+    printf("  p(n)=%" PRId64 "  diff=%" PRId64 "\n", prod_side.c[n],
+            diff[n]);
 #ifdef DEBUG
     fprintf(stderr, "show(n=%d): exiting...\n", n);
 #endif
 }
 
-static inline void verify(int N)
+/*
+ * Count the sum side upto N and report it against the product side,
+ * or (`product_form`) report its product form.
+ */
+static inline error_t verify(int N, bool product_form)
 {
 #ifdef DEBUG
     fprintf(stderr, "verify(N=%d): entering...\n", N);
 #endif
-    PSIDEF(prod_side);
+    alloc_sides(N);
+    make_product_side();
     action = ACTION_NONE;
-    current = N;
-    pthread_t threads[NUMTHREADS];
-    int ids[NUMTHREADS];
-    for (int t = 0; t < NUMTHREADS; t++) {
+    if (num_threads < 1)
+        num_threads = online_cpus();
+    if ((shards && (rows = calloc(N + 1, sizeof(shard_row_t))) == NULL) ||
+            (progress = aligned_alloc(CACHE_LINE,
+                num_threads * sizeof(progress_t))) == NULL ||
+            (pin && read_topology(&topo))) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    memset(progress, 0, num_threads * sizeof(progress_t));
+    pthread_t threads[num_threads];
+    int ids[num_threads];
+    load_db(N);
+    start_monitor(N);
+    plan_groups(N);
+    for (int t = 0; t < num_threads; t++) {
         ids[t] = t;
         if (pthread_create(&threads[t], NULL, run_thread, &ids[t])) {
             fprintf(stderr, "[ERR] Failed to create thread!\n");
             exit(E_THREAD_FAILURE);
         }
     }
-    for (int t = 0; t < NUMTHREADS; t++)
+    for (int t = 0; t < num_threads; t++)
         pthread_join(threads[t], NULL);
-    report(N);
+    stop_monitor();
+    for (int g = 0; g < num_groups; g++) {
+        if (groups[g].sums != sum_side) {
+            for (int n = 0; n <= N; n++)
+                sum_side[n] += groups[g].sums[n];
+            free(groups[g].sums);
+        }
+        free(groups[g].tasks);
+    }
+    pthread_barrier_destroy(&groups_ready);
+    free(groups);
+    free(progress);
+    free_topology(&topo);
+    if (db_path)
+        vdb_close(&db);
+    free(stored);
+    if (fail_fast) {
+        for (int n = 0; n <= N && n <= first_failure; n++)
+            prod_side.c[n] = prod_coef(n);
+        free_lazy_qseries(&lazy_prod);
+        free(lazy_cong);
+    }
+    if (shards) {
+        write_result(N);
+    } else if (first_failure <= N) {
+        report(first_failure);
+        printf("First discrepancy at n = %d (n > %d cancelled).\n",
+                first_failure, first_failure);
+        return E_DISCREPANCY;
+    } else if (product_form) {
+        report_product_form(N);
+    } else if (report(N)) {
+        for (int n = 0; have_hside && n <= N; n++) {
+            if (hyper_side.c[n] != prod_side.c[n]) {
+                printf("The analytic sum side differs at n = %d.\n", n);
+                break;
+            }
+        }
+        return E_DISCREPANCY;
+    }
 #ifdef DEBUG
     fprintf(stderr, "verify(N=%d): exiting...\n", N);
 #endif
+    return E_SUCCESS;
 }
 
-static inline void report(int N)
+/* Print the sides upto N; returns whether any of them differ. */
+static inline bool report(int N)
 {
+    bool bad = false;
+
 #ifdef DEBUG
     fprintf(stderr, "report(N=%d): entering...\n", N);
 #endif
-    printf("  %3s %13s %13s %13s\n", "n", "s(n)", "p(n)", "diff");
-    for (int i = 0; i < 47; i++)
+    printf("  %3s %13s", "n", "s(n)");
+    if (have_hside)
+        printf(" %13s", "h(n)");
+    printf(" %13s %13s\n", "p(n)", "diff");
+    for (int i = 0; i < 47 + 14 * have_hside; i++)
         printf("=");
     printf("\n");
     for (int n = 0; n <= N; n++) {
-        if ((diff[n] = sum_side[n] - prod_side[n]))
+        if ((diff[n] = sum_side[n] - prod_side.c[n]) ||
+                (have_hside && hyper_side.c[n] != prod_side.c[n])) {
             printf("**");
-        else
+            bad = true;
+        } else {
             printf("  ");
-        printf("%3d %13" PRId64 " %13" PRId64 " %13" PRId64 "\n",
-               n, sum_side[n], prod_side[n], diff[n]);
+        }
+        printf("%3d %13" PRId64, n, sum_side[n]);
+        if (have_hside)
+            printf(" %13" PRId64, hyper_side.c[n]);
+        printf(" %13" PRId64 " %13" PRId64 "\n", prod_side.c[n], diff[n]);
     }
 #ifdef DEBUG
     fprintf(stderr, "report(N=%d): exiting...\n", N);
 #endif
+    return bad;
+}
+
+/*
+ * Print the exponents a(n) of the product form of the sum side (see
+ * `prodmake`) and, if they are periodic, the cong[] of a pside.
+ */
+static inline void report_product_form(int N)
+{
+    qseries_t s;
+    int64_t *a;
+    int *cong, mod;
+
+    s.ord = N + 1;
+    s.c = sum_side;
+    if ((a = malloc((N + 1) * sizeof(int64_t))) == NULL ||
+            (cong = malloc((N + 1) * sizeof(int))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    if (prodmake(&s, a)) {
+        printf("No product form (the exponents are not integers).\n");
+        free(a);
+        free(cong);
+        return;
+    }
+    printf("Sum side = Product over n of (1 - q^n)^(-a(n)) upto q^%d:\n",
+            N);
+    printf("  a(1..%d) =", N);
+    for (int n = 1; n <= N; n++)
+        printf(" %" PRId64, a[n]);
+    printf("\n");
+    if ((mod = prodmake_cong(N + 1, a, N, cong)) == 0) {
+        printf("No period seen twice upto n = %d.\n", N);
+    } else {
+        printf("Period %d:\n", mod);
+        printf("    int mod = %d;\n    int cong[%d] = {", mod, mod);
+        for (int r = 0; r < mod; r++)
+            printf("%s%d", r ? ", " : "", cong[r]);
+        printf("};\n");
+        for (int r = 0; r < mod; r++)
+            if (cong[r] != 0 && cong[r] != -1)
+                mod = 0;
+        if (mod) {
+            /* The usual kind: some residues forbidden, others not. */
+            printf("    /* Forbidden: parts cong to");
+            for (int r = 0, k = 0; r < mod; r++)
+                if (cong[r] == 0)
+                    printf("%s %d", k++ ? "," : "", r);
+            printf(" (mod %d) */\n", mod);
+        }
+    }
+    free(a);
+    free(cong);
+}
+
+static void fingerprint_visit(const partition_t *p, void *argres)
+{
+    if (FILTER_PARTN(p))
+        ++*(int64_t *) argres;
+}
+
+/*
+ * Fingerprint of the filter: a hash of its sum side upto
+ * FINGERPRINT_N, counted afresh on every run (in about a
+ * millisecond), so that the records of a filter edited since are not
+ * taken even if FILTER_SPEC was not changed, as long as the edit shows
+ * up to FINGERPRINT_N.
+ */
+static inline uint64_t filter_fingerprint(void)
+{
+    int64_t sums[FINGERPRINT_N + 1] = {0};
+
+    for (int n = 0; n <= FINGERPRINT_N; n++) {
+        if (accel_asc(n, NULL, fingerprint_visit, &sums[n]) == 0) {
+            fprintf(stderr, "[ERR] Out of memory!\n");
+            exit(E_OUT_OF_MEMORY);
+        }
+    }
+    return fnv1a(FNV1A_BASIS, sums, sizeof(sums));
+}
+
+/*
+ * Open the database (if any) and take the sum sides it has for this
+ * identity; a known discrepancy counts for --fail-fast.
+ */
+static inline void load_db(int N)
+{
+    vdb_record_t *rec;
+    int found;
+
+    if ((stored = calloc(N + 1, sizeof(bool))) == NULL ||
+            (rec = malloc((N + 1) * sizeof(vdb_record_t))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    if (db_path == NULL) {
+        free(rec);
+        return;
+    }
+    snprintf(db_spec, sizeof(db_spec), "%s:%s:%016" PRIx64, PROGRAM,
+            FILTER_SPEC, filter_fingerprint());
+    if (vdb_open(&db, db_path, db_spec) ||
+            (found = vdb_load(&db, N, rec, stored)) < 0) {
+        fprintf(stderr, "[ERR] Cannot open the database %s!\n", db_path);
+        exit(E_IO_FAILURE);
+    }
+    for (int n = 0; n <= N; n++) {
+        if (! stored[n])
+            continue;
+        sum_side[n] = rec[n].sum;
+        if (fail_fast && sum_side[n] != prod_coef(n))
+            fail_at(n);
+    }
+    printf("Database %s: %d of n = 0, ..., %d known.\n", db_path, found,
+            N);
+    free(rec);
+}
+
+/* Append the sum side of task `n` to the database. */
+static inline void store_db(int n, int64_t sum, uint64_t count,
+        uint64_t ns)
+{
+    vdb_record_t r = {n, sum, count, ns, 0};
+
+    if (vdb_append(&db, &r))
+        fprintf(stderr, "[WARN] Cannot write n = %d to %s.\n", n,
+                db_path);
+}
+
+static inline void write_result(int N)
+{
+    char name[64];
+    const char *path = result_path;
+    shard_result_t res;
+
+    if (alloc_shard_result(&res, PROGRAM, shard, shards, N + 1)) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    memcpy(res.rows, rows, (N + 1) * sizeof(shard_row_t));
+    if (path == NULL) {
+        snprintf(name, sizeof(name), "partnid-%d.shard-%d-of-%d",
+                N, shard, shards);
+        path = name;
+    }
+    if (write_shard_result(path, &res)) {
+        fprintf(stderr, "[ERR] Cannot write %s!\n", path);
+        exit(E_IO_FAILURE);
+    }
+    printf("Shard %d/%d of n = 0, ..., %d written to %s.\n",
+            shard, shards, N, path);
+    free_shard_result(&res);
+}
+
+static inline error_t report_result(const char *path)
+{
+    bool bad;
+
+    shard_result_t res;
+    bool *seen;
+    int N = -1;
+
+    if (read_shard_result(path, &res))
+        exit(E_BAD_RESULT);
+    if (strcmp(res.program, PROGRAM)) {
+        fprintf(stderr, "[ERR] %s: results of %s, not %s!\n",
+                path, res.program, PROGRAM);
+        exit(E_BAD_RESULT);
+    }
+    for (size_t r = 0; r < res.num_rows; r++)
+        if (res.rows[r].n > N)
+            N = res.rows[r].n;
+    if (N < 0) {
+        fprintf(stderr, "[ERR] %s: no results!\n", path);
+        exit(E_BAD_RESULT);
+    }
+    alloc_sides(N);
+    if ((seen = calloc(N + 1, sizeof(bool))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    for (size_t r = 0; r < res.num_rows; r++) {
+        const shard_row_t *row = &res.rows[r];
+        if (row->n < 0 || seen[row->n] || row->first != 0 ||
+                row->last != row->total) {
+            fprintf(stderr, "[ERR] %s: incomplete for n = %d (merge all "
+                    "the shards with partnmerge)!\n", path, row->n);
+            exit(E_BAD_RESULT);
+        }
+        seen[row->n] = true;
+        sum_side[row->n] = row->sum;
+    }
+    for (int n = 0; n <= N; n++) {
+        if (! seen[n]) {
+            fprintf(stderr, "[ERR] %s: no results for n = %d!\n",
+                    path, n);
+            exit(E_BAD_RESULT);
+        }
+    }
+    free(seen);
+    make_product_side();
+    bad = report(N);
+    free_shard_result(&res);
+    return bad ? E_DISCREPANCY : E_SUCCESS;
+}
+
+/*
+ * Plan the work groups: one per socket in use if the threads are
+ * pinned, else one.  The tasks are dealt out in decreasing n, each to
+ * the group with the fewest partitions per thread so far.
+ */
+static inline void plan_groups(int N)
+{
+    int cpus = pin ? (int) topo.num_cpus : 0;
+
+    num_groups = 1;
+    for (int t = 0; t < num_threads && t < cpus; t++)
+        if (topo.cpus[t].socket + 1 > num_groups)
+            num_groups = topo.cpus[t].socket + 1;
+    if ((groups = aligned_alloc(CACHE_LINE,
+                    num_groups * sizeof(group_t))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    memset(groups, 0, num_groups * sizeof(group_t));
+    for (int g = 0; g < num_groups; g++)
+        groups[g].leader = -1;
+    for (int t = 0; t < num_threads; t++) {
+        progress_t *pg = &progress[t];
+        pg->cpu = cpus ? topo.cpus[t % cpus].cpu : -1;
+        pg->group = cpus ? topo.cpus[t % cpus].socket : 0;
+        if (groups[pg->group].leader < 0)
+            groups[pg->group].leader = t;
+        groups[pg->group].threads++;
+    }
+    for (int g = 0; g < num_groups; g++)
+        if ((groups[g].tasks = malloc((N + 1) * sizeof(int))) == NULL) {
+            fprintf(stderr, "[ERR] Out of memory!\n");
+            exit(E_OUT_OF_MEMORY);
+        }
+    for (int n = N; n >= 0; n--) {
+        group_t *best = &groups[0];
+        if (stored[n])
+            continue;
+        for (int g = 1; g < num_groups; g++)
+            if (groups[g].load < best->load)
+                best = &groups[g];
+        best->tasks[best->num_tasks++] = n;
+        best->load += partitions(n) / best->threads;
+    }
+    for (int g = 0; g < num_groups; g++) {
+        int *a = groups[g].tasks, k = groups[g].num_tasks;
+        for (int i = 0; fail_fast && i < k / 2; i++) {
+            int x = a[i];
+            a[i] = a[k-1-i];
+            a[k-1-i] = x;
+        }
+        groups[g].sums = (num_groups == 1) ? sum_side : NULL;
+    }
+    pthread_barrier_init(&groups_ready, NULL, num_threads);
+}
+
+/*
+ * Pin the thread (with --pin), allocate the sum side of its group if
+ * it leads it (so that the pages are on the socket of the group), and
+ * wait until all the groups have theirs.
+ */
+static inline void join_group(progress_t *pg, int id)
+{
+    group_t *g = &groups[pg->group];
+
+    if (pg->cpu >= 0 && pin_thread(pthread_self(), pg->cpu))
+        fprintf(stderr, "[WARN] Cannot pin thread %d to CPU %d.\n",
+                id, pg->cpu);
+    if (g->leader == id && g->sums == NULL) {
+        size_t size = ((prod_side.ord * sizeof(int64_t) + CACHE_LINE - 1)
+                / CACHE_LINE) * CACHE_LINE;
+        if ((g->sums = aligned_alloc(CACHE_LINE, size)) == NULL) {
+            fprintf(stderr, "[ERR] Out of memory!\n");
+            exit(E_OUT_OF_MEMORY);
+        }
+        memset(g->sums, 0, size);
+    }
+    pthread_barrier_wait(&groups_ready);
+    pg->sums = g->sums;
+}
+
+/*
+ * The next task (n) for a thread of group `own`, or -1 if there is
+ * none: from its own group, or else from the others in turn.
+ */
+static inline int next_task(int own)
+{
+    for (int i = 0; i < num_groups; i++) {
+        group_t *g = &groups[(own + i) % num_groups];
+        int k;
+        if (__atomic_load_n(&g->next, __ATOMIC_RELAXED) >= g->num_tasks)
+            continue;
+        if ((k = __sync_fetch_and_add(&g->next, 1)) >= g->num_tasks)
+            continue;
+        if (fail_fast && cancelled(g->tasks[k])) {
+            /* So are all the larger n after it. */
+            __atomic_store_n(&g->next, g->num_tasks, __ATOMIC_RELAXED);
+            continue;
+        }
+        return g->tasks[k];
+    }
+    return -1;
+}
+
+/* Record a discrepancy at `n` (keeping the smallest n). */
+static inline void fail_at(int n)
+{
+    int f = __atomic_load_n(&first_failure, __ATOMIC_RELAXED);
+
+    while (n < f && ! __atomic_compare_exchange_n(&first_failure, &f, n,
+                false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
 }
 
 static inline void *run_thread(void *arg)
 {
     int id = *((int *) arg);
+    progress_t *pg = &progress[id];
     int n;
 #ifdef DEBUG
     fprintf(stderr, "run_thread [thr#%02d]: entering...\n", id);
 #endif
-    while ((n = __sync_fetch_and_sub(&current, 1)) >= 0) {
-        GEN_PARTN(n);
+    join_group(pg, id);
+    while ((n = next_task(pg->group)) >= 0) {
+        uint64_t t0 = nanotime(), count;
+        if (shards)
+            count = filtered_shard(n, pg);
+        else
+            count = GEN_PARTN(n, pg);
+        /* (A cancelled task may have stopped half way.) */
+        if (fail_fast && ! cancelled(n) && pg->sums[n] != prod_coef(n))
+            fail_at(n);
+        if (db_path && ! cancelled(n))
+            store_db(n, pg->sums[n], count, nanotime() - t0);
     }
+    __atomic_store_n(&progress[id].n, -1, __ATOMIC_RELAXED);
 #ifdef DEBUG
     fprintf(stderr, "run_thread [thr#%02d]: exiting...\n", id);
 #endif
@@ -300,37 +932,220 @@ static inline void *run_thread(void *arg)
 }
 
 /*******************************************************************\
- * PARTITION (DEFINITIONS)                                         *
+ * PROGRESS (DEFINITIONS)                                          *
 \*******************************************************************/
 
-static inline void print_partition(const partition_t *p)
+static pthread_t monitor;
+static bool monitor_stop;     /* Read and written atomically. */
+static double *pn;          /* p(n), for the fraction of a task done. */
+static double work_total;   /* Partitions of all the tasks. */
+static uint64_t start_ns;
+
+/* p(n) (0 if unknown). */
+static inline double partitions(int n)
+{
+    return pn ? pn[n] : 0;
+}
+
+/* Start task `n` of about `total` partitions (`pg` may be NULL). */
+static inline void start_task(progress_t *pg, int n, double total)
+{
+    if (pg == NULL)
+        return;
+    pg->task_start = pg->visited;
+    pg->task_total = total;
+    __atomic_store_n(&pg->n, n, __ATOMIC_RELAXED);
+}
+
+/* Publish that `count` partitions of the task have been visited. */
+static inline void publish(progress_t *pg, uint64_t count)
+{
+    if (pg)
+        __atomic_store_n(&pg->visited, pg->task_start + count,
+                __ATOMIC_RELAXED);
+}
+
+/* Has the task `n` been cancelled (by a discrepancy at a smaller n)? */
+static inline bool cancelled(int n)
+{
+    return n > __atomic_load_n(&first_failure, __ATOMIC_RELAXED);
+}
+
+/* Format `s` seconds as 1h02m03s. */
+static inline const char *fmt_time(char buf[32], double s)
+{
+    long t = (s < 0 || s > 1e9) ? -1 : (long) s;
+
+    if (t < 0)
+        return "?";
+    snprintf(buf, 32, "%ldh%02ldm%02lds", t / 3600, t / 60 % 60, t % 60);
+    return buf;
+}
+
+/*
+ * Report the progress to stderr (and to the status file), with the
+ * rates of the threads since the previous report.
+ */
+static inline void report_progress(uint64_t prev[], uint64_t *prev_ns,
+        const char *state)
+{
+    uint64_t now = nanotime(), done = 0, visited[num_threads];
+    double elapsed = (now - start_ns) / 1e9;
+    double dt = (now - *prev_ns) / 1e9;
+    double rate, eta, frac[num_threads];
+    int n[num_threads];
+    char b1[32], b2[32], tmp[4096];
+    FILE *fp;
+
+    for (int t = 0; t < num_threads; t++) {
+        n[t] = __atomic_load_n(&progress[t].n, __ATOMIC_RELAXED);
+        visited[t] = __atomic_load_n(&progress[t].visited,
+                __ATOMIC_RELAXED);
+        frac[t] = (progress[t].task_total > 0) ? (visited[t] -
+                progress[t].task_start) / progress[t].task_total : 0;
+        done += visited[t];
+    }
+    rate = (elapsed > 0) ? done / elapsed : 0;
+    eta = (rate > 0) ? (work_total - done) / rate : -1;
+    if (eta < 0 && rate > 0)
+        eta = 0;
+
+    fprintf(stderr, "[progress] %s  %5.1f%% (%" PRIu64 " of ~%.4g "
+            "partitions)  %.3g/s  ETA %s\n", fmt_time(b1, elapsed),
+            work_total > 0 ? 100 * done / work_total : 100.0, done,
+            work_total, rate, fmt_time(b2, eta));
+    for (int t = 0; t < num_threads; t++) {
+        if (n[t] < 0)
+            continue;
+        fprintf(stderr, "[progress]   thr#%02d  n=%-4d %5.1f%%  %.3g/s\n",
+                t, n[t], 100 * frac[t],
+                dt > 0 ? (visited[t] - prev[t]) / dt : 0);
+    }
+
+    if (status_path &&
+            snprintf(tmp, sizeof(tmp), "%s.tmp", status_path) <
+            (int) sizeof(tmp) && (fp = fopen(tmp, "w"))) {
+        fprintf(fp, "{\n  \"state\": \"%s\",\n", state);
+        fprintf(fp, "  \"elapsed_s\": %.3f,\n", elapsed);
+        fprintf(fp, "  \"partitions_done\": %" PRIu64 ",\n", done);
+        fprintf(fp, "  \"partitions_total\": %.17g,\n", work_total);
+        fprintf(fp, "  \"fraction\": %.6f,\n",
+                work_total > 0 ? done / work_total : 1.0);
+        fprintf(fp, "  \"rate_per_s\": %.6g,\n", rate);
+        fprintf(fp, "  \"eta_s\": %.3f,\n", eta);
+        fprintf(fp, "  \"threads\": [");
+        for (int t = 0; t < num_threads; t++)
+            fprintf(fp, "%s\n    {\"id\": %d, \"n\": %d, "
+                    "\"fraction\": %.6f, \"rate_per_s\": %.6g}",
+                    t ? "," : "", t, n[t], n[t] < 0 ? 0 : frac[t],
+                    dt > 0 ? (visited[t] - prev[t]) / dt : 0);
+        fprintf(fp, "\n  ]\n}\n");
+        if (fclose(fp) || rename(tmp, status_path))
+            remove(tmp);
+    }
+
+    for (int t = 0; t < num_threads; t++)
+        prev[t] = visited[t];
+    *prev_ns = now;
+}
+
+/*
+ * The monitor: reports every `progress_interval` seconds and
+ * whenever SIGUSR1 arrives (it is blocked in all the other threads).
+ */
+static void *run_monitor(void *arg)
 {
-    printf("[");
-    for (int i = 0; i < p->len; i++) {
-        if (i != 0)
-            printf(", ");
-        printf("%d", p->a[i]);
+    uint64_t prev[num_threads], prev_ns = start_ns;
+    struct timespec ts = {progress_interval, 0};
+    bool reported = false;
+    sigset_t set;
+    int sig;
+
+    memset(prev, 0, sizeof(prev));
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    while (! __atomic_load_n(&monitor_stop, __ATOMIC_RELAXED)) {
+        if (progress_interval)
+            sig = sigtimedwait(&set, NULL, &ts);
+        else
+            sig = sigwaitinfo(&set, NULL);
+        if (__atomic_load_n(&monitor_stop, __ATOMIC_RELAXED))
+            break;
+        if (sig < 0 && errno != EAGAIN)
+            continue;
+        report_progress(prev, &prev_ns, "running");
+        reported = true;
     }
-    printf("]");
+    if (reported || status_path)
+        report_progress(prev, &prev_ns, "done");
+    return NULL;
 }
 
-static inline void println_partition(const partition_t *p)
+static inline void start_monitor(int N)
 {
-    printf("[");
-    for (int i = 0; i < p->len; i++) {
-        if (i != 0)
-            printf(", ");
-        printf("%d", p->a[i]);
+    sigset_t set;
+
+    if ((pn = calloc(N + 1, sizeof(double))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
     }
-    printf("]\n");
+    pn[0] = 1;
+    for (int k = 1; k <= N; k++)
+        for (int m = k; m <= N; m++)
+            pn[m] += pn[m - k];
+    work_total = 0;
+    for (int n = 0; n <= N; n++)
+        if (! stored[n])
+            work_total += pn[n] / (shards ? shards : 1);
+    for (int t = 0; t < num_threads; t++)
+        progress[t].n = -1;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    start_ns = nanotime();
+    if (pthread_create(&monitor, NULL, run_monitor, NULL)) {
+        fprintf(stderr, "[ERR] Failed to create thread!\n");
+        exit(E_THREAD_FAILURE);
+    }
+}
+
+static inline void stop_monitor(void)
+{
+    __atomic_store_n(&monitor_stop, true, __ATOMIC_RELAXED);
+    pthread_kill(monitor, SIGUSR1);
+    pthread_join(monitor, NULL);
+    free(pn);
+    pn = NULL;
+}
+
+
+/*******************************************************************\
+ * PARTITION (DEFINITIONS)                                         *
+\*******************************************************************/
+
+/*
+ * Add the sum side counted (in a local variable) by a task to
+ * `sum_side[n]` (or to the sum side of the group of the thread, see
+ * `group_t`).  Tasks only touch the shared array here, once each,
+ * so threads working on neighbouring n do not fight over its cache
+ * lines while they count.
+ */
+static inline void flush_sum(progress_t *pg, int n, int64_t sum)
+{
+    __sync_fetch_and_add(pg ? &pg->sums[n] : &sum_side[n], sum);
 }
 
-static inline uint64_t merca3(int n)
+static inline uint64_t filtered_merca3(int n, progress_t *pg)
 {
     uint64_t count = 0;
+    uint64_t next = PROGRESS_BATCH;     /* Next count to publish. */
+    int64_t sum = 0;    /* Flushed into sum_side[n] at the end. */
     int k, r, s, t, u, x, y;
+    int *mem;
     partition_t p;
 
+    start_task(pg, n, partitions(n));
     p.n = n;
     if (n < 0) {
         return count;
@@ -339,11 +1154,17 @@ static inline uint64_t merca3(int n)
         if (FILTER_PARTN(&p)) {
             if (action == ACTION_PRINT)
                 println_partition(&p);
-            sum_side[n]++;
+            sum++;
         }
+        flush_sum(pg, n, sum);
+        publish(pg, ++count);
         return count;
     }
-    memset(p.a, 0, (MAXNUMP + 1) * sizeof(int));
+    if ((mem = calloc(PARTN_BUFLEN(n), sizeof(int))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    p.a = mem + 1;
     k = 0;
     x = 1;
     y = n - 1;
@@ -360,10 +1181,11 @@ static inline uint64_t merca3(int n)
             p.a[t] = x;
             p.a[u] = y - x;
             p.len = u + 1;
+            count++;
             if (FILTER_PARTN(&p)) {
                 if (action == ACTION_PRINT)
                     println_partition(&p);
-                sum_side[n]++;
+                sum++;
             }
             r = x + 1;
             s = y - r;
@@ -371,20 +1193,22 @@ static inline uint64_t merca3(int n)
                 p.a[t] = r;
                 p.a[u] = s;
                 p.len = u + 1;
+                count++;
                 if (FILTER_PARTN(&p)) {
                     if (action == ACTION_PRINT)
                         println_partition(&p);
-                    sum_side[n]++;
+                    sum++;
                 }
                 r++;
                 s--;
             }
             p.a[t] = y;
             p.len = t + 1;
+            count++;
             if (FILTER_PARTN(&p)) {
                 if (action == ACTION_PRINT)
                     println_partition(&p);
-                sum_side[n]++;
+                sum++;
             }
             x++;
             y--;
@@ -393,10 +1217,11 @@ static inline uint64_t merca3(int n)
             p.a[k] = x;
             p.a[t] = y;
             p.len = t + 1;
+            count++;
             if (FILTER_PARTN(&p)) {
                 if (action == ACTION_PRINT)
                     println_partition(&p);
-                sum_side[n]++;
+                sum++;
             }
             x++;
             y--;
@@ -404,26 +1229,168 @@ static inline uint64_t merca3(int n)
         y += x - 1;
         p.a[k] = y + 1;
         p.len = k + 1;
+        count++;
         if (FILTER_PARTN(&p)) {
             if (action == ACTION_PRINT)
                 println_partition(&p);
-            sum_side[n]++;
+            sum++;
         }
         k--;
         x = p.a[k] + 1;
+        if (count >= next) {
+            publish(pg, count);
+            next = count + PROGRESS_BATCH;
+            if (cancelled(n))
+                break;
+        }
     }
+    free(mem);
+    flush_sum(pg, n, sum);
+    publish(pg, count);
     return count;
 }
 
+/* Accumulator of the visitor of a shard. */
+typedef struct {
+    uint64_t count;
+    int64_t sum;
+    uint64_t fingerprint;
+    progress_t *pg;
+} shard_acc_t;
+
+static void filter_visit(const partition_t *p, void *argres)
+{
+    shard_acc_t *acc = argres;
+
+    if ((++acc->count & (PROGRESS_BATCH - 1)) == 0)
+        publish(acc->pg, acc->count);
+    if (FILTER_PARTN(p)) {
+        acc->sum++;
+        acc->fingerprint += partn_fingerprint(p);
+    }
+}
+
+/* Shard `shard` of `shards` of the partitions of `n`, filtered. */
+static inline uint64_t filtered_shard(int n, progress_t *pg)
+{
+    shard_plan_t plan;
+    shard_acc_t acc = {0, 0, 0, pg};
+    size_t first, last;
+    double weight = 0;
+    int *buf;
+
+    if (plan_shards(&plan, n, shards) ||
+            (buf = malloc(PARTN_BUFLEN(n) * sizeof(int))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    shard_range(&plan, shard, shards, &first, &last);
+    for (size_t u = first; u < last; u++)
+        weight += plan.units[u].weight;
+    start_task(pg, n, weight);
+    for (size_t u = first; u < last; u++)
+        gen_shard_unit(&plan, u, buf, filter_visit, &acc);
+    publish(pg, acc.count);
+    flush_sum(pg, n, acc.sum);
+    rows[n].n = n;
+    rows[n].first = first;
+    rows[n].last = last;
+    rows[n].total = plan.num_units;
+    rows[n].count = acc.count;
+    rows[n].sum = acc.sum;
+    rows[n].fingerprint = acc.fingerprint;
+    free(buf);
+    free_shard_plan(&plan);
+    return acc.count;
+}
+
 /*******************************************************************\
  * None (verified, n <= 100)                                       *
 \*******************************************************************/
 
-static inline void pside_none(qseries_t s)
+/*
+ * Make `prod_side` (or `lazy_prod`): PSIDEF, or the expression given
+ * with --pside; and `hyper_side` (HSIDEF) if there is one.
+ */
+static inline void make_product_side(void)
+{
+    char err[256];
+
+    have_hside = HSIDEF(&hyper_side);
+    if (pside_expr == NULL) {
+        PSIDEF(&prod_side);
+        return;
+    }
+    if (qexpr_eval(pside_expr, NULL, &prod_side, err, sizeof(err))) {
+        fprintf(stderr, "[ERR] --pside %s: %s\n", pside_expr, err);
+        exit(E_OUT_OF_RANGE);
+    }
+    if (fail_fast)
+        lazy_from_qseries(&lazy_prod, &prod_side);
+}
+
+/*
+ * Make `s` the product side of (`mod`, `cong`) (see `product_side`):
+ * from the cache, or with --fail-fast as `lazy_prod`.
+ */
+static inline void set_product_side(int mod, const int cong[mod],
+        qseries_t *s)
+{
+    if (! fail_fast) {
+        cached_product_side(mod, cong, s);
+        return;
+    }
+    if (lazy_product_side(&lazy_prod, mod, cong) ||
+            (lazy_cong = malloc(mod * sizeof(int))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    lazy_mod = mod;
+    memcpy(lazy_cong, cong, mod * sizeof(int));
+}
+
+/*
+ * The lazy product side failed (see `lazy_coef`): make the full one
+ * instead (under `lazy_prod_lock`).
+ */
+static inline void lazy_fallback(void)
+{
+    if (lazy_prod.err == ENOMEM) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    fprintf(stderr, "[WARN] The lazy product side stops at n = %zu "
+            "(%s); using the full one (modulo 2^64).\n", lazy_prod.num,
+            strerror(lazy_prod.err));
+    if (pside_expr == NULL)
+        cached_product_side(lazy_mod, lazy_cong, &prod_side);
+    lazy_dense = true;
+}
+
+/* Coefficient `n` of the product side. */
+static inline int64_t prod_coef(int n)
+{
+    int64_t c;
+
+    if (! fail_fast)
+        return prod_side.c[n];
+    pthread_mutex_lock(&lazy_prod_lock);
+    if (! lazy_dense) {
+        c = lazy_coef(&lazy_prod, n);
+        if (lazy_prod.err)
+            lazy_fallback();
+    }
+    if (lazy_dense)
+        c = prod_side.c[n];
+    pthread_mutex_unlock(&lazy_prod_lock);
+    return c;
+}
+
+static inline void pside_none(qseries_t *s)
 {
     int mod = 1;
     int cong[1] = {-1};
-    product_side(mod, cong, s);
+    set_product_side(mod, cong, s);
 }
 
 static inline bool filter_none(const partition_t *p)
@@ -431,16 +1398,40 @@ static inline bool filter_none(const partition_t *p)
     return true;
 }
 
+/*
+ * Analytic sum sides (HSIDEF): q-hypergeometric sums (see
+ * `qhyper_sum`), reported next to the counted sum side and the
+ * product side.  They return false if there is none.
+ */
+static inline bool hside_none(qseries_t *s)
+{
+    return false;
+}
+
+static inline bool hside_rr1(qseries_t *s)
+{
+    /* sum q^(n^2) / (q;q)_n = 1/(q, q^4; q^5)_inf */
+    static const qhyper_t h = {2, 0, 1, 0, {{0}}, 1, {{1, 1, 1}}};
+    return qhyper_sum(&h, s) == 0;
+}
+
+static inline bool hside_rr2(qseries_t *s)
+{
+    /* sum q^(n^2 + n) / (q;q)_n = 1/(q^2, q^3; q^5)_inf */
+    static const qhyper_t h = {2, 2, 1, 0, {{0}}, 1, {{1, 1, 1}}};
+    return qhyper_sum(&h, s) == 0;
+}
+
 /*******************************************************************\
  * New-01 (verified, n <= 100)                                     *
 \*******************************************************************/
 
-static inline void pside_new_01(qseries_t s)
+static inline void pside_new_01(qseries_t *s)
 {
     /* Forbidden: parts cong to 3 (mod 4) */
     int mod = 4;
     int cong[4] = {-1, -1, -1, 0};
-    product_side(mod, cong, s);
+    set_product_side(mod, cong, s);
 }
 
 static inline bool filter_new_01(const partition_t *p)
@@ -468,12 +1459,12 @@ static inline bool filter_new_01(const partition_t *p)
  * New-02 (verified, n <= 100)                                     *
 \*******************************************************************/
 
-static inline void pside_new_02(qseries_t s)
+static inline void pside_new_02(qseries_t *s)
 {
     /* Forbidden: parts cong to 3, 5 (mod 6) */
     int mod = 6;
     int cong[6] = {-1, -1, -1, 0, -1, 0};
-    product_side(mod, cong, s);
+    set_product_side(mod, cong, s);
 }
 
 static inline bool filter_new_02(const partition_t *p)
@@ -503,12 +1494,12 @@ static inline bool filter_new_02(const partition_t *p)
  * New-03 (false-positive, first discrepancy @n=13)                *
 \*******************************************************************/
 
-static inline void pside_new_03(qseries_t s)
+static inline void pside_new_03(qseries_t *s)
 {
     /* Forbidden: parts cong to 3, 5, 10 (mod 10) */
     int mod = 10;
     int cong[10] = {0, -1, -1, 0, -1, 0, -1, -1, -1, -1};
-    product_side(mod, cong, s);
+    set_product_side(mod, cong, s);
 }
 
 static inline bool filter_new_03(const partition_t *p)
@@ -545,12 +1536,12 @@ static inline bool filter_new_03(const partition_t *p)
  * New-04 (verified, n <= 100)                                     *
 \*******************************************************************/
 
-static inline void pside_new_04(qseries_t s)
+static inline void pside_new_04(qseries_t *s)
 {
     /* Forbidden: parts cong to 1 (mod 5) */
     int mod = 5;
     int cong[5] = {-1, 0, -1, -1, -1};
-    product_side(mod, cong, s);
+    set_product_side(mod, cong, s);
 }
 
 static inline bool filter_new_04(const partition_t *p)
@@ -583,12 +1574,12 @@ static inline bool filter_new_04(const partition_t *p)
  * New-05 (verified, n <= 100)                                     *
 \*******************************************************************/
 
-static inline void pside_new_05(qseries_t s)
+static inline void pside_new_05(qseries_t *s)
 {
     /* Forbidden: parts cong to 2 (mod 5) */
     int mod = 5;
     int cong[5] = {-1, -1, 0, -1, -1};
-    product_side(mod, cong, s);
+    set_product_side(mod, cong, s);
 }
 
 static inline bool filter_new_05(const partition_t *p)
@@ -621,12 +1612,12 @@ static inline bool filter_new_05(const partition_t *p)
  * New-06 (verified, n <= 100)                                     *
 \*******************************************************************/
 
-static inline void pside_new_06(qseries_t s)
+static inline void pside_new_06(qseries_t *s)
 {
     /* Forbidden: parts cong to 3 (mod 5) */
     int mod = 5;
     int cong[5] = {-1, -1, -1, 0, -1};
-    product_side(mod, cong, s);
+    set_product_side(mod, cong, s);
 }
 
 static inline bool filter_new_06(const partition_t *p)
@@ -658,12 +1649,12 @@ static inline bool filter_new_06(const partition_t *p)
  *        (The missing on in the series - I4, I5, I6, I6x)         *
 \*******************************************************************/
 
-static inline void pside_new_6x(qseries_t s)
+static inline void pside_new_6x(qseries_t *s)
 {
     /* Forbidden: parts cong to 4 (mod 5) */
     int mod = 5;
     int cong[5] = {-1, -1, -1, -1, 0};
-    product_side(mod, cong, s);
+    set_product_side(mod, cong, s);
 }
 
 static inline bool filter_new_6x(const partition_t *p)
@@ -695,12 +1686,12 @@ static inline bool filter_new_6x(const partition_t *p)
  *        (The missing on in the series - I4, I5, I6, I6x, I6y)    *
 \*******************************************************************/
 
-static inline void pside_new_6y(qseries_t s)
+static inline void pside_new_6y(qseries_t *s)
 {
     /* Forbidden: parts cong to 0 (mod 5) */
     int mod = 5;
     int cong[5] = {0, -1, -1, -1, -1};
-    product_side(mod, cong, s);
+    set_product_side(mod, cong, s);
 }
 
 static inline bool filter_new_6y(const partition_t *p)
@@ -731,12 +1722,12 @@ static inline bool filter_new_6y(const partition_t *p)
  * New-07 (verified, n <= 100)                                     *
 \*******************************************************************/
 
-static inline void pside_new_07(qseries_t s)
+static inline void pside_new_07(qseries_t *s)
 {
     /* Forbidden: parts cong to 1, 5, 6, 7, 11 (mod 12) */
     int mod = 12;
     int cong[12] = {-1, 0, -1, -1, -1, 0, 0, 0, -1, -1, -1, 0};
-    product_side(mod, cong, s);
+    set_product_side(mod, cong, s);
 }
 
 static inline bool filter_new_07(const partition_t *p)
@@ -775,12 +1766,12 @@ static inline bool filter_new_07(const partition_t *p)
  * New-08                                                          *
 \*******************************************************************/
 
-static inline void pside_new_08(qseries_t s)
+static inline void pside_new_08(qseries_t *s)
 {
     /* Forbidden: parts cong to 1, 5, 6, 7, 11 (mod 12) */
     int mod = 12;
     int cong[12] = {-1, 0, -1, -1, -1, 0, 0, 0, -1, -1, -1, 0};
-    product_side(mod, cong, s);
+    set_product_side(mod, cong, s);
 }
 
 static inline bool filter_new_08(const partition_t *p)
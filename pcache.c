@@ -0,0 +1,188 @@
+/*
+ * pcache.c - On-disk cache of product sides.
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   CC = gcc #( or clang)
+ *   CFLAGS = -std=gnu11 -O3 #(or, -O2)
+ *   $(CC) $(CFLAGS) -c pcache.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "pcache.h"
+#include "util.h"
+
+/*
+ * Key of an entry, in the extension of its series file (see
+ * `save_qseries_ext`).
+ */
+typedef struct {
+    uint32_t ring;
+    uint32_t mod;
+    int32_t cong[];
+} pcache_key_t;
+
+/* Make the key of (`mod`, `cong`), of `*len` bytes (NULL if no memory). */
+static inline pcache_key_t *make_key(int mod, const int cong[mod],
+        size_t *len)
+{
+    pcache_key_t *k;
+
+    *len = sizeof(pcache_key_t) + mod * sizeof(int32_t);
+    if ((k = malloc(*len)) == NULL)
+        return NULL;
+    k->ring = QRING_INT64;
+    k->mod = mod;
+    for (int r = 0; r < mod; r++)
+        k->cong[r] = cong[r];
+    return k;
+}
+
+/* Hash of the key (without the order): the name of the entries. */
+static inline uint64_t key_hash(const pcache_key_t *k, size_t len)
+{
+    return fnv1a(FNV1A_BASIS, k, len);
+}
+
+const char *pcache_dir(char *buf, size_t size)
+{
+    const char *dir = getenv("PARTN_CACHE");
+    const char *home;
+
+    if (dir && strcmp(dir, "none") == 0)
+        return NULL;
+    if (dir && *dir)
+        return dir;
+    if ((home = getenv("HOME")) == NULL)
+        return NULL;
+    if (snprintf(buf, size, "%s/.cache/partn", home) >= (int) size)
+        return NULL;
+    return buf;
+}
+
+/* Make the directory `dir` and its parents. */
+static inline int make_dirs(const char *dir)
+{
+    char path[4096];
+    size_t len = strlen(dir);
+
+    if (len >= sizeof(path))
+        return -1;
+    memcpy(path, dir, len + 1);
+    for (size_t i = 1; i <= len; i++) {
+        if (path[i] != '/' && path[i] != '\0')
+            continue;
+        path[i] = '\0';
+        if (mkdir(path, 0777) && errno != EEXIST)
+            return -1;
+        path[i] = dir[i];
+    }
+    return 0;
+}
+
+/* Map the file `path` if it is a valid entry for the key `k`. */
+static inline int map_entry(const char *path, const pcache_key_t *k,
+        size_t len, size_t ord, pcache_entry_t *e)
+{
+    if (map_qseries(path, &e->m))
+        return -1;
+    if (e->m.ext_len != len || memcmp(e->m.ext, k, len) ||
+            e->m.s.ord < ord)
+        goto invalid;
+    e->s.ord = ord;
+    e->s.c = e->m.s.c;
+    return 0;
+invalid:
+    unmap_qseries(&e->m);
+    return -1;
+}
+
+int pcache_open(const char *dir, int mod, const int cong[mod],
+        size_t ord, pcache_entry_t *e)
+{
+    char path[4096], prefix[32];
+    struct dirent *de;
+    pcache_key_t *k;
+    size_t len, best = 0;
+    int err = -1;
+    DIR *d;
+
+    if ((k = make_key(mod, cong, &len)) == NULL)
+        return -1;
+    snprintf(prefix, sizeof(prefix), "%016llx.",
+            (unsigned long long) key_hash(k, len));
+    if (snprintf(path, sizeof(path), "%s/%s%zu.qs", dir, prefix, ord)
+            < (int) sizeof(path) && map_entry(path, k, len, ord, e) == 0) {
+        free(k);
+        return 0;
+    }
+    /* The smallest entry of a larger order. */
+    if ((d = opendir(dir)) == NULL) {
+        free(k);
+        return -1;
+    }
+    while ((de = readdir(d)) != NULL) {
+        size_t o;
+        char end[4];
+        if (strncmp(de->d_name, prefix, 17) == 0 &&
+                sscanf(de->d_name + 17, "%zu.%3s", &o, end) == 2 &&
+                strcmp(end, "qs") == 0 && o > ord && (best == 0 || o < best))
+            best = o;
+    }
+    closedir(d);
+    if (best && snprintf(path, sizeof(path), "%s/%s%zu.qs", dir, prefix,
+                best) < (int) sizeof(path))
+        err = map_entry(path, k, len, ord, e);
+    free(k);
+    return err;
+}
+
+void pcache_close(pcache_entry_t *e)
+{
+    unmap_qseries(&e->m);
+    e->s.c = NULL;
+}
+
+int pcache_store(const char *dir, int mod, const int cong[mod],
+        const qseries_t *s)
+{
+    char path[4096];
+    pcache_key_t *k;
+    size_t len;
+    int err = -1;
+
+    if (make_dirs(dir) || (k = make_key(mod, cong, &len)) == NULL)
+        return -1;
+    if (snprintf(path, sizeof(path), "%s/%016llx.%zu.qs", dir,
+                (unsigned long long) key_hash(k, len), s->ord)
+            < (int) sizeof(path))
+        err = save_qseries_ext(path, s, k, len);
+    free(k);
+    return err;
+}
+
+int cached_product_side(int mod, const int cong[mod], qseries_t *ans)
+{
+    char buf[4096];
+    const char *dir = pcache_dir(buf, sizeof(buf));
+    pcache_entry_t e;
+
+    if (dir && pcache_open(dir, mod, cong, ans->ord, &e) == 0) {
+        memcpy(ans->c, e.s.c, ans->ord * sizeof(int64_t));
+        pcache_close(&e);
+        return 1;
+    }
+    product_side(mod, cong, ans);
+    if (dir)
+        pcache_store(dir, mod, cong, ans);
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * pcache.h - On-disk cache of product sides (header file).
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Product sides (see `product_side` in qseries.h) are stored as
+ * binary series files in a cache directory, named by a hash of
+ * (ring, mod, cong[]) and the order:
+ *
+ *   DIR/HHHHHHHHHHHHHHHH.ORD.qs
+ *
+ * A file is a binary series file (see `save_qseries_ext`) with the
+ * key (ring, mod, cong[]) in its extension, and is mapped into memory
+ * (`map_qseries`) to be read.  Files are written to a temporary
+ * name and renamed into place, and never changed afterwards, so
+ * readers need no locks: concurrent processes either see a complete
+ * file or none, and two writers of the same entry write the same
+ * bytes.  An entry of a larger order serves a smaller one too.
+ *
+ * The directory is $PARTN_CACHE, or ~/.cache/partn if that is not
+ * set; PARTN_CACHE=none turns the cache off.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "qseries.h"
+
+/* Rings of the coefficients (part of the key). */
+typedef enum {
+    QRING_INT64,        /* 64-bit integers (qseries_t). */
+} qring_t;
+
+/* A product side mapped from the cache (read-only). */
+typedef struct {
+    qseries_t s;        /* Of the order asked for, `s.c` in `m`. */
+    qseries_map_t m;
+} pcache_entry_t;
+
+/*
+ * The cache directory (in `buf` if it has to be made up), or NULL if
+ * the cache is off.
+ */
+const char *pcache_dir(char *buf, size_t size);
+
+/*
+ * Map the entry for (`mod`, `cong`) of order at least `ord` from
+ * `dir` into `e` (with `e->s.ord` = `ord`).  Returns 0 on success,
+ * -1 if there is no such (valid) entry.
+ */
+int pcache_open(const char *dir, int mod, const int cong[mod],
+        size_t ord, pcache_entry_t *e);
+
+/* Unmap an entry. */
+void pcache_close(pcache_entry_t *e);
+
+/*
+ * Store the product side `s` for (`mod`, `cong`) in `dir` (created
+ * if need be).  Returns 0 on success, -1 on failure.
+ */
+int pcache_store(const char *dir, int mod, const int cong[mod],
+        const qseries_t *s);
+
+/*
+ * `product_side` through the cache: the result is copied from the
+ * cache if it is there, else computed and stored.  Returns 1 on a
+ * hit, 0 on a miss.
+ */
+int cached_product_side(int mod, const int cong[mod], qseries_t *ans);
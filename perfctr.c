@@ -0,0 +1,132 @@
+/*
+ * perfctr.c - Hardware performance counters.
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   CC = gcc #( or clang)
+ *   CFLAGS = -std=gnu11 -O3 #(or, -O2)
+ *   $(CC) $(CFLAGS) -c perfctr.c
+ */
+
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "perfctr.h"
+
+const char *perfctr_names[PERFCTR_NUM] = {
+    "instructions",
+    "cycles",
+    "branch_misses",
+    "l1d_misses",
+};
+
+#ifdef __linux__
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} events[PERFCTR_NUM] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+};
+
+int perfctr_open(perfctr_t *pc)
+{
+    struct perf_event_attr attr;
+    int num = 0;
+
+    for (int ev = 0; ev < PERFCTR_NUM; ev++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[ev].type;
+        attr.config = events[ev].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+            PERF_FORMAT_TOTAL_TIME_RUNNING;
+        pc->fd[ev] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (pc->fd[ev] >= 0)
+            num++;
+    }
+    return num;
+}
+
+void perfctr_close(perfctr_t *pc)
+{
+    for (int ev = 0; ev < PERFCTR_NUM; ev++) {
+        if (pc->fd[ev] >= 0)
+            close(pc->fd[ev]);
+        pc->fd[ev] = -1;
+    }
+}
+
+void perfctr_start(perfctr_t *pc)
+{
+    for (int ev = 0; ev < PERFCTR_NUM; ev++) {
+        if (pc->fd[ev] < 0)
+            continue;
+        ioctl(pc->fd[ev], PERF_EVENT_IOC_RESET, 0);
+        ioctl(pc->fd[ev], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void perfctr_stop(perfctr_t *pc, uint64_t val[PERFCTR_NUM])
+{
+    /* value, time enabled, time running */
+    uint64_t buf[3];
+
+    for (int ev = 0; ev < PERFCTR_NUM; ev++)
+        if (pc->fd[ev] >= 0)
+            ioctl(pc->fd[ev], PERF_EVENT_IOC_DISABLE, 0);
+    for (int ev = 0; ev < PERFCTR_NUM; ev++) {
+        val[ev] = 0;
+        if (pc->fd[ev] < 0 || read(pc->fd[ev], buf, sizeof(buf))
+                != sizeof(buf) || buf[2] == 0)
+            continue;
+        val[ev] = (buf[2] < buf[1]) ?
+            (uint64_t) ((double) buf[0] * buf[1] / buf[2]) : buf[0];
+    }
+}
+
+#else /* ! __linux__ */
+
+int perfctr_open(perfctr_t *pc)
+{
+    for (int ev = 0; ev < PERFCTR_NUM; ev++)
+        pc->fd[ev] = -1;
+    return 0;
+}
+
+void perfctr_close(perfctr_t *pc)
+{
+}
+
+void perfctr_start(perfctr_t *pc)
+{
+}
+
+void perfctr_stop(perfctr_t *pc, uint64_t val[PERFCTR_NUM])
+{
+    for (int ev = 0; ev < PERFCTR_NUM; ev++)
+        val[ev] = 0;
+}
+
+#endif /* __linux__ */
+
+bool perfctr_available(const perfctr_t *pc, perfctr_event_t ev)
+{
+    return pc->fd[ev] >= 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * perfctr.h - Hardware performance counters (header file).
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * A thin wrapper around Linux `perf_event_open(2)` counting events of
+ * the calling thread in user space.  Counters that the kernel or the
+ * CPU does not provide (or that are not permitted, see
+ * /proc/sys/kernel/perf_event_paranoid) are simply unavailable; on
+ * other systems all of them are.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The events counted. */
+typedef enum {
+    PERFCTR_INSTRUCTIONS,
+    PERFCTR_CYCLES,
+    PERFCTR_BRANCH_MISSES,
+    PERFCTR_L1D_MISSES,
+    PERFCTR_NUM,
+} perfctr_event_t;
+
+/* Short names of the events (indexed by `perfctr_event_t`). */
+extern const char *perfctr_names[PERFCTR_NUM];
+
+/* A set of counters. */
+typedef struct {
+    int fd[PERFCTR_NUM];
+} perfctr_t;
+
+/*
+ * Open the counters for the calling thread (initially stopped).
+ * Returns the number of available counters.
+ */
+int perfctr_open(perfctr_t *pc);
+
+/* Close the counters. */
+void perfctr_close(perfctr_t *pc);
+
+/* Is the counter for `ev` available? */
+bool perfctr_available(const perfctr_t *pc, perfctr_event_t ev);
+
+/* Reset and start the counters. */
+void perfctr_start(perfctr_t *pc);
+
+/*
+ * Stop the counters and read them into `val` (scaled up if the
+ * kernel had to multiplex them; 0 for unavailable counters).
+ */
+void perfctr_stop(perfctr_t *pc, uint64_t val[PERFCTR_NUM]);
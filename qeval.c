@@ -0,0 +1,135 @@
+/*
+ * qeval.c - Evaluate q-series expressions.
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   CC = gcc #(or clang)
+ *   CFLAGS = -std=gnu11 -O3 #(or, -O2)
+ *   OBJS = qexpr.o qseries.o util.o
+ *   $(CC) $(CFLAGS) -o qeval qeval.c $(OBJS)
+ *
+ * Usage: ./qeval [OPTIONS] [EXPR ...]
+ *
+ *   -o, --order M   Order of the series (default: 50).
+ *   -c, --coeffs    Print the coefficients only.
+ *   -s, --stats     Print the hits and misses of the cache (stderr).
+ *
+ * Evaluates each EXPR (see qexpr.h), or each line of the standard
+ * input if there is none (empty lines and lines starting with '#' are
+ * skipped), as a batch sharing one cache, and prints the results one
+ * per line.  The exit status is 1 if any expression failed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include "qexpr.h"
+#include "qseries.h"
+
+typedef enum {
+    E_SUCCESS,
+    E_BAD_EXPR,
+    E_INVALID_ARGS,
+    E_OUT_OF_MEMORY,
+} err_t;
+
+static inline void usage(const char *com)
+{
+    fprintf(stderr, "Evaluate q-series expressions (see qexpr.h), e.g. ");
+    fprintf(stderr, "'1/(q,q^4;q^5)_inf'.\n\n");
+    fprintf(stderr, "Usage: %s [OPTIONS] [EXPR ...]\n\n", com);
+    fprintf(stderr, "  -o, --order M\tOrder of the series (default: ");
+    fprintf(stderr, "50).\n");
+    fprintf(stderr, "  -c, --coeffs\tPrint the coefficients only.\n");
+    fprintf(stderr, "  -s, --stats\tPrint the hits and misses of the ");
+    fprintf(stderr, "cache.\n\n");
+    fprintf(stderr, "Without EXPR, the expressions are read from the ");
+    fprintf(stderr, "standard input, one per line.\n");
+}
+
+/* Evaluate and print one expression; returns 0 on success. */
+static inline int eval(const char *expr, qexpr_cache_t *cache,
+        qseries_t *s, bool coeffs)
+{
+    char err[256];
+
+    if (qexpr_eval(expr, cache, s, err, sizeof(err))) {
+        fprintf(stderr, "[ERR] %s: %s\n", expr, err);
+        return -1;
+    }
+    if (coeffs)
+        println_coeffs(s, s->ord);
+    else
+        println_qseries(s, s->ord);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option longopts[] = {
+        {"order",  required_argument, NULL, 'o'},
+        {"coeffs", no_argument,       NULL, 'c'},
+        {"stats",  no_argument,       NULL, 's'},
+        {"help",   no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    bool coeffs = false, stats = false;
+    long ord = 50;
+    qexpr_cache_t cache;
+    qseries_t s;
+    char line[4096];
+    err_t err = E_SUCCESS;
+    int c;
+
+    while ((c = getopt_long(argc, argv, "o:csh", longopts, NULL)) != -1) {
+        switch (c) {
+            case 'o':
+                ord = atol(optarg);
+                break;
+            case 'c':
+                coeffs = true;
+                break;
+            case 's':
+                stats = true;
+                break;
+            default:
+                usage(argv[0]);
+                return E_INVALID_ARGS;
+        }
+    }
+    if (ord < 1) {
+        usage(argv[0]);
+        return E_INVALID_ARGS;
+    }
+    if (alloc_qseries(&s, ord)) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        return E_OUT_OF_MEMORY;
+    }
+    qexpr_cache_init(&cache);
+    if (optind < argc) {
+        for (int i = optind; i < argc; i++)
+            if (eval(argv[i], &cache, &s, coeffs))
+                err = E_BAD_EXPR;
+    } else {
+        while (fgets(line, sizeof(line), stdin)) {
+            line[strcspn(line, "\n")] = '\0';
+            if (line[strspn(line, " \t")] == '\0' || line[0] == '#')
+                continue;
+            if (eval(line, &cache, &s, coeffs))
+                err = E_BAD_EXPR;
+        }
+    }
+    if (stats)
+        fprintf(stderr, "Cache: %zu entries, %" PRIu64 " hits, %" PRIu64
+                " misses.\n", cache.num, cache.hits, cache.misses);
+    qexpr_cache_free(&cache);
+    free_qseries(&s);
+    return err;
+}
@@ -0,0 +1,637 @@
+/*
+ * qexpr.c - Expressions for truncated q-series.
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   CC = gcc #( or clang)
+ *   CFLAGS = -std=gnu11 -O3 #(or, -O2)
+ *   $(CC) $(CFLAGS) -c qexpr.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include "qexpr.h"
+#include "util.h"
+
+/* Longest cache key (longer ones are not cached). */
+#define KEYLEN 256
+
+/* A value: a series and its cache key ("" if it is not cached). */
+typedef struct {
+    qseries_t s;
+    char key[KEYLEN];
+} value_t;
+
+/* State of the parser. */
+typedef struct {
+    const char *expr;
+    const char *p;      /* Next character. */
+    size_t ord;
+    qexpr_cache_t *cache;
+    char *err;
+    size_t errlen;
+} parser_t;
+
+static int parse_expr(parser_t *ps, value_t *v);
+
+/*******************************************************************\
+ * Cache                                                           *
+ *******************************************************************/
+
+void qexpr_cache_init(qexpr_cache_t *cache)
+{
+    memset(cache, 0, sizeof(*cache));
+}
+
+void qexpr_cache_free(qexpr_cache_t *cache)
+{
+    for (size_t i = 0; i < cache->num; i++) {
+        free(cache->entries[i].key);
+        free_qseries(&cache->entries[i].s);
+    }
+    free(cache->entries);
+    memset(cache, 0, sizeof(*cache));
+}
+
+static inline uint64_t key_hash(const char *key)
+{
+    return fnv1a(FNV1A_BASIS, key, strlen(key));
+}
+
+/* The entry for `key` (of any order), or NULL. */
+static inline qexpr_entry_t *cache_find(qexpr_cache_t *cache,
+        const char *key)
+{
+    uint64_t h = key_hash(key);
+
+    for (size_t i = 0; i < cache->num; i++)
+        if (cache->entries[i].hash == h &&
+                strcmp(cache->entries[i].key, key) == 0)
+            return &cache->entries[i];
+    return NULL;
+}
+
+/* Copy the value for `v->key` into `v->s` if it is cached. */
+static inline bool cache_get(parser_t *ps, value_t *v)
+{
+    qexpr_entry_t *e;
+
+    if (ps->cache == NULL || v->key[0] == '\0')
+        return false;
+    if ((e = cache_find(ps->cache, v->key)) == NULL || e->s.ord < v->s.ord) {
+        ps->cache->misses++;
+        return false;
+    }
+    ps->cache->hits++;
+    cp_qseries(&e->s, &v->s);
+    return true;
+}
+
+/* Keep `v` in the cache (best effort: not if out of memory). */
+static inline void cache_put(parser_t *ps, const value_t *v)
+{
+    qexpr_cache_t *c = ps->cache;
+    qexpr_entry_t *e;
+
+    if (c == NULL || v->key[0] == '\0')
+        return;
+    if ((e = cache_find(c, v->key)) != NULL) {
+        /* Of a smaller order: replace it. */
+        free_qseries(&e->s);
+    } else {
+        if (c->num == c->cap) {
+            size_t cap = c->cap ? 2 * c->cap : 64;
+            qexpr_entry_t *entries;
+            if ((entries = realloc(c->entries, cap * sizeof(*entries)))
+                    == NULL)
+                return;
+            c->entries = entries;
+            c->cap = cap;
+        }
+        e = &c->entries[c->num];
+        if ((e->key = strdup(v->key)) == NULL)
+            return;
+        e->hash = key_hash(v->key);
+        c->num++;
+    }
+    if (alloc_qseries(&e->s, v->s.ord)) {
+        /* Drop the entry. */
+        free(e->key);
+        *e = c->entries[--c->num];
+        return;
+    }
+    cp_qseries(&v->s, &e->s);
+}
+
+/*******************************************************************\
+ * Values                                                          *
+ *******************************************************************/
+
+/* Report an error at the current position; returns -1. */
+static int error(parser_t *ps, const char *fmt, ...)
+{
+    va_list ap;
+    int len;
+
+    len = snprintf(ps->err, ps->errlen, "at %d: ",
+            (int) (ps->p - ps->expr) + 1);
+    if (len >= 0 && (size_t) len < ps->errlen) {
+        va_start(ap, fmt);
+        vsnprintf(ps->err + len, ps->errlen - len, fmt, ap);
+        va_end(ap);
+    }
+    return -1;
+}
+
+static inline int new_value(parser_t *ps, value_t *v)
+{
+    v->key[0] = '\0';
+    if (alloc_qseries(&v->s, ps->ord))
+        return error(ps, "out of memory");
+    return 0;
+}
+
+static inline void free_value(value_t *v)
+{
+    free_qseries(&v->s);
+}
+
+/* Set the key of `v` (none if it does not fit). */
+static void set_key(value_t *v, const char *fmt, ...)
+{
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = vsnprintf(v->key, KEYLEN, fmt, ap);
+    va_end(ap);
+    if (len < 0 || len >= KEYLEN)
+        v->key[0] = '\0';
+}
+
+/*
+ * If `s` is a monomial c q^deg (c != 0) up to its order, set `c` and
+ * `deg` and return true; a zero series (all the terms beyond the
+ * order) is not one.
+ */
+static bool monomial(const qseries_t *s, int64_t *c, size_t *deg)
+{
+    size_t n = 0;
+
+    while (n < s->ord && s->c[n] == 0)
+        n++;
+    if (n == s->ord)
+        return false;
+    for (size_t i = n + 1; i < s->ord; i++)
+        if (s->c[i])
+            return false;
+    *c = s->c[n];
+    *deg = n;
+    return true;
+}
+
+static inline bool is_zero(const qseries_t *s)
+{
+    for (size_t n = 0; n < s->ord; n++)
+        if (s->c[n])
+            return false;
+    return true;
+}
+
+/* v = v^(p/r), r > 0 (the key is left to the caller). */
+static int power(parser_t *ps, value_t *v, int64_t p, int64_t r)
+{
+    int64_t c, x = 1;
+    size_t deg;
+
+    if (r == 1 && p == 1)
+        return 0;
+    if (p > INT32_MAX || p < -INT32_MAX || r > INT32_MAX)
+        return error(ps, "power %" PRId64 "/%" PRId64 " too large", p, r);
+    if (monomial(&v->s, &c, &deg) && deg > 0) {
+        /* (c q^deg)^n = c^n q^(n deg), n >= 0 only. */
+        if (p < 0 || p % r)
+            return error(ps, "power %" PRId64 "/%" PRId64 " of a "
+                    "monomial", p, r);
+        p /= r;
+        for (int64_t i = 0; i < p; i++)
+            x *= c;
+        init_qseries(&v->s, 0);
+        if (p == 0)
+            v->s.c[0] = 1;
+        else if (deg <= (v->s.ord - 1) / p)
+            v->s.c[deg * p] = x;
+        return 0;
+    }
+    if (is_zero(&v->s)) {
+        /* Terms beyond the order only. */
+        if (p <= 0)
+            return error(ps, "power %" PRId64 "/%" PRId64 " of 0", p, r);
+        return 0;
+    }
+    if (r == 1 && p >= 0) {
+        pow_qseries(&v->s, p, &v->s);
+        return 0;
+    }
+    if (v->s.c[0] != 1 && (r != 1 || v->s.c[0] != -1))
+        return error(ps, "power %" PRId64 "/%" PRId64 " of a series with "
+                "constant term %" PRId64, p, r, v->s.c[0]);
+    if (r == 1) {
+        pow_qseries(&v->s, p, &v->s);
+        return 0;
+    }
+    if (powq_qseries(&v->s, p, r, &v->s))
+        return error(ps, "power %" PRId64 "/%" PRId64 " has no integer "
+                "(64-bit) coefficients", p, r);
+    return 0;
+}
+
+/* v = v * w, or v / w if `div` (frees w). */
+static int product(parser_t *ps, value_t *v, value_t *w, bool div)
+{
+    int64_t c0 = w->s.c[0];
+
+    v->key[0] = '\0';
+    if (div && c0 != 1 && c0 != -1) {
+        free_value(w);
+        free_value(v);
+        return error(ps, "division by a series with constant term %"
+                PRId64, c0);
+    }
+    if (div)
+        divide_inplace_qseries(&v->s, &w->s);
+    else
+        multiply_inplace_qseries(&v->s, &w->s);
+    free_value(w);
+    return 0;
+}
+
+/*
+ * (a q^k; q^m)_n into `v` (n < 0: infinite), through the cache; with
+ * m >= ord (q^m = 0 up to the order) only the first factor counts (if
+ * there is one: n = 0 is the empty product).
+ */
+static int pochhammer(parser_t *ps, int64_t a, size_t k, size_t m,
+        int64_t n, value_t *v)
+{
+    if (new_value(ps, v))
+        return -1;
+    if (m >= ps->ord) {
+        m = ps->ord;
+        if (n != 0)
+            n = 1;
+    }
+    set_key(v, "P%" PRId64 ",%zu,%zu,%" PRId64, a, k, m, n);
+    if (cache_get(ps, v))
+        return 0;
+    if (n < 0) {
+        qpochhammer_qseries(a, k, m, &v->s);
+    } else {
+        init_qseries(&v->s, 0);
+        v->s.c[0] = 1;
+        for (int64_t j = 0; j < n && k + j * m < ps->ord; j++) {
+            size_t e = k + j * m;
+            for (size_t deg = ps->ord; deg-- > e; )
+                v->s.c[deg] -= a * v->s.c[deg - e];
+        }
+    }
+    cache_put(ps, v);
+    return 0;
+}
+
+/*******************************************************************\
+ * Parser                                                          *
+ *******************************************************************/
+
+static inline char peek(parser_t *ps)
+{
+    while (isspace((unsigned char) *ps->p))
+        ps->p++;
+    return *ps->p;
+}
+
+static inline bool accept(parser_t *ps, char c)
+{
+    if (peek(ps) != c)
+        return false;
+    ps->p++;
+    return true;
+}
+
+/* Accept the word `w` (not followed by a letter or digit). */
+static inline bool accept_word(parser_t *ps, const char *w)
+{
+    size_t len = strlen(w);
+
+    peek(ps);
+    if (strncmp(ps->p, w, len) || isalnum((unsigned char) ps->p[len]))
+        return false;
+    ps->p += len;
+    return true;
+}
+
+static int parse_int(parser_t *ps, int64_t *x)
+{
+    char *end;
+
+    if (! isdigit((unsigned char) peek(ps)))
+        return error(ps, "integer expected");
+    errno = 0;
+    *x = strtoll(ps->p, &end, 10);
+    if (errno == ERANGE)
+        return error(ps, "integer out of range (64 bits)");
+    ps->p = end;
+    return 0;
+}
+
+static inline int expect(parser_t *ps, char c)
+{
+    if (! accept(ps, c))
+        return error(ps, "'%c' expected", c);
+    return 0;
+}
+
+/* exponent := ["-"] INT | "(" ["-"] INT ["/" INT] ")" */
+static int parse_exponent(parser_t *ps, int64_t *p, int64_t *r)
+{
+    bool paren = accept(ps, '('), neg = accept(ps, '-');
+
+    *r = 1;
+    if (parse_int(ps, p))
+        return -1;
+    if (paren && accept(ps, '/') && (parse_int(ps, r) || *r == 0))
+        return error(ps, "bad denominator");
+    if (paren && expect(ps, ')'))
+        return -1;
+    if (neg)
+        *p = -*p;
+    return 0;
+}
+
+/*
+ * The rest of "(" A1, ..., Ar ";" B ")" ["_" N] after A1 (in `v`):
+ * the q-Pochhammer symbol.
+ */
+static int parse_pochhammer(parser_t *ps, value_t *v)
+{
+    value_t a[16], b, f;
+    int64_t n = -1, c;
+    size_t num = 1, m, k;
+    bool have = false;
+    int err = -1;
+
+    a[0] = *v;
+    while (accept(ps, ',')) {
+        if (num == 16) {
+            error(ps, "too many arguments");
+            goto out;
+        }
+        if (parse_expr(ps, &a[num]))
+            goto out;
+        num++;
+    }
+    if (expect(ps, ';') || parse_expr(ps, &b))
+        goto out;
+    if (is_zero(&b.s)) {
+        m = ps->ord;
+    } else if (! monomial(&b.s, &c, &m) || c != 1 || m == 0) {
+        free_value(&b);
+        error(ps, "the base must be q^m, m >= 1");
+        goto out;
+    }
+    free_value(&b);
+    if (expect(ps, ')'))
+        goto out;
+    if (accept(ps, '_') && ! accept_word(ps, "inf") &&
+            ! accept_word(ps, "oo") && parse_int(ps, &n))
+        goto out;
+
+    /* The product of the (Ai; q^m)_n, its key that of the factors. */
+    for (size_t i = 0; i < num; i++) {
+        char key[KEYLEN];
+        if (is_zero(&a[i].s)) {
+            /* A factor 1. */
+            if (pochhammer(ps, 0, 0, m, 1, &f))
+                goto fail;
+        } else if (! monomial(&a[i].s, &c, &k)) {
+            error(ps, "not a monomial a q^k");
+            goto fail;
+        } else if (pochhammer(ps, c, k, m, n, &f)) {
+            goto fail;
+        }
+        if (i == 0) {
+            *v = f;
+            have = true;
+            continue;
+        }
+        snprintf(key, KEYLEN, "%s", v->key);
+        if (product(ps, v, &f, false))
+            goto out;
+        set_key(v, "%s*%s", key, f.key);
+    }
+    err = 0;
+    goto out;
+fail:
+    if (have)
+        free_value(v);
+out:
+    for (size_t i = 0; i < num; i++)
+        free_value(&a[i]);
+    return err;
+}
+
+/*
+ * primary := INT | "q" | "(" expr ")" | "(" expr {"," expr} ";" ...
+ *          | "eta" "(" INT ")" | "theta" "(" INT "," INT ")"
+ */
+static int parse_primary(parser_t *ps, value_t *v)
+{
+    int64_t x = 0, y = 0;
+    char c = peek(ps);
+
+    if (isdigit((unsigned char) c)) {
+        if (parse_int(ps, &x) || new_value(ps, v))
+            return -1;
+        v->s.c[0] = x;
+        return 0;
+    }
+    if (accept_word(ps, "q")) {
+        if (new_value(ps, v))
+            return -1;
+        if (ps->ord > 1)
+            v->s.c[1] = 1;
+        return 0;
+    }
+    if (accept_word(ps, "eta")) {
+        if (expect(ps, '(') || parse_int(ps, &x) || expect(ps, ')'))
+            return -1;
+        if (x < 1)
+            return error(ps, "eta(d) needs d >= 1");
+        return pochhammer(ps, 1, x, x, -1, v);
+    }
+    if (accept_word(ps, "theta")) {
+        sparse_qseries_t sp;
+        if (expect(ps, '(') || parse_int(ps, &x) || expect(ps, ',') ||
+                parse_int(ps, &y) || expect(ps, ')'))
+            return -1;
+        if (x < 1 || x >= y)
+            return error(ps, "theta(a, m) needs 0 < a < m");
+        if (new_value(ps, v))
+            return -1;
+        set_key(v, "T%" PRId64 ",%" PRId64, x, y);
+        if (cache_get(ps, v))
+            return 0;
+        if (theta_sparse(x, y, ps->ord, &sp)) {
+            free_value(v);
+            return error(ps, "out of memory");
+        }
+        for (size_t i = 0; i < sp.num; i++)
+            v->s.c[sp.deg[i]] = sp.c[i];
+        free_sparse_qseries(&sp);
+        cache_put(ps, v);
+        return 0;
+    }
+    if (accept(ps, '(')) {
+        if (parse_expr(ps, v))
+            return -1;
+        c = peek(ps);
+        if (c == ',' || c == ';')
+            return parse_pochhammer(ps, v);
+        if (expect(ps, ')')) {
+            free_value(v);
+            return -1;
+        }
+        return 0;
+    }
+    if (c == '\0')
+        return error(ps, "unexpected end");
+    return error(ps, "unexpected '%c'", c);
+}
+
+/* power := primary {"^" exponent} */
+static int parse_power(parser_t *ps, value_t *v)
+{
+    int64_t p = 0, r = 1;
+    char key[KEYLEN];
+
+    if (parse_primary(ps, v))
+        return -1;
+    while (accept(ps, '^')) {
+        if (parse_exponent(ps, &p, &r)) {
+            free_value(v);
+            return -1;
+        }
+        snprintf(key, KEYLEN, "%s", v->key);
+        if (key[0])
+            set_key(v, "(%s)^%" PRId64 "/%" PRId64, key, p, r);
+        if (cache_get(ps, v))
+            continue;
+        if (power(ps, v, p, r)) {
+            free_value(v);
+            return -1;
+        }
+        cache_put(ps, v);
+    }
+    return 0;
+}
+
+/* unary := "-" unary | power */
+static int parse_unary(parser_t *ps, value_t *v)
+{
+    if (! accept(ps, '-'))
+        return parse_power(ps, v);
+    if (parse_unary(ps, v))
+        return -1;
+    scale_qseries(-1, &v->s, &v->s);
+    v->key[0] = '\0';
+    return 0;
+}
+
+/* Can a factor start with `c` (juxtaposition)? */
+static inline bool starts_factor(char c)
+{
+    return c == '(' || isalnum((unsigned char) c);
+}
+
+/* term := unary {["*" | "/"] unary} */
+static int parse_term(parser_t *ps, value_t *v)
+{
+    value_t w;
+    bool div;
+
+    if (parse_unary(ps, v))
+        return -1;
+    for (;;) {
+        if (accept(ps, '*'))
+            div = false;
+        else if (accept(ps, '/'))
+            div = true;
+        else if (starts_factor(peek(ps)))
+            div = false;
+        else
+            return 0;
+        if (parse_unary(ps, &w)) {
+            free_value(v);
+            return -1;
+        }
+        if (product(ps, v, &w, div))
+            return -1;
+    }
+}
+
+/* expr := term {("+" | "-") term} */
+static int parse_expr(parser_t *ps, value_t *v)
+{
+    value_t w;
+    bool sub;
+
+    if (parse_term(ps, v))
+        return -1;
+    for (;;) {
+        if (accept(ps, '+'))
+            sub = false;
+        else if (accept(ps, '-'))
+            sub = true;
+        else
+            return 0;
+        if (parse_term(ps, &w)) {
+            free_value(v);
+            return -1;
+        }
+        if (sub)
+            subtract_qseries(&v->s, &w.s, &v->s);
+        else
+            add_qseries(&v->s, &w.s, &v->s);
+        v->key[0] = '\0';
+        free_value(&w);
+    }
+}
+
+int qexpr_eval(const char *expr, qexpr_cache_t *cache, qseries_t *ans,
+        char *err, size_t errlen)
+{
+    parser_t ps = {expr, expr, ans->ord, cache, err, errlen};
+    value_t v;
+
+    if (ans->ord == 0)
+        return error(&ps, "order 0");
+    if (parse_expr(&ps, &v))
+        return -1;
+    if (peek(&ps) != '\0') {
+        free_value(&v);
+        return error(&ps, "unexpected '%c'", peek(&ps));
+    }
+    cp_qseries(&v.s, ans);
+    free_value(&v);
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * qexpr.h - Expressions for truncated q-series (header file).
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Product sides (and other q-series) written as expressions, parsed
+ * and evaluated at runtime, e.g.
+ *
+ *   1/((q;q^5)_inf (q^4;q^5)_inf)
+ *   (q,q^4;q^5)_oo^-1
+ *   eta(2)^2/eta(1)
+ *   (1 - 4*q^2)^(-1/2) + 3*q^7
+ *
+ * Grammar (white space is ignored):
+ *
+ *   expr     := term { ("+" | "-") term }
+ *   term     := unary { ["*" | "/"] unary }    (juxtaposition: *)
+ *   unary    := "-" unary | power
+ *   power    := primary { "^" exponent }
+ *   exponent := ["-"] INT | "(" ["-"] INT ["/" INT] ")"
+ *   primary  := INT | "q" | "(" expr ")"
+ *             | "(" expr { "," expr } ";" expr ")" ["_" (INT | "inf" | "oo")]
+ *             | "eta" "(" INT ")" | "theta" "(" INT "," INT ")"
+ *
+ * A q-Pochhammer symbol (A1, ..., Ar; B)_N is the product of the
+ * (Ai; B)_N, with each Ai a monomial a q^k (k >= 0) and B = q^m
+ * (m >= 1); N is infinite if it is not given.  eta(d) is
+ * (q^d;q^d)_oo (without the q^(d/24)) and theta(a, m) the Jacobi
+ * triple product (q^a, q^(m-a), q^m; q^m)_oo.  Quotients need a
+ * divisor with constant term +-1, and fractional powers integer
+ * coefficients (see `powq_qseries`).
+ *
+ * A cache keeps the q-Pochhammer symbols (and their powers) evaluated
+ * for one expression for the next ones, so a batch of related
+ * products shares most of the work.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "qseries.h"
+
+/* A cached value. */
+typedef struct {
+    char *key;          /* Canonical form, e.g. "P1,1,5,-1". */
+    uint64_t hash;
+    qseries_t s;
+} qexpr_entry_t;
+
+/* Cache of subexpressions (shared by a batch of expressions). */
+typedef struct {
+    size_t num;
+    size_t cap;
+    qexpr_entry_t *entries;
+    uint64_t hits;
+    uint64_t misses;
+} qexpr_cache_t;
+
+/* Make an empty cache. */
+void qexpr_cache_init(qexpr_cache_t *cache);
+
+/* Free the cache and its entries. */
+void qexpr_cache_free(qexpr_cache_t *cache);
+
+/*
+ * Evaluate the expression `expr` up to the order of `ans`, through
+ * `cache` (may be NULL).  Returns 0 on success, and -1 on a syntax or
+ * evaluation error, with a message in `err` (of size `errlen`).
+ */
+int qexpr_eval(const char *expr, qexpr_cache_t *cache, qseries_t *ans,
+        char *err, size_t errlen);
@@ -3,7 +3,7 @@
  *
  * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
  * Created:  2016-07-05
- * Modified: 2016-07-13
+ * Modified: 2026-10-18
  * License:  MIT License (see LICENSE.txt)
  *
  * Compilation Suggestions:
@@ -16,216 +16,2608 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
 #include <inttypes.h>
 #include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "qseries.h"
 #include "util.h"
 
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
 
 /*******************************************************************\
  * Initializers                                                    *
  *******************************************************************/
 
-void init_qseries(qseries_t s, int64_t initial_val)
+int alloc_qseries(qseries_t *s, size_t ord)
 {
-    for (size_t deg = 0; deg < MAXORD; deg++)
-        s[deg] = initial_val;
+    s->ord = ord;
+    s->c = calloc(ord ? ord : 1, sizeof(int64_t));
+    return (s->c == NULL) ? -1 : 0;
+}
+
+void free_qseries(qseries_t *s)
+{
+    free(s->c);
+    s->c = NULL;
+    s->ord = 0;
+}
+
+void init_qseries(qseries_t *s, int64_t initial_val)
+{
+    for (size_t deg = 0; deg < s->ord; deg++)
+        s->c[deg] = initial_val;
 }
 
 void mk_qseries(const int64_t a[], size_t start, size_t num,
-        size_t offset, qseries_t s)
+        size_t offset, qseries_t *s)
 {
-    size_t max = MIN(MAXORD, num + offset);
+    size_t max = MIN(s->ord, num + offset);
     for (size_t deg = offset; deg + offset < max; deg++)
-        s[deg] = a[start + deg];
+        s->c[deg] = a[start + deg];
+}
+
+void cp_qseries(const qseries_t *s, qseries_t *t)
+{
+    memcpy(t->c, s->c, t->ord * sizeof(int64_t));
+}
+
+/*******************************************************************\
+ * Workspaces                                                      *
+ *******************************************************************/
+
+/* Blocks are aligned to cache lines; chunks are at least 64 KiB. */
+#define QWS_ALIGN 64
+#define QWS_MIN_CHUNK (64 * 1024)
+
+void qws_init(qws_t *ws)
+{
+    memset(ws, 0, sizeof(*ws));
+}
+
+void qws_free(qws_t *ws)
+{
+    for (size_t i = 0; i < ws->num; i++)
+        free(ws->chunk[i].mem);
+    qws_init(ws);
+}
+
+static pthread_once_t qws_once = PTHREAD_ONCE_INIT;
+static pthread_key_t qws_key;
+
+static void qws_destroy(void *ws)
+{
+    qws_free(ws);
+    free(ws);
+}
+
+static void qws_make_key(void)
+{
+    pthread_key_create(&qws_key, qws_destroy);
+}
+
+qws_t *qws_default(void)
+{
+    qws_t *ws;
+
+    pthread_once(&qws_once, qws_make_key);
+    if ((ws = pthread_getspecific(qws_key)) == NULL) {
+        if ((ws = calloc(1, sizeof(qws_t))) == NULL ||
+                pthread_setspecific(qws_key, ws)) {
+            fprintf(stderr, "[ERR] qws_default: out of memory!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return ws;
 }
 
-void cp_qseries(const qseries_t s, qseries_t t)
+void *qws_alloc(qws_t *ws, size_t size)
 {
-    for (size_t deg = 0; deg < MAXORD; deg++)
-        t[deg] = s[deg];
+    qws_chunk_t *c;
+    size_t next, new_size;
+    char *mem;
+
+    size = (size + QWS_ALIGN - 1) / QWS_ALIGN * QWS_ALIGN;
+    if (ws->num) {
+        c = &ws->chunk[ws->cur];
+        if (c->top + size <= c->size)
+            goto take;
+        /* The chunks after the current one are free. */
+        if (ws->cur + 1 < ws->num && ws->chunk[ws->cur + 1].size >= size) {
+            c = &ws->chunk[++ws->cur];
+            c->top = 0;
+            goto take;
+        }
+    }
+    /* A new chunk after the current one (replacing the smaller ones). */
+    next = ws->num ? ws->cur + 1 : 0;
+    for (size_t i = next; i < ws->num; i++)
+        free(ws->chunk[i].mem);
+    ws->num = next;
+    if (next >= QWS_CHUNKS)
+        return NULL;
+    new_size = MAX(size, QWS_MIN_CHUNK);
+    if (next)
+        new_size = MAX(new_size, 2 * ws->chunk[next - 1].size);
+    if ((mem = aligned_alloc(QWS_ALIGN, new_size)) == NULL)
+        return NULL;
+    ws->chunk[next] = (qws_chunk_t) {new_size, 0, mem};
+    ws->num = next + 1;
+    ws->cur = next;
+    c = &ws->chunk[next];
+take:
+    mem = c->mem + c->top;
+    c->top += size;
+    return mem;
+}
+
+int qws_series(qws_t *ws, size_t ord, qseries_t *s)
+{
+    s->ord = ord;
+    s->c = qws_alloc(ws, (ord ? ord : 1) * sizeof(int64_t));
+    if (s->c == NULL)
+        return -1;
+    memset(s->c, 0, (ord ? ord : 1) * sizeof(int64_t));
+    return 0;
+}
+
+qws_mark_t qws_mark(const qws_t *ws)
+{
+    return (qws_mark_t) {ws->cur, ws->num ? ws->chunk[ws->cur].top : 0};
+}
+
+void qws_release(qws_t *ws, qws_mark_t m)
+{
+    if (ws->num == 0)
+        return;
+    ws->cur = m.cur;
+    ws->chunk[m.cur].top = m.top;
+}
+
+/* A scratch series from the workspace `ws` (exits if out of memory). */
+static inline void scratch_series(qws_t *ws, size_t ord, qseries_t *s,
+        const char *func)
+{
+    if (qws_series(ws, ord, s)) {
+        fprintf(stderr, "[ERR] %s: out of memory!\n", func);
+        exit(EXIT_FAILURE);
+    }
 }
 
 /*******************************************************************\
  * Input/Output                                                    *
  *******************************************************************/
 
-void print_qseries(const qseries_t s, size_t ord)
+/* Output buffered and formatted by hand (printf is slow per term). */
+typedef struct {
+    FILE *fp;
+    size_t len;
+    char buf[1 << 16];
+} outbuf_t;
+
+static inline void out_flush(outbuf_t *o)
+{
+    fwrite(o->buf, 1, o->len, o->fp);
+    o->len = 0;
+}
+
+/* Put `len` (< 64) bytes. */
+static inline void out_mem(outbuf_t *o, const char *p, size_t len)
+{
+    if (o->len + len > sizeof(o->buf))
+        out_flush(o);
+    memcpy(o->buf + o->len, p, len);
+    o->len += len;
+}
+
+static inline void out_str(outbuf_t *o, const char *p)
+{
+    out_mem(o, p, strlen(p));
+}
+
+static inline void out_uint(outbuf_t *o, uint64_t v)
+{
+    char tmp[24];
+    int i = sizeof(tmp);
+
+    do {
+        tmp[--i] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    out_mem(o, tmp + i, sizeof(tmp) - i);
+}
+
+static inline void out_int(outbuf_t *o, int64_t v)
+{
+    if (v < 0)
+        out_mem(o, "-", 1);
+    out_uint(o, (v < 0) ? -(uint64_t) v : (uint64_t) v);
+}
+
+void fprint_qseries(FILE *fp, const qseries_t *s, size_t ord)
 {
-    size_t max = MIN(MAXORD, ord);
-    size_t deg = 0;
-    int nonzero_terms = 0;
-    int64_t abs_coeff;
-    int neg;
-    char *sgn;
+    size_t max = MIN(s->ord, ord);
+    bool nonzero_terms = false;
+    uint64_t abs_coeff;
+    bool neg;
+    outbuf_t o = {.fp = fp};
 
-    for (deg = 0; deg < max; deg++) {
-        if (s[deg] == 0)
+    for (size_t deg = 0; deg < max; deg++) {
+        if (s->c[deg] == 0)
             continue;
-        abs_coeff = (s[deg] > 0) ? s[deg] : -s[deg];
-        neg = abs_coeff - s[deg];
-        sgn = (neg)? "-" : "+";
-        if (nonzero_terms) {
-            printf(" %s ", sgn);
-            sgn = "";
-        } else {
-            sgn = (neg) ? "-" : "";
-        }
-        if (deg == 0) {
-            printf("%s%" PRId64, sgn, abs_coeff);
-        } else {
-            if (abs_coeff == 1)
-                printf("%s", sgn);
-            else
-                printf("%s%" PRId64 "*", sgn, abs_coeff);
-            if (deg == 1)
-                printf("q");
-            else
-                printf("q^%zu", deg);
+        neg = s->c[deg] < 0;
+        abs_coeff = neg ? -(uint64_t) s->c[deg] : (uint64_t) s->c[deg];
+        if (nonzero_terms)
+            out_str(&o, neg ? " - " : " + ");
+        else if (neg)
+            out_str(&o, "-");
+        if (deg == 0 || abs_coeff != 1)
+            out_uint(&o, abs_coeff);
+        if (deg > 0) {
+            out_str(&o, (abs_coeff != 1) ? "*q" : "q");
+            if (deg > 1) {
+                out_str(&o, "^");
+                out_uint(&o, deg);
+            }
         }
-        nonzero_terms++;
+        nonzero_terms = true;
     }
     if (! nonzero_terms)
-        printf("0");
-    printf(" + O(%zu)", max);
+        out_str(&o, "0");
+    out_str(&o, " + O(");
+    out_uint(&o, max);
+    out_str(&o, ")");
+    out_flush(&o);
 }
 
-void println_qseries(const qseries_t s, size_t ord)
+void print_qseries(const qseries_t *s, size_t ord)
+{
+    fprint_qseries(stdout, s, ord);
+}
+
+void println_qseries(const qseries_t *s, size_t ord)
 {
     print_qseries(s, ord);
     printf("\n");
 }
 
-void print_coeffs(const qseries_t s, size_t ord)
+void fprint_coeffs(FILE *fp, const qseries_t *s, size_t ord)
+{
+    size_t max = MIN(s->ord, ord);
+    outbuf_t o = {.fp = fp};
+
+    out_str(&o, "[");
+    for (size_t deg = 0; deg < max; deg++) {
+        if (deg != 0)
+            out_str(&o, ", ");
+        out_int(&o, s->c[deg]);
+    }
+    out_str(&o, "]");
+    out_flush(&o);
+}
+
+void print_coeffs(const qseries_t *s, size_t ord)
 {
-    print_array_int64(ord, s);
+    fprint_coeffs(stdout, s, ord);
 }
 
-void println_coeffs(const qseries_t s, size_t ord)
+void println_coeffs(const qseries_t *s, size_t ord)
 {
-    print_array_int64(ord, s);
+    print_coeffs(s, ord);
     printf("\n");
 }
 
-/* TODO */
-void read_qseries(const char *buf, qseries_t s)
+static inline const char *skip_space(const char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        p++;
+    return p;
+}
+
+/* Parse the digits at `*p` into `v`; -1 if there are none or overflow. */
+static inline int parse_uint(const char **p, uint64_t *v)
+{
+    const char *q = *p;
+    uint64_t x = 0;
+
+    if (*q < '0' || *q > '9')
+        return -1;
+    for (; *q >= '0' && *q <= '9'; q++)
+        if (__builtin_mul_overflow(x, 10, &x) ||
+                __builtin_add_overflow(x, (uint64_t) (*q - '0'), &x))
+            return -1;
+    *p = q;
+    *v = x;
+    return 0;
+}
+
+/* Signed 64-bit value of the magnitude `v`; -1 if out of range. */
+static inline int to_int64(uint64_t v, bool neg, int64_t *x)
+{
+    if (v > (uint64_t) INT64_MAX + neg)
+        return -1;
+    *x = neg ? (int64_t) -v : (int64_t) v;
+    return 0;
+}
+
+/* Parse an integer (with an optional sign) at `*p`. */
+static inline int parse_int(const char **p, int64_t *x)
+{
+    const char *q = *p;
+    bool neg = (*q == '-');
+    uint64_t v;
+
+    if (*q == '-' || *q == '+')
+        q++;
+    if (parse_uint(&q, &v) || to_int64(v, neg, x))
+        return -1;
+    *p = q;
+    return 0;
+}
+
+/*
+ * Parse the terms of `buf` (as printed by `print_qseries`) into `s`,
+ * or only check them if `s` is NULL, and find the order of the text.
+ */
+static int parse_qseries(const char *buf, qseries_t *s, size_t *ord)
+{
+    const char *p = skip_space(buf);
+    uint64_t mag, deg, top = 0, big_o;
+    bool neg, have_coef, have_o = false;
+    int64_t x;
+
+    if (*p == '\0')
+        return -1;
+    for (bool first = true; *p != '\0'; first = false) {
+        neg = false;
+        if (*p == '+' || *p == '-') {
+            neg = (*p == '-');
+            p = skip_space(p + 1);
+        } else if (! first) {
+            return -1;
+        }
+        if (*p == 'O') {
+            /* O(N) or O(q^N) ends the series. */
+            p = skip_space(p + 1);
+            if (*p++ != '(')
+                return -1;
+            p = skip_space(p);
+            big_o = 1;
+            if (*p == 'q') {
+                p = skip_space(p + 1);
+                if (*p == '^') {
+                    p = skip_space(p + 1);
+                    if (parse_uint(&p, &big_o))
+                        return -1;
+                }
+            } else if (parse_uint(&p, &big_o)) {
+                return -1;
+            }
+            p = skip_space(p);
+            if (neg || *p++ != ')' || *skip_space(p) != '\0' ||
+                    big_o >= SIZE_MAX)
+                return -1;
+            have_o = true;
+            break;
+        }
+        mag = 1;
+        deg = 0;
+        have_coef = (*p >= '0' && *p <= '9');
+        if (have_coef) {
+            if (parse_uint(&p, &mag))
+                return -1;
+            p = skip_space(p);
+            if (*p == '*') {
+                p = skip_space(p + 1);
+                if (*p != 'q')
+                    return -1;
+            }
+        }
+        if (*p == 'q') {
+            deg = 1;
+            p = skip_space(p + 1);
+            if (*p == '^') {
+                p = skip_space(p + 1);
+                if (parse_uint(&p, &deg))
+                    return -1;
+                p = skip_space(p);
+            }
+        } else if (! have_coef) {
+            return -1;
+        }
+        if (to_int64(mag, neg, &x) || deg >= SIZE_MAX - 1)
+            return -1;
+        if (deg + 1 > top)
+            top = deg + 1;
+        if (s && deg < s->ord)
+            s->c[deg] += x;
+    }
+    *ord = have_o ? big_o : top;
+    return 0;
+}
+
+int read_qseries(const char *buf, qseries_t *s)
+{
+    size_t ord;
+    bool own = (s->c == NULL);
+
+    if (parse_qseries(buf, NULL, &ord))
+        return -1;
+    if (own && alloc_qseries(s, ord))
+        return -1;
+    init_qseries(s, 0);
+    parse_qseries(buf, s, &ord);
+    return 0;
+}
+
+/*
+ * Parse the list of integers `buf` into `s` (or only count them if `s`
+ * is NULL).
+ */
+static int parse_coeffs(const char *buf, qseries_t *s, size_t *num)
 {
-    char *str1, *str2, *tok, *subtok;
-    char *saveptr1, *saveptr2;
-    int j;
+    const char *p = buf;
+    size_t n = 0;
+    int64_t x;
 
-    for (j = 1, str1 = strdup(buf); ; j++, str1 = NULL) {
-        tok = strtok_r(str1, "+", &saveptr1);
-        if (tok == NULL)
+    for (;;) {
+        while (*p == ',' || *p == '[' || *p == ']' || *p == ' ' ||
+                *p == '\t' || *p == '\n' || *p == '\r')
+            p++;
+        if (*p == '\0')
             break;
-        printf ("Term[%d]: %s\n", j, tok);
+        if (parse_int(&p, &x))
+            return -1;
+        if (s && n < s->ord)
+            s->c[n] = x;
+        n++;
+    }
+    *num = n;
+    return 0;
+}
 
-        for (str2 = tok; ; str2 = NULL) {
-            subtok = strtok_r(str2, "*", &saveptr2);
-            if (subtok == NULL)
-                break;
-            printf(" --> %s\n", subtok);
+int read_coeffs(const char *buf, qseries_t *s)
+{
+    size_t num;
+    bool own = (s->c == NULL);
+
+    if (parse_coeffs(buf, NULL, &num) || (own && num == 0))
+        return -1;
+    if (own && alloc_qseries(s, num))
+        return -1;
+    init_qseries(s, 0);
+    parse_coeffs(buf, s, &num);
+    return 0;
+}
+
+int read_bfile(FILE *fp, qseries_t *s)
+{
+    bool own = (s->c == NULL);
+    size_t cap = 0, top = 0, size = 0;
+    char *line = NULL;
+    const char *p;
+    int64_t n, x;
+
+    if (own)
+        s->ord = 0;
+    else
+        init_qseries(s, 0);
+    while (getline(&line, &size, fp) != -1) {
+        p = skip_space(line);
+        if (*p == '\0' || *p == '#')
+            continue;
+        if (parse_int(&p, &n) || n < 0 || (*p != ' ' && *p != '\t'))
+            goto fail;
+        p = skip_space(p);
+        if (parse_int(&p, &x) || *skip_space(p) != '\0')
+            goto fail;
+        if (own && (size_t) n >= cap) {
+            size_t new_cap = MAX((size_t) n + 1, 2 * cap);
+            int64_t *c = realloc(s->c, new_cap * sizeof(int64_t));
+            if (c == NULL)
+                goto fail;
+            memset(c + cap, 0, (new_cap - cap) * sizeof(int64_t));
+            s->c = c;
+            cap = new_cap;
         }
+        if ((size_t) n >= top)
+            top = n + 1;
+        if ((size_t) n < (own ? cap : s->ord))
+            s->c[n] = x;
+    }
+    free(line);
+    if (own) {
+        if (top == 0)
+            goto fail_empty;
+        s->ord = top;
+    }
+    return ferror(fp) ? -1 : 0;
+fail:
+    free(line);
+fail_empty:
+    if (own)
+        free_qseries(s);
+    return -1;
+}
+
+/*
+ * Binary series files: the header, the extension (padded to 8 bytes),
+ * then the coefficients (in the byte order of the machine).
+ */
+#define QSERIES_MAGIC "QSERIES2"
+#define QSERIES_BOM 0x01020304u
+#define QSERIES_MAX_EXT 65536
+
+typedef struct {
+    char magic[8];
+    uint32_t bom;           /* Byte order mark. */
+    uint32_t ext_len;       /* Bytes of the extension (unpadded). */
+    uint64_t ord;
+    uint64_t checksum;      /* Of the extension and the coefficients. */
+} qseries_header_t;
+
+/* Padded length of an extension of `len` bytes. */
+static inline size_t ext_size(size_t len)
+{
+    return (len + 7) / 8 * 8;
+}
+
+int save_qseries(const char *path, const qseries_t *s)
+{
+    return save_qseries_ext(path, s, NULL, 0);
+}
+
+int save_qseries_ext(const char *path, const qseries_t *s,
+        const void *ext, size_t ext_len)
+{
+    static const char pad[8];
+    char tmp[4096];
+    qseries_header_t h;
+    size_t npad = ext_size(ext_len) - ext_len;
+    FILE *fp;
+    bool ok;
+
+    if (ext_len > QSERIES_MAX_EXT ||
+            snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path,
+                (long) getpid()) >= (int) sizeof(tmp))
+        return -1;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, QSERIES_MAGIC, 8);
+    h.bom = QSERIES_BOM;
+    h.ext_len = ext_len;
+    h.ord = s->ord;
+    h.checksum = fnv1a(FNV1A_BASIS, ext, ext_len);
+    h.checksum = fnv1a(h.checksum, s->c, s->ord * sizeof(int64_t));
+    if ((fp = fopen(tmp, "wb")) == NULL)
+        return -1;
+    ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+        (ext_len == 0 || fwrite(ext, 1, ext_len, fp) == ext_len) &&
+        fwrite(pad, 1, npad, fp) == npad &&
+        fwrite(s->c, sizeof(int64_t), s->ord, fp) == s->ord;
+    if (fclose(fp) || ! ok || rename(tmp, path)) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int map_qseries(const char *path, qseries_map_t *m)
+{
+    const qseries_header_t *h;
+    const char *ext;
+    struct stat st;
+    uint64_t sum;
+    size_t off;
+    void *map;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return -1;
+    if (fstat(fd, &st) || (size_t) st.st_size < sizeof(*h)) {
+        close(fd);
+        return -1;
     }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+    h = map;
+    ext = (const char *) (h + 1);
+    off = sizeof(*h) + ext_size(h->ext_len);
+    if (memcmp(h->magic, QSERIES_MAGIC, 8) || h->bom != QSERIES_BOM ||
+            h->ext_len > QSERIES_MAX_EXT || (size_t) st.st_size < off ||
+            h->ord == 0 || h->ord > (st.st_size - off) / 8 ||
+            (size_t) st.st_size != off + h->ord * sizeof(int64_t))
+        goto invalid;
+    sum = fnv1a(FNV1A_BASIS, ext, h->ext_len);
+    sum = fnv1a(sum, (char *) map + off, h->ord * sizeof(int64_t));
+    if (sum != h->checksum)
+        goto invalid;
+    m->map = map;
+    m->len = st.st_size;
+    m->ext = h->ext_len ? ext : NULL;
+    m->ext_len = h->ext_len;
+    m->s.ord = h->ord;
+    m->s.c = (int64_t *) ((char *) map + off);
+    return 0;
+invalid:
+    munmap(map, st.st_size);
+    return -1;
+}
+
+void unmap_qseries(qseries_map_t *m)
+{
+    if (m->map)
+        munmap(m->map, m->len);
+    m->map = NULL;
+    m->ext = NULL;
+    m->ext_len = 0;
+    m->s.c = NULL;
+    m->s.ord = 0;
 }
 
 /*******************************************************************\
- * Basic Operations                                                *
+ * Large Orders                                                    *
  *******************************************************************/
 
-void shift_qseries(const qseries_t s, int shift, qseries_t ans)
+/*
+ * Products of order ord (terms) go by tiers: schoolbook below
+ * KARATSUBA_MIN, Karatsuba below NTT_MIN, and number theoretic
+ * transforms (NTT) up to NTT_MAX_ORD (beyond, by blocks of NTT).
+ * From PARALLEL_MIN, the Karatsuba products are cut into blocks and
+ * the transforms into ranges of butterflies, over qseries_threads()
+ * threads (started for each product).  Inverses with constant term
+ * +-1 go by Newton iteration from NEWTON_MIN, and quotients by such
+ * an inverse from DIVIDE_MIN.  (The thresholds are the crossovers on
+ * one thread.)
+ */
+#define KARATSUBA_MIN 96
+#define KARATSUBA_CUTOFF 32     /* Schoolbook below (in Karatsuba). */
+#define NTT_MIN 16384
+#define NTT_MAX_ORD ((size_t) 1 << 24)
+#define NTT_BLOCK 4096          /* Stages done a block at a time. */
+#define PARALLEL_MIN 4096
+#define NEWTON_MIN 512
+#define DIVIDE_MIN 1024
+
+/*
+ * The cost of a product of order `ord`, in steps of the schoolbook
+ * product (as measured for each tier, roughly).
+ */
+static inline double product_cost(size_t ord)
 {
-    for (size_t deg = 0; deg < MAXORD; deg++)
-        ans[deg] = ((int) deg < shift) ? 0: s[deg - shift];
+    double cost = 1;
+    size_t n = ord;
+
+    if (ord < KARATSUBA_MIN)
+        return (double) ord * ord / 2;
+    if (ord < NTT_MIN) {
+        while (n >= KARATSUBA_CUTOFF) {
+            n = (n + 1) / 2;
+            cost *= 3;
+        }
+        return cost * n * n;
+    }
+    while (n > 1) {
+        n /= 2;
+        cost++;
+    }
+    return 64 * cost * ord;
 }
 
-void scale_qseries(int64_t c, const qseries_t s, qseries_t ans)
+/* Threads of the operations on large orders (0: the online CPUs). */
+static int qseries_nthreads;
+
+void set_qseries_threads(int threads)
 {
-    for (size_t deg = 0; deg < MAXORD; deg++)
-        ans[deg] = c * s[deg];
+    qseries_nthreads = threads;
 }
 
-void add_qseries(const qseries_t s, const qseries_t t, qseries_t ans)
+int qseries_threads(void)
 {
-    for (size_t deg = 0; deg < MAXORD; deg++)
-        ans[deg] = s[deg] + t[deg];
+    long cpus;
+
+    if (qseries_nthreads > 0)
+        return qseries_nthreads;
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? cpus : 1;
 }
 
-void subtract_qseries(const qseries_t s, const qseries_t t, qseries_t ans)
+/* A thread of `run_parallel`. */
+typedef struct {
+    void (*func)(void *arg, int t);
+    void *arg;
+    int t;
+} par_task_t;
+
+static void *par_start(void *task)
 {
-    for (size_t deg = 0; deg < MAXORD; deg++)
-        ans[deg] = s[deg] - t[deg];
+    par_task_t *p = task;
+
+    p->func(p->arg, p->t);
+    return NULL;
 }
 
-void multiply_qseries(const qseries_t s, const qseries_t t, qseries_t ans)
+/*
+ * Run func(arg, t) for t = 0, ..., T-1, each in a thread of its own
+ * (t = 0 in the caller), and wait for them.
+ */
+static void run_parallel(int T, void (*func)(void *arg, int t), void *arg,
+        const char *name)
 {
-    int64_t sum;
-    size_t i;
-    for (size_t deg = 0; deg < MAXORD; deg++) {
-        for(i = 0, sum = 0; i <= deg; i++)
-            sum += s[i] * t[deg - i];
-        ans[deg] = sum;
+    pthread_t thread[T];
+    par_task_t task[T];
+
+    for (int t = 1; t < T; t++) {
+        task[t] = (par_task_t) {func, arg, t};
+        if (pthread_create(&thread[t], NULL, par_start, &task[t])) {
+            fprintf(stderr, "[ERR] %s: cannot start a thread!\n", name);
+            exit(EXIT_FAILURE);
+        }
     }
+    func(arg, 0);
+    for (int t = 1; t < T; t++)
+        pthread_join(thread[t], NULL);
 }
 
-void invert_qseries(const qseries_t s, qseries_t ans)
+/* Memory of the large orders (too large to keep in a workspace). */
+static inline void *large_alloc(size_t size, const char *func)
 {
-    int64_t sum;
-    size_t i;
-    ans[0] = 1/s[0];
-    for (size_t deg = 1; deg < MAXORD; deg++) {
-        for (i = 1, sum = 0; i <= deg; i++)
-            sum += s[i] * ans[deg - i];
-        ans[deg] = -sum / s[0];
+    void *p = aligned_alloc(QWS_ALIGN, (size + QWS_ALIGN - 1) &
+            ~(size_t) (QWS_ALIGN - 1));
+
+    if (p == NULL) {
+        fprintf(stderr, "[ERR] %s: out of memory!\n", func);
+        exit(EXIT_FAILURE);
     }
+    return p;
 }
 
-void divide_qseries(const qseries_t s, const qseries_t t, qseries_t ans)
+/*
+ * out[0..2n-2] = a[0..n-1] b[0..n-1] (all the terms), with `tmp` of
+ * at least KARATSUBA_TMP(n) terms (`out` is neither `a` nor `b`).
+ * Unsigned, so that the sums and differences wrap modulo 2^64.
+ */
+#define KARATSUBA_TMP(n) (4 * (n) + 256)
+
+static void karatsuba(const uint64_t *a, const uint64_t *b, size_t n,
+        uint64_t *out, uint64_t *tmp)
 {
-    qseries_t tmp;
-    invert_qseries(t, tmp);
-    multiply_qseries(s, tmp, ans);
+    size_t h = n / 2, k = n - h;
+    uint64_t *sa = tmp, *sb = tmp + k, *z1 = tmp + 2 * k;
+
+    if (n < KARATSUBA_CUTOFF) {
+        memset(out, 0, (2 * n - 1) * sizeof(uint64_t));
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++)
+                out[i + j] += a[i] * b[j];
+        return;
+    }
+    /* a = a0 + q^h a1 (h and k terms), the same for b. */
+    karatsuba(a, b, h, out, tmp);
+    out[2 * h - 1] = 0;
+    karatsuba(a + h, b + h, k, out + 2 * h, tmp);
+    for (size_t i = 0; i < k; i++) {
+        sa[i] = a[h + i] + (i < h ? a[i] : 0);
+        sb[i] = b[h + i] + (i < h ? b[i] : 0);
+    }
+    karatsuba(sa, sb, k, z1, tmp + 4 * k);
+    /* (a0 + a1)(b0 + b1) - a0 b0 - a1 b1, at q^h. */
+    for (size_t i = 0; i < 2 * k - 1; i++)
+        z1[i] -= out[2 * h + i] + (i < 2 * h - 1 ? out[i] : 0);
+    for (size_t i = 0; i < 2 * k - 1; i++)
+        out[h + i] += z1[i];
 }
 
-/* Compute q-series `s`, raised to the power `n`, result in `ans`. */
-/* Right now, n is assumed to be an integer. */
-void pow_qseries(const qseries_t s, int n, qseries_t ans)
+/*
+ * A product by blocks: s, t cut into `nb` blocks of `len` terms, and
+ * the products of blocks i, j with i + j < nb (those below q^ord)
+ * taken by the threads in turn, each adding into its own `acc`.
+ */
+typedef struct {
+    const int64_t *s, *t;
+    size_t ord, len;
+    size_t nb, num;         /* Blocks, products of blocks. */
+    size_t next;            /* Next product of blocks. */
+    uint64_t *acc;          /* [thread][ord] */
+} blocks_job_t;
+
+static void blocks_thread(void *arg, int thr)
 {
-    qseries_t s0, tmp;
-    int abs_n = 0;
+    blocks_job_t *job = arg;
+    size_t len = job->len, ord = job->ord, p;
+    qws_t *ws = qws_default();
+    qws_mark_t m = qws_mark(ws);
+    uint64_t *acc = job->acc + thr * ord, *a, *b, *out, *tmp;
 
-    if (n > 0) {
-        cp_qseries(s, s0);
-        abs_n = n;
-    } else if (n < 0) {
-        invert_qseries(s, s0);
-        abs_n = -n;
+    a = qws_alloc(ws, 2 * len * sizeof(uint64_t));
+    out = qws_alloc(ws, 2 * len * sizeof(uint64_t));
+    tmp = qws_alloc(ws, KARATSUBA_TMP(len) * sizeof(uint64_t));
+    if (a == NULL || out == NULL || tmp == NULL) {
+        fprintf(stderr, "[ERR] multiply_qseries: out of memory!\n");
+        exit(EXIT_FAILURE);
     }
-    init_qseries(ans, 0);
-    ans[0] = 1;
-    for (int i = 0; i < abs_n; i++) {
-        cp_qseries(ans, tmp);
-        multiply_qseries(tmp, s0, ans);
+    b = a + len;
+    memset(acc, 0, ord * sizeof(uint64_t));
+    while ((p = __sync_fetch_and_add(&job->next, 1)) < job->num) {
+        /* Product p is (i, j), in the order of the diagonals i + j. */
+        size_t d = 0, i, j, off, n;
+        while (p > d) {
+            p -= d + 1;
+            d++;
+        }
+        i = p;
+        j = d - p;
+        for (size_t x = 0; x < len; x++) {
+            a[x] = i * len + x < ord ? (uint64_t) job->s[i * len + x] : 0;
+            b[x] = j * len + x < ord ? (uint64_t) job->t[j * len + x] : 0;
+        }
+        karatsuba(a, b, len, out, tmp);
+        off = d * len;
+        n = ord - off < 2 * len - 1 ? ord - off : 2 * len - 1;
+        for (size_t x = 0; x < n; x++)
+            acc[off + x] += out[x];
     }
+    qws_release(ws, m);
 }
 
-/*******************************************************************\
- * Miscellaneous                                                   *
- *******************************************************************/
+/* `ans` = `s` * `t` by Karatsuba (blocks over the threads). */
+static void multiply_karatsuba(const qseries_t *s, const qseries_t *t,
+        qseries_t *ans)
+{
+    size_t ord = ans->ord, nb = 1;
+    int T = ord >= PARALLEL_MIN ? qseries_threads() : 1;
+    blocks_job_t job;
+
+    /* Some 4 products of blocks per thread. */
+    while (T > 1 && nb * (nb + 1) / 2 < 4 * (size_t) T &&
+            ord / (2 * nb) >= KARATSUBA_CUTOFF)
+        nb *= 2;
+    if ((size_t) T > nb * (nb + 1) / 2)
+        T = nb * (nb + 1) / 2;
+    job = (blocks_job_t) {s->c, t->c, ord, (ord + nb - 1) / nb, nb,
+        nb * (nb + 1) / 2, 0, NULL};
+    job.acc = large_alloc(T * ord * sizeof(uint64_t), "multiply_qseries");
+    run_parallel(T, blocks_thread, &job, "multiply_qseries");
+    /* `ans` last: it may be `s` or `t`. */
+    for (size_t deg = 0; deg < ord; deg++) {
+        uint64_t sum = 0;
+        for (int thr = 0; thr < T; thr++)
+            sum += job.acc[thr * ord + deg];
+        ans->c[deg] = sum;
+    }
+    free(job.acc);
+}
+
+/*
+ * NTT products: each coefficient (as 64 bits unsigned) is cut into
+ * 3 limbs of NTT_LIMB bits, and the limb products
+ *   C[d] = sum over i + j = d of A[i] B[j]   (d = 0, 1, 2)
+ * are taken modulo 3 primes p = c 2^k + 1 < 2^32 / 3 (so that the
+ * sums of 3 products reduce at once), where they are exact
+ * (< 3 ord 2^44 < p0 p1 p2 ~ 2^86), put together by CRT
+ * (Garner) and summed as C[0] + 2^22 C[1] + 2^44 C[2] modulo 2^64.
+ * The butterflies multiply by the twiddle factors w as Shoup's, with
+ * w 2^32 / p precomputed (in 32 bit lanes, which vectorize), the rest
+ * is Montgomery's (R = 2^32).
+ */
+#define NTT_LIMB 22
+#define NTT_PRIMES 3
+
+typedef struct {
+    uint32_t p;
+    uint32_t g;         /* A primitive root. */
+    int max_log;        /* 2^max_log divides p - 1. */
+} ntt_prime_t;
+
+static const ntt_prime_t ntt_primes[NTT_PRIMES] = {
+    {167772161, 3, 25}, {469762049, 3, 26}, {1107296257, 10, 25},
+};
+
+/* Montgomery arithmetic modulo p. */
+typedef struct {
+    uint32_t p;
+    uint32_t pinv;      /* -1/p modulo 2^32. */
+    uint32_t r2;        /* R^2 modulo p. */
+} mont_t;
 
-void product_side(int mod, const int cong[mod], qseries_t ans)
+/* x / R modulo p (x < p 2^32). */
+static inline uint32_t mont_reduce(uint64_t x, const mont_t *M)
 {
-    qseries_t tmp, nxt;
-    init_qseries(ans, 0);
-    ans[0] = 1;
-    for (int n = 1; n < MAXORD; n++) {
-        init_qseries(tmp, 0);
-        tmp[0] = 1;
-        tmp[n] = -1;
-        pow_qseries(tmp, cong[n % mod], nxt);
-        cp_qseries(ans, tmp);
-        multiply_qseries(tmp, nxt, ans);
+    uint32_t m = (uint32_t) x * M->pinv;
+    uint32_t u = (x + (uint64_t) m * M->p) >> 32;
+
+    return u >= M->p ? u - M->p : u;
+}
+
+/* x y / R modulo p (x, y < p). */
+static inline uint32_t mont_mul(uint32_t x, uint32_t y, const mont_t *M)
+{
+    return mont_reduce((uint64_t) x * y, M);
+}
+
+static inline uint32_t mod_add(uint32_t x, uint32_t y, uint32_t p)
+{
+    uint32_t s = x + y;
+
+    return s >= p ? s - p : s;
+}
+
+static inline uint32_t mod_sub(uint32_t x, uint32_t y, uint32_t p)
+{
+    return x >= y ? x - y : x + p - y;
+}
+
+/* x w modulo p, with wq = w 2^32 / p (Shoup). */
+static inline uint32_t shoup_mul(uint32_t x, uint32_t w, uint32_t wq,
+        uint32_t p)
+{
+    uint32_t q = ((uint64_t) x * wq) >> 32, r = x * w - q * p;
+
+    return r >= p ? r - p : r;
+}
+
+/* x^e modulo p (plain, for the constants). */
+static inline uint32_t mod_pow(uint64_t x, uint64_t e, uint32_t p)
+{
+    uint64_t r = 1;
+
+    for (x %= p; e; e >>= 1, x = x * x % p)
+        if (e & 1)
+            r = r * x % p;
+    return r;
+}
+
+static inline void mont_init(uint32_t p, mont_t *M)
+{
+    uint32_t inv = p;
+
+    /* Newton's iteration, doubling the correct bits from 3. */
+    for (int i = 0; i < 4; i++)
+        inv *= 2 - p * inv;
+    M->p = p;
+    M->pinv = -inv;
+    M->r2 = ((uint64_t) 1 << 32) % p * (((uint64_t) 1 << 32) % p) % p;
+}
+
+/*
+ * The transforms of one prime, as a job of the threads: the arrays
+ * x[0..num-1] (the limbs of s, then those of t, if it is not s) are
+ * transformed (decimation in frequency, out in bit reversed order),
+ * multiplied into x[0..2] (the C[d]), transformed back (decimation in
+ * time) and folded into the CRT of the limb products.
+ */
+typedef struct {
+    const qseries_t *s, *t;
+    qseries_t *ans;
+    size_t ord;
+    size_t L;               /* Length of the transforms (2^lg). */
+    int num;                /* 6, or 3 for a square. */
+    int T;
+    int prime;
+    mont_t M;
+    uint32_t w;             /* Root of unity of order L (Montgomery). */
+    uint32_t scale;         /* R^2 / L modulo p. */
+    uint32_t *x[6];
+    uint32_t *rt;           /* [h + j]: w_2h^j, h < L. */
+    uint32_t *rq;           /* [h + j]: w_2h^j 2^32 / p. */
+    uint64_t *acc[3];       /* C[d] modulo the primes so far. */
+    pthread_barrier_t barrier;
+} ntt_job_t;
+
+/* The part [lo, hi) of `n` items of thread `t` of `T`. */
+static inline void thread_range(size_t n, int t, int T, size_t *lo,
+        size_t *hi)
+{
+    *lo = n * t / T;
+    *hi = n * (t + 1) / T;
+}
+
+static inline void ntt_sync(ntt_job_t *job)
+{
+    if (job->T > 1)
+        pthread_barrier_wait(&job->barrier);
+}
+
+/*
+ * The stages of half length 1 and 2 (twiddles 1 and w_4 = rt[3]), on
+ * the butterflies [lo, hi) (whole blocks), forward or inverse: too
+ * short for the loops of the other stages.
+ */
+static inline void short_stage(uint32_t *a, const ntt_job_t *job,
+        size_t h, size_t lo, size_t hi, bool inverse)
+{
+    uint32_t p = job->M.p, w = job->rt[3], wq = job->rq[3];
+
+    if (h == 1) {
+        for (size_t i = 2 * lo; i < 2 * hi; i += 2) {
+            uint32_t x = a[i], y = a[i + 1];
+            a[i] = mod_add(x, y, p);
+            a[i + 1] = mod_sub(x, y, p);
+        }
+        return;
+    }
+    for (size_t i = 2 * lo; i < 2 * hi; i += 4) {
+        uint32_t x = a[i], y = a[i + 2];
+        a[i] = mod_add(x, y, p);
+        a[i + 2] = mod_sub(x, y, p);
+        x = a[i + 1];
+        y = a[i + 3];
+        if (inverse) {
+            /* w_4^-1 = -w_4. */
+            y = shoup_mul(y, w, wq, p);
+            a[i + 1] = mod_sub(x, y, p);
+            a[i + 3] = mod_add(x, y, p);
+        } else {
+            a[i + 1] = mod_add(x, y, p);
+            a[i + 3] = shoup_mul(mod_sub(x, y, p), w, wq, p);
+        }
+    }
+}
+
+/* Butterflies [lo, hi) of the (forward) stage of half length h. */
+static inline void dif_stage(uint32_t *a, const ntt_job_t *job,
+        size_t h, size_t lo, size_t hi)
+{
+    uint32_t p = job->M.p;
+
+    if (h <= 2) {
+        short_stage(a, job, h, lo, hi, false);
+        return;
+    }
+    for (size_t k = lo; k < hi; ) {
+        size_t j = k & (h - 1), end = h - j < hi - k ? h : j + hi - k;
+        uint32_t *u = a + 2 * (k - j), *v = u + h;
+        const uint32_t *w = job->rt + h, *wq = job->rq + h;
+        k += end - j;
+        for (; j < end; j++) {
+            uint32_t x = u[j], y = v[j];
+            u[j] = mod_add(x, y, p);
+            v[j] = shoup_mul(mod_sub(x, y, p), w[j], wq[j], p);
+        }
+    }
+}
+
+/*
+ * Butterflies [lo, hi) of the inverse stage of half length h: with
+ * w_2h^-j = -w_2h^(h-j), the twiddles of the forward stages serve.
+ */
+static inline void dit_stage(uint32_t *a, const ntt_job_t *job,
+        size_t h, size_t lo, size_t hi)
+{
+    uint32_t p = job->M.p;
+
+    if (h <= 2) {
+        short_stage(a, job, h, lo, hi, true);
+        return;
+    }
+    for (size_t k = lo; k < hi; ) {
+        size_t j = k & (h - 1), end = h - j < hi - k ? h : j + hi - k;
+        uint32_t *u = a + 2 * (k - j), *v = u + h;
+        const uint32_t *w = job->rt + 2 * h, *wq = job->rq + 2 * h;
+        k += end - j;
+        if (j == 0) {
+            uint32_t x = u[0], y = v[0];
+            u[0] = mod_add(x, y, p);
+            v[0] = mod_sub(x, y, p);
+            j++;
+        }
+        for (; j < end; j++) {
+            uint32_t x = u[j], y = shoup_mul(v[j], w[-(ptrdiff_t) j],
+                    wq[-(ptrdiff_t) j], p);
+            u[j] = mod_sub(x, y, p);
+            v[j] = mod_add(x, y, p);
+        }
+    }
+}
+
+static void ntt_thread(void *arg, int t)
+{
+    ntt_job_t *job = arg;
+    const mont_t *M = &job->M;
+    size_t L = job->L, ord = job->ord, half = L / 2, lo, hi;
+    size_t block = L < NTT_BLOCK ? L : NTT_BLOCK;
+    uint32_t p = M->p, **x = job->x, *rt = job->rt, *rq = job->rq;
+    int T = job->T;
+
+    /* Twiddles: w^j at half + j, then w_2h^j = w^(j half/h). */
+    thread_range(half, t, T, &lo, &hi);
+    if (lo < hi) {
+        uint32_t w = mont_mul(mod_pow(mont_mul(job->w, 1, M), lo, p),
+                M->r2, M);
+        for (size_t j = lo; j < hi; j++) {
+            rt[half + j] = mont_reduce(w, M);
+            rq[half + j] = ((uint64_t) rt[half + j] << 32) / p;
+            w = mont_mul(w, job->w, M);
+        }
+    }
+    ntt_sync(job);
+    thread_range(half, t, T, &lo, &hi);
+    for (size_t i = lo ? lo : 1; i < hi; i++) {
+        size_t h = (size_t) 1 << (63 - __builtin_clzll(i));
+        rt[i] = rt[half + (i - h) * (half / h)];
+        rq[i] = rq[half + (i - h) * (half / h)];
+    }
+    /* The limbs. */
+    thread_range(L, t, T, &lo, &hi);
+    for (int k = 0; k < job->num; k++) {
+        const int64_t *c = (k < 3 ? job->s : job->t)->c;
+        int shift = (k % 3) * NTT_LIMB;
+        for (size_t i = lo; i < hi; i++)
+            x[k][i] = i < ord ? ((uint64_t) c[i] >> shift) &
+                ((1u << NTT_LIMB) - 1) : 0;
+    }
+    ntt_sync(job);
+
+    /* Forward: the long stages over the threads, then by blocks. */
+    for (size_t h = half; h >= block; h /= 2) {
+        thread_range(half, t, T, &lo, &hi);
+        for (int k = 0; k < job->num; k++)
+            dif_stage(x[k], job, h, lo, hi);
+        ntt_sync(job);
+    }
+    thread_range(L / block, t, T, &lo, &hi);
+    for (int k = 0; k < job->num; k++)
+        for (size_t b = lo; b < hi; b++)
+            for (size_t h = block / 2; h >= 1; h /= 2)
+                dif_stage(x[k] + b * block, job, h, 0, block / 2);
+    ntt_sync(job);
+
+    /* The limb products (/R, made up for by `scale`). */
+    thread_range(L, t, T, &lo, &hi);
+    for (size_t i = lo; i < hi; i++) {
+        uint64_t a0 = x[0][i], a1 = x[1][i], a2 = x[2][i], b0, b1, b2;
+        if (job->num == 3) {
+            b0 = a0;
+            b1 = a1;
+            b2 = a2;
+        } else {
+            b0 = x[3][i];
+            b1 = x[4][i];
+            b2 = x[5][i];
+        }
+        x[0][i] = mont_reduce(a0 * b0, M);
+        x[1][i] = mont_reduce(a0 * b1 + a1 * b0, M);
+        x[2][i] = mont_reduce(a0 * b2 + a1 * b1 + a2 * b0, M);
+    }
+    ntt_sync(job);
+
+    /* Inverse: by blocks, then the long stages over the threads. */
+    thread_range(L / block, t, T, &lo, &hi);
+    for (int k = 0; k < 3; k++)
+        for (size_t b = lo; b < hi; b++)
+            for (size_t h = 1; h < block; h *= 2)
+                dit_stage(x[k] + b * block, job, h, 0, block / 2);
+    ntt_sync(job);
+    for (size_t h = block; h < L; h *= 2) {
+        thread_range(half, t, T, &lo, &hi);
+        for (int k = 0; k < 3; k++)
+            dit_stage(x[k], job, h, lo, hi);
+        ntt_sync(job);
+    }
+
+    /* CRT (Garner): C = r0 + p0 k1 + p0 p1 k2, modulo 2^64. */
+    thread_range(ord, t, T, &lo, &hi);
+    if (job->prime == 0) {
+        for (int d = 0; d < 3; d++)
+            for (size_t i = lo; i < hi; i++)
+                job->acc[d][i] = mont_mul(x[d][i], job->scale, M);
+    } else if (job->prime == 1) {
+        uint64_t p0 = ntt_primes[0].p;
+        /* 1/p0 modulo p1, in Montgomery form. */
+        uint32_t inv = mont_mul(mod_pow(p0, p - 2, p), M->r2, M);
+        for (int d = 0; d < 3; d++)
+            for (size_t i = lo; i < hi; i++) {
+                uint32_t r = mont_mul(x[d][i], job->scale, M);
+                uint64_t a = job->acc[d][i];
+                job->acc[d][i] = a + p0 * mont_mul(mod_sub(r, a, p), inv,
+                        M);
+            }
+    } else {
+        uint64_t p01 = (uint64_t) ntt_primes[0].p * ntt_primes[1].p;
+        uint32_t inv = mont_mul(mod_pow(p01 % p, p - 2, p), M->r2, M);
+        for (size_t i = lo; i < hi; i++) {
+            uint64_t c = 0;
+            for (int d = 0; d < 3; d++) {
+                uint32_t r = mont_mul(x[d][i], job->scale, M);
+                uint64_t a = job->acc[d][i];
+                /* a modulo p: a < p0 p1 < p 2^32. */
+                uint32_t am = mont_mul(mont_reduce(a, M), M->r2, M);
+                c += (a + p01 * mont_mul(mod_sub(r, am, p), inv, M)) <<
+                    (d * NTT_LIMB);
+            }
+            job->ans->c[i] = c;
+        }
+    }
+}
+
+/* `ans` = `s` * `t` by NTT (ord <= NTT_MAX_ORD). */
+static void multiply_ntt(const qseries_t *s, const qseries_t *t,
+        qseries_t *ans)
+{
+    size_t ord = ans->ord, L = 1;
+    int lg = 0, T = ord >= PARALLEL_MIN ? qseries_threads() : 1;
+    ntt_job_t job;
+
+    while (L < 2 * ord - 1) {
+        L *= 2;
+        lg++;
+    }
+    /* At least a block of butterflies per thread and stage. */
+    if ((size_t) T > L / NTT_BLOCK)
+        T = L / NTT_BLOCK > 1 ? L / NTT_BLOCK : 1;
+    memset(&job, 0, sizeof(job));
+    job.s = s;
+    job.t = t;
+    job.ans = ans;
+    job.ord = ord;
+    job.L = L;
+    job.num = s->c == t->c ? 3 : 6;
+    job.T = T;
+    for (int k = 0; k < job.num; k++)
+        job.x[k] = large_alloc(L * sizeof(uint32_t), "multiply_qseries");
+    job.rt = large_alloc(L * sizeof(uint32_t), "multiply_qseries");
+    job.rq = large_alloc(L * sizeof(uint32_t), "multiply_qseries");
+    for (int d = 0; d < 3; d++)
+        job.acc[d] = large_alloc(ord * sizeof(uint64_t),
+                "multiply_qseries");
+    if (T > 1)
+        pthread_barrier_init(&job.barrier, NULL, T);
+    for (int i = 0; i < NTT_PRIMES; i++) {
+        const ntt_prime_t *P = &ntt_primes[i];
+        mont_init(P->p, &job.M);
+        job.prime = i;
+        job.w = mont_mul(mod_pow(P->g, (P->p - 1) >> lg, P->p),
+                job.M.r2, &job.M);
+        job.scale = mont_mul(job.M.r2, mod_pow(L, P->p - 2, P->p),
+                &job.M);
+        job.scale = mont_mul(job.scale, job.M.r2, &job.M);
+        run_parallel(T, ntt_thread, &job, "multiply_qseries");
+    }
+    if (T > 1)
+        pthread_barrier_destroy(&job.barrier);
+    for (int k = 0; k < job.num; k++)
+        free(job.x[k]);
+    free(job.rt);
+    free(job.rq);
+    for (int d = 0; d < 3; d++)
+        free(job.acc[d]);
+}
+
+/*
+ * `ans` = `s` * `t` beyond NTT_MAX_ORD: by blocks of NTT_MAX_ORD / 2
+ * terms, each product of blocks by NTT.
+ */
+static void multiply_ntt_blocks(const qseries_t *s, const qseries_t *t,
+        qseries_t *ans)
+{
+    size_t ord = ans->ord, len = NTT_MAX_ORD / 2, nb = (ord + len - 1) / len;
+    qseries_t a, b, out;
+    uint64_t *acc = large_alloc(ord * sizeof(uint64_t),
+            "multiply_qseries");
+
+    a.ord = b.ord = out.ord = 2 * len - 1;
+    a.c = large_alloc(a.ord * sizeof(int64_t), "multiply_qseries");
+    b.c = large_alloc(b.ord * sizeof(int64_t), "multiply_qseries");
+    out.c = large_alloc(out.ord * sizeof(int64_t), "multiply_qseries");
+    memset(acc, 0, ord * sizeof(uint64_t));
+    for (size_t i = 0; i < nb; i++)
+        for (size_t j = 0; i + j < nb; j++) {
+            size_t off = (i + j) * len;
+            /* Padded to 2 len - 1 terms: the whole product of blocks. */
+            for (size_t x = 0; x < a.ord; x++) {
+                a.c[x] = x < len && i * len + x < ord ? s->c[i * len + x]
+                    : 0;
+                b.c[x] = x < len && j * len + x < ord ? t->c[j * len + x]
+                    : 0;
+            }
+            multiply_ntt(&a, i == j && s->c == t->c ? &a : &b, &out);
+            for (size_t x = 0; x < out.ord && off + x < ord; x++)
+                acc[off + x] += (uint64_t) out.c[x];
+        }
+    memcpy(ans->c, acc, ord * sizeof(int64_t));
+    free(a.c);
+    free(b.c);
+    free(out.c);
+    free(acc);
+}
+
+/* The inverse of `s` (c[0] = +-1) by Newton's iteration, into `ans`. */
+static void invert_newton(const qseries_t *s, qseries_t *ans)
+{
+    qws_t *ws = qws_default();
+    qws_mark_t m = qws_mark(ws);
+    size_t ord = ans->ord, k = NEWTON_MIN;
+    qseries_t g = {k, ans->c}, e, d, err;
+
+    invert_qseries(s, &g);
+    scratch_series(ws, ord, &e, "invert_qseries");
+    scratch_series(ws, ord, &err, "invert_qseries");
+    /* g <- g - g (s g - 1), doubling the precision k of g. */
+    for (; k < ord; k = g.ord) {
+        g.ord = 2 * k < ord ? 2 * k : ord;
+        memset(g.c + k, 0, (g.ord - k) * sizeof(int64_t));
+        e.ord = g.ord;
+        multiply_qseries(s, &g, &e);
+        d = (qseries_t) {g.ord - k, e.c + k};
+        err.ord = g.ord - k;
+        multiply_qseries(&(qseries_t) {g.ord - k, g.c}, &d, &err);
+        for (size_t i = 0; i < err.ord; i++)
+            g.c[k + i] = -(uint64_t) err.c[i];
+    }
+    qws_release(ws, m);
+}
+
+/*******************************************************************\
+ * Basic Operations                                                *
+ *******************************************************************/
+
+void shift_qseries(const qseries_t *s, int shift, qseries_t *ans)
+{
+    for (size_t deg = 0; deg < ans->ord; deg++)
+        ans->c[deg] = ((int) deg < shift) ? 0: s->c[deg - shift];
+}
+
+void scale_qseries(int64_t c, const qseries_t *s, qseries_t *ans)
+{
+    for (size_t deg = 0; deg < ans->ord; deg++)
+        ans->c[deg] = c * s->c[deg];
+}
+
+void add_qseries(const qseries_t *s, const qseries_t *t, qseries_t *ans)
+{
+    for (size_t deg = 0; deg < ans->ord; deg++)
+        ans->c[deg] = s->c[deg] + t->c[deg];
+}
+
+void subtract_qseries(const qseries_t *s, const qseries_t *t,
+        qseries_t *ans)
+{
+    for (size_t deg = 0; deg < ans->ord; deg++)
+        ans->c[deg] = s->c[deg] - t->c[deg];
+}
+
+/*
+ * x / c0 for the long divisions (x as summed, modulo 2^64): exact
+ * modulo 2^64 for c0 = +-1.
+ */
+static inline int64_t div_c0(uint64_t x, int64_t c0)
+{
+    if (c0 == 1 || c0 == -1)
+        return x * (uint64_t) c0;
+    return (int64_t) x / c0;
+}
+
+void multiply_qseries(const qseries_t *s, const qseries_t *t,
+        qseries_t *ans)
+{
+    uint64_t sum;
+    size_t i;
+
+    if (ans->ord >= NTT_MIN) {
+        if (ans->ord <= NTT_MAX_ORD)
+            multiply_ntt(s, t, ans);
+        else
+            multiply_ntt_blocks(s, t, ans);
+        return;
+    }
+    if (ans->ord >= KARATSUBA_MIN) {
+        multiply_karatsuba(s, t, ans);
+        return;
+    }
+    /* Downwards: ans[deg] needs only s, t up to deg (`ans` may be both). */
+    for (size_t deg = ans->ord; deg-- > 0; ) {
+        for(i = 0, sum = 0; i <= deg; i++)
+            sum += (uint64_t) s->c[i] * t->c[deg - i];
+        ans->c[deg] = sum;
+    }
+}
+
+void multiply_inplace_qseries(qseries_t *s, const qseries_t *t)
+{
+    multiply_qseries(s, t, s);
+}
+
+void invert_qseries(const qseries_t *s, qseries_t *ans)
+{
+    qws_t *ws = qws_default();
+    qws_mark_t m = qws_mark(ws);
+    qseries_t s0;
+    uint64_t sum;
+    size_t i;
+
+    if (s == ans) {
+        scratch_series(ws, ans->ord, &s0, "invert_qseries");
+        cp_qseries(s, &s0);
+        s = &s0;
+    }
+    if (ans->ord > NEWTON_MIN && (s->c[0] == 1 || s->c[0] == -1)) {
+        invert_newton(s, ans);
+        qws_release(ws, m);
+        return;
+    }
+    ans->c[0] = 1/s->c[0];
+    for (size_t deg = 1; deg < ans->ord; deg++) {
+        for (i = 1, sum = 0; i <= deg; i++)
+            sum += (uint64_t) s->c[i] * ans->c[deg - i];
+        ans->c[deg] = div_c0(-sum, s->c[0]);
+    }
+    qws_release(ws, m);
+}
+
+void divide_inplace_qseries(qseries_t *s, const qseries_t *t)
+{
+    int64_t c0 = t->c[0];
+    uint64_t sum;
+    size_t i;
+
+    if (s == t) {
+        init_qseries(s, 0);
+        s->c[0] = 1;
+        return;
+    }
+    if (s->ord >= DIVIDE_MIN && (c0 == 1 || c0 == -1)) {
+        divide_qseries(s, t, s);
+        return;
+    }
+    /* Upwards: s[deg] is read before it is overwritten. */
+    for (size_t deg = 0; deg < s->ord; deg++) {
+        for (i = 1, sum = s->c[deg]; i <= deg; i++)
+            sum -= (uint64_t) t->c[i] * s->c[deg - i];
+        s->c[deg] = div_c0(sum, c0);
+    }
+}
+
+void divide_qseries(const qseries_t *s, const qseries_t *t,
+        qseries_t *ans)
+{
+    qws_t *ws;
+    qws_mark_t m;
+    qseries_t tmp;
+
+    if ((t->c[0] == 1 || t->c[0] == -1) && t != ans &&
+            ans->ord < DIVIDE_MIN) {
+        /* Long division, with no scratch series. */
+        if (s != ans)
+            cp_qseries(s, ans);
+        divide_inplace_qseries(ans, t);
+        return;
+    }
+    ws = qws_default();
+    m = qws_mark(ws);
+    scratch_series(ws, ans->ord, &tmp, "divide_qseries");
+    invert_qseries(t, &tmp);
+    multiply_qseries(s, &tmp, ans);
+    qws_release(ws, m);
+}
+
+void multiply_factor_inplace_qseries(qseries_t *s, int64_t a, size_t n,
+        int k)
+{
+    for (; k > 0; k--)
+        for (size_t deg = s->ord; deg-- > n; )
+            s->c[deg] -= a * s->c[deg - n];
+    for (; k < 0; k++)
+        for (size_t deg = n; deg < s->ord; deg++)
+            s->c[deg] += a * s->c[deg - n];
+}
+
+/*
+ * J.C.P. Miller's recurrence for b = s^(p/q), s->c[0] = `c0` = +-1:
+ * from q s b' = (p/q) s' b (in the coefficients),
+ *      b[n] = 1/(n q) sum over k = 1..n: ((p + q) k - n q) s[k] b[n-k],
+ * with b[0] = 1 (c0 = -1 only for integer exponents, see below).
+ * Only the nonzero s[k] are visited, so this takes O(ord nnz(s)).
+ * Returns -1 if some b[n] is not an integer or does not fit in 64
+ * bits (then the exact result is not what binary powering gives
+ * modulo 2^64), else 0.
+ */
+static int miller_pow(const qseries_t *s, int64_t p, int64_t q,
+        qseries_t *ans)
+{
+    qws_t *ws = qws_default();
+    qws_mark_t m = qws_mark(ws);
+    int64_t c0 = s->c[0], *sk;
+    size_t *k, num = 0;
+    int err = 0;
+
+    /* The nonzero terms of s / c0 (a copy: `ans` may be `s`). */
+    k = qws_alloc(ws, ans->ord * sizeof(size_t));
+    sk = qws_alloc(ws, ans->ord * sizeof(int64_t));
+    if (k == NULL || sk == NULL) {
+        fprintf(stderr, "[ERR] pow_qseries: out of memory!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 1; i < ans->ord; i++)
+        if (s->c[i]) {
+            k[num] = i;
+            sk[num++] = c0 * s->c[i];
+        }
+    ans->c[0] = 1;
+    for (size_t n = 1; n < ans->ord && ! err; n++) {
+        __int128 sum = 0, t, nq = (__int128) n * q;
+        for (size_t i = 0; i < num && k[i] <= n; i++) {
+            __int128 w = (__int128) (p + q) * k[i] - nq;
+            err |= __builtin_mul_overflow(w, sk[i], &t);
+            err |= __builtin_mul_overflow(t, ans->c[n - k[i]], &t);
+            err |= __builtin_add_overflow(sum, t, &sum);
+        }
+        if (sum % nq || sum / nq > INT64_MAX || sum / nq < INT64_MIN)
+            err = 1;
+        ans->c[n] = sum / nq;
+    }
+    qws_release(ws, m);
+    if (err)
+        return -1;
+    /* s^n = c0^n (s / c0)^n. */
+    if (c0 == -1 && q == 1 && (p & 1))
+        scale_qseries(-1, ans, ans);
+    return 0;
+}
+
+/* Compute q-series `s`, raised to the power `n`, result in `ans`. */
+void pow_qseries(const qseries_t *s, int n, qseries_t *ans)
+{
+    qws_t *ws = qws_default();
+    qws_mark_t m = qws_mark(ws);
+    qseries_t s0;
+    unsigned abs_n = n < 0 ? -(unsigned) n : (unsigned) n;
+    size_t nnz = 0, mults;
+
+    if (n == 0) {
+        init_qseries(ans, 0);
+        ans->c[0] = 1;
+        return;
+    }
+    scratch_series(ws, ans->ord, &s0, "pow_qseries");
+    /*
+     * Miller's recurrence is exact and takes O(ord nnz(s)) whatever n
+     * is (if it does not overflow), but its steps cost several
+     * steps of a product: use it unless s is dense and n small.
+     */
+    cp_qseries(s, &s0);
+    for (size_t i = 1; i < ans->ord; i++)
+        nnz += (s0.c[i] != 0);
+    mults = (n < 0) + __builtin_popcount(abs_n) - 1;
+    for (unsigned a = abs_n; a > 1; a >>= 1)
+        mults++;
+    if ((s0.c[0] == 1 || s0.c[0] == -1) &&
+            4.0 * ans->ord * nnz <= mults * product_cost(ans->ord) &&
+            miller_pow(&s0, n, 1, ans) == 0)
+        goto done;
+
+    /* Else binary powering, O(ord^2 log n) (modulo 2^64), in place. */
+    if (n < 0)
+        invert_qseries(&s0, &s0);
+    init_qseries(ans, 0);
+    ans->c[0] = 1;
+    for (; abs_n; abs_n >>= 1) {
+        if (abs_n & 1)
+            multiply_inplace_qseries(ans, &s0);
+        if (abs_n > 1)
+            multiply_inplace_qseries(&s0, &s0);
+    }
+done:
+    qws_release(ws, m);
+}
+
+int powq_qseries(const qseries_t *s, int p, int q, qseries_t *ans)
+{
+    if (q <= 0 || s->c[0] != 1)
+        return -1;
+    return miller_pow(s, p, q, ans);
+}
+
+/*******************************************************************\
+ * Sparse Series and Products                                      *
+ *******************************************************************/
+
+void free_sparse_qseries(sparse_qseries_t *s)
+{
+    free(s->deg);
+    free(s->c);
+    s->deg = NULL;
+    s->c = NULL;
+    s->num = 0;
+}
+
+/* Add the term `c` q^`deg` to `s` (if below its order). */
+static inline int push_term(sparse_qseries_t *s, long long deg, int64_t c,
+        size_t *cap)
+{
+    if (deg < 0 || (size_t) deg >= s->ord || c == 0)
+        return 0;
+    if (s->num == *cap) {
+        size_t *d;
+        int64_t *v;
+        *cap = *cap ? 2 * *cap : 16;
+        if ((d = realloc(s->deg, *cap * sizeof(size_t))) == NULL)
+            return -1;
+        s->deg = d;
+        if ((v = realloc(s->c, *cap * sizeof(int64_t))) == NULL)
+            return -1;
+        s->c = v;
+    }
+    s->deg[s->num] = deg;
+    s->c[s->num++] = c;
+    return 0;
+}
+
+/* Sort the terms of `s` by degree and merge those of equal degree. */
+static void sort_terms(sparse_qseries_t *s)
+{
+    size_t k = 0;
+
+    /* Insertion sort: there are O(sqrt(ord)) terms, nearly sorted. */
+    for (size_t i = 1; i < s->num; i++) {
+        size_t d = s->deg[i], j = i;
+        int64_t c = s->c[i];
+        for (; j > 0 && s->deg[j-1] > d; j--) {
+            s->deg[j] = s->deg[j-1];
+            s->c[j] = s->c[j-1];
+        }
+        s->deg[j] = d;
+        s->c[j] = c;
+    }
+    for (size_t i = 0; i < s->num; i++) {
+        if (k > 0 && s->deg[k-1] == s->deg[i])
+            s->c[k-1] += s->c[i];
+        else {
+            s->deg[k] = s->deg[i];
+            s->c[k++] = s->c[i];
+        }
+        if (s->c[k-1] == 0)
+            k--;
+    }
+    s->num = k;
+}
+
+/*
+ * Build the sparse series  sum over k in Z of  sgn(k) q^(A k^2 + B k)
+ * (halved: A k^2 + B k is computed as (2A k^2 + 2B k) / 2), with
+ * sgn(k) = (-1)^k, for the quadratic exponents of the products below.
+ */
+static int quadratic_sparse(long long A2, long long B2, size_t ord,
+        sparse_qseries_t *s)
+{
+    size_t cap = 0;
+
+    s->ord = ord;
+    s->num = 0;
+    s->deg = NULL;
+    s->c = NULL;
+    for (long long k = 0; ; k++) {
+        long long e1 = (A2 * k * k + B2 * k) / 2;
+        long long e2 = (A2 * k * k - B2 * k) / 2;
+        int64_t sgn = (k & 1) ? -1 : 1;
+        if (e1 >= (long long) ord && e2 >= (long long) ord)
+            break;
+        if (push_term(s, e1, sgn, &cap) ||
+                (k && push_term(s, e2, sgn, &cap))) {
+            free_sparse_qseries(s);
+            return -1;
+        }
+    }
+    sort_terms(s);
+    return 0;
+}
+
+int euler_sparse(int m, size_t ord, sparse_qseries_t *s)
+{
+    /* Euler: sum (-1)^k q^(m k (3k - 1) / 2). */
+    return quadratic_sparse(3LL * m, -1LL * m, ord, s);
+}
+
+int theta_sparse(int a, int m, size_t ord, sparse_qseries_t *s)
+{
+    /* Jacobi: sum (-1)^k q^(m k (k - 1) / 2 + a k). */
+    return quadratic_sparse(m, 2LL * a - m, ord, s);
+}
+
+int quintuple_sparse(int a, int m, size_t ord, sparse_qseries_t *s)
+{
+    size_t cap = 0;
+
+    /*
+     * Quintuple product: sum over k in Z of
+     *   q^(m k (3k + 1) / 2) (q^(-3ak) - q^(3ak + a)).
+     */
+    s->ord = ord;
+    s->num = 0;
+    s->deg = NULL;
+    s->c = NULL;
+    for (long long k = 0; ; k++) {
+        bool below = false;
+        for (int sg = 1; sg >= -1; sg -= 2) {
+            long long j = sg * k;
+            long long e = m * j * (3 * j + 1) / 2;
+            if (sg < 0 && k == 0)
+                break;
+            below |= e - 3 * a * j < (long long) ord ||
+                e + 3 * a * j + a < (long long) ord;
+            if (push_term(s, e - 3 * a * j, 1, &cap) ||
+                    push_term(s, e + 3 * a * j + a, -1, &cap)) {
+                free_sparse_qseries(s);
+                return -1;
+            }
+        }
+        if (! below)
+            break;
+    }
+    sort_terms(s);
+    return 0;
+}
+
+void multiply_sparse_qseries(const sparse_qseries_t *s,
+        const qseries_t *t, qseries_t *ans)
+{
+    /* Downwards, so that `ans` may be `t`. */
+    for (size_t deg = ans->ord; deg-- > 0; ) {
+        int64_t sum = 0;
+        for (size_t i = 0; i < s->num && s->deg[i] <= deg; i++)
+            sum += s->c[i] * t->c[deg - s->deg[i]];
+        ans->c[deg] = sum;
+    }
+}
+
+void divide_sparse_qseries(const qseries_t *t, const sparse_qseries_t *s,
+        qseries_t *ans)
+{
+    int64_t c0 = s->c[0];
+
+    /* Upwards, so that `ans` may be `t` (s->deg[0] must be 0). */
+    for (size_t deg = 0; deg < ans->ord; deg++) {
+        int64_t sum = t->c[deg];
+        for (size_t i = 1; i < s->num && s->deg[i] <= deg; i++)
+            sum -= s->c[i] * ans->c[deg - s->deg[i]];
+        ans->c[deg] = sum / c0;
+    }
+}
+
+/* Multiply `ans` by the sparse `s` raised to `k` (in place). */
+static void apply_sparse(const sparse_qseries_t *s, int k, qseries_t *ans)
+{
+    for (; k > 0; k--)
+        multiply_sparse_qseries(s, ans, ans);
+    for (; k < 0; k++)
+        divide_sparse_qseries(ans, s, ans);
+}
+
+void qpochhammer_qseries(int64_t a, int k, int m, qseries_t *ans)
+{
+    init_qseries(ans, 0);
+    ans->c[0] = 1;
+    if (k == 0) {
+        /* The factor 1 - a (a constant). */
+        scale_qseries(1 - a, ans, ans);
+        k = m;
+    }
+    if (a == 1 && k == m) {
+        sparse_qseries_t e;
+        if (euler_sparse(m, ans->ord, &e) == 0) {
+            multiply_sparse_qseries(&e, ans, ans);
+            free_sparse_qseries(&e);
+            return;
+        }
+    }
+    for (size_t n = k; n < ans->ord; n += m)
+        multiply_factor_inplace_qseries(ans, a, n, 1);
+}
+
+void eta_quotient(size_t num, const int delta[num], const int r[num],
+        qseries_t *ans)
+{
+    sparse_qseries_t e;
+
+    init_qseries(ans, 0);
+    ans->c[0] = 1;
+    for (size_t i = 0; i < num; i++) {
+        if (euler_sparse(delta[i], ans->ord, &e)) {
+            fprintf(stderr, "[ERR] eta_quotient: out of memory!\n");
+            exit(EXIT_FAILURE);
+        }
+        apply_sparse(&e, r[i], ans);
+        free_sparse_qseries(&e);
+    }
+}
+
+/*******************************************************************\
+ * Batched Series                                                  *
+ *******************************************************************/
+
+int alloc_qbatch(size_t num, size_t ord, qbatch_t *s)
+{
+    size_t len = (ord ? ord : 1) * (num ? num : 1) * sizeof(int64_t);
+
+    s->ord = ord;
+    s->num = num;
+    /* Rows aligned to cache lines, for the vector loops. */
+    s->c = aligned_alloc(QWS_ALIGN, (len + QWS_ALIGN - 1) / QWS_ALIGN *
+            QWS_ALIGN);
+    if (s->c == NULL)
+        return -1;
+    memset(s->c, 0, len);
+    return 0;
+}
+
+void free_qbatch(qbatch_t *s)
+{
+    free(s->c);
+    s->c = NULL;
+    s->ord = 0;
+    s->num = 0;
+}
+
+void set_qbatch(qbatch_t *s, size_t b, const qseries_t *t)
+{
+    for (size_t deg = 0; deg < s->ord; deg++)
+        s->c[deg * s->num + b] = t->c[deg];
+}
+
+void get_qbatch(const qbatch_t *s, size_t b, qseries_t *t)
+{
+    for (size_t deg = 0; deg < t->ord; deg++)
+        t->c[deg] = s->c[deg * s->num + b];
+}
+
+void add_qbatch(const qbatch_t *s, const qbatch_t *t, qbatch_t *ans)
+{
+    size_t len = ans->ord * ans->num;
+
+    for (size_t i = 0; i < len; i++)
+        ans->c[i] = s->c[i] + t->c[i];
+}
+
+void scale_qbatch(int64_t c, const qbatch_t *s, qbatch_t *ans)
+{
+    size_t len = ans->ord * ans->num;
+
+    for (size_t i = 0; i < len; i++)
+        ans->c[i] = c * s->c[i];
+}
+
+/* row[b] += c * src[b], b < num (c = +-1 without multiplications). */
+static inline void axpy_row(int64_t c, const int64_t *src, int64_t *row,
+        size_t num)
+{
+    if (c == 1)
+        for (size_t b = 0; b < num; b++)
+            row[b] += src[b];
+    else if (c == -1)
+        for (size_t b = 0; b < num; b++)
+            row[b] -= src[b];
+    else
+        for (size_t b = 0; b < num; b++)
+            row[b] += c * src[b];
+}
+
+void multiply_sparse_qbatch(const sparse_qseries_t *s, const qbatch_t *t,
+        qbatch_t *ans)
+{
+    size_t B = ans->num;
+
+    /* Downwards, so that `ans` may be `t`: row deg needs rows <= deg. */
+    for (size_t deg = ans->ord; deg-- > 0; ) {
+        int64_t *row = ans->c + deg * B;
+        size_t i = 0;
+        if (s->num && s->deg[0] == 0) {
+            const int64_t *src = t->c + deg * B;
+            for (size_t b = 0; b < B; b++)
+                row[b] = s->c[0] * src[b];
+            i = 1;
+        } else {
+            memset(row, 0, B * sizeof(int64_t));
+        }
+        for (; i < s->num && s->deg[i] <= deg; i++)
+            axpy_row(s->c[i], t->c + (deg - s->deg[i]) * B, row, B);
+    }
+}
+
+void divide_sparse_qbatch(const qbatch_t *t, const sparse_qseries_t *s,
+        qbatch_t *ans)
+{
+    size_t B = ans->num;
+    int64_t c0 = s->c[0];
+
+    /* Upwards, so that `ans` may be `t` (s->deg[0] must be 0). */
+    for (size_t deg = 0; deg < ans->ord; deg++) {
+        int64_t *row = ans->c + deg * B;
+        if (row != t->c + deg * B)
+            memcpy(row, t->c + deg * B, B * sizeof(int64_t));
+        for (size_t i = 1; i < s->num && s->deg[i] <= deg; i++)
+            axpy_row(-s->c[i], ans->c + (deg - s->deg[i]) * B, row, B);
+        if (c0 == -1)
+            for (size_t b = 0; b < B; b++)
+                row[b] = -row[b];
+    }
+}
+
+void multiply_factors_qbatch(qbatch_t *s, size_t n, const int k[])
+{
+    qws_t *ws = qws_default();
+    qws_mark_t m = qws_mark(ws);
+    size_t B = s->num;
+    int64_t *mask;
+    int kmin = 0, kmax = 0;
+
+    for (size_t b = 0; b < B; b++) {
+        kmin = MIN(kmin, k[b]);
+        kmax = MAX(kmax, k[b]);
+    }
+    if ((kmin == 0 && kmax == 0) || n >= s->ord)
+        return;
+    if ((mask = qws_alloc(ws, B * sizeof(int64_t))) == NULL) {
+        fprintf(stderr, "[ERR] multiply_factors_qbatch: out of memory!\n");
+        exit(EXIT_FAILURE);
+    }
+    /*
+     * One factor at a time, masked (all ones or zero) per series, so
+     * that the inner loops have no branches.
+     */
+    for (int j = 1; j <= kmax; j++) {
+        for (size_t b = 0; b < B; b++)
+            mask[b] = -(int64_t) (k[b] >= j);
+        for (size_t deg = s->ord; deg-- > n; ) {
+            int64_t *row = s->c + deg * B;
+            const int64_t *src = row - n * B;
+            for (size_t b = 0; b < B; b++)
+                row[b] -= mask[b] & src[b];
+        }
+    }
+    for (int j = -1; j >= kmin; j--) {
+        for (size_t b = 0; b < B; b++)
+            mask[b] = -(int64_t) (k[b] <= j);
+        for (size_t deg = n; deg < s->ord; deg++) {
+            int64_t *row = s->c + deg * B;
+            const int64_t *src = row - n * B;
+            for (size_t b = 0; b < B; b++)
+                row[b] += mask[b] & src[b];
+        }
+    }
+    qws_release(ws, m);
+}
+
+void product_side_qbatch(int mod, const int cong[], qbatch_t *ans)
+{
+    qws_t *ws = qws_default();
+    qws_mark_t m = qws_mark(ws);
+    size_t B = ans->num;
+    int *k;
+
+    if ((k = qws_alloc(ws, B * sizeof(int))) == NULL) {
+        fprintf(stderr, "[ERR] product_side_qbatch: out of memory!\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(ans->c, 0, ans->ord * B * sizeof(int64_t));
+    for (size_t b = 0; b < B; b++)
+        ans->c[b] = 1;
+    for (size_t n = 1; n < ans->ord; n++) {
+        for (size_t b = 0; b < B; b++)
+            k[b] = cong[b * mod + n % mod];
+        multiply_factors_qbatch(ans, n, k);
+    }
+    qws_release(ws, m);
+}
+
+size_t compare_qbatch(const qbatch_t *s, const qseries_t *t,
+        size_t first[])
+{
+    qws_t *ws = qws_default();
+    qws_mark_t m = qws_mark(ws);
+    size_t B = s->num, alive = B;
+    uint64_t *live;
+
+    if ((live = qws_alloc(ws, B * sizeof(uint64_t))) == NULL) {
+        fprintf(stderr, "[ERR] compare_qbatch: out of memory!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t b = 0; b < B; b++) {
+        first[b] = s->ord;
+        live[b] = ~0ULL;
+    }
+    for (size_t deg = 0; deg < s->ord && alive; deg++) {
+        const int64_t *row = s->c + deg * B;
+        if (4 * alive < B) {
+            /* Few left: finish them one by one. */
+            for (size_t b = 0; b < B; b++) {
+                for (size_t d = deg; live[b] && d < s->ord; d++) {
+                    if (s->c[d * B + b] != t->c[d]) {
+                        first[b] = d;
+                        live[b] = 0;
+                        alive--;
+                    }
+                }
+            }
+            break;
+        }
+        uint64_t v = t->c[deg], any = 0;
+        /* Bitwise only (vectorized), for the rows that all agree. */
+        for (size_t b = 0; b < B; b++)
+            any |= live[b] & ((uint64_t) row[b] ^ v);
+        if (! any)
+            continue;
+        for (size_t b = 0; b < B; b++) {
+            if (live[b] && (uint64_t) row[b] != v) {
+                first[b] = deg;
+                live[b] = 0;
+                alive--;
+            }
+        }
+    }
+    qws_release(ws, m);
+    return alive;
+}
+
+/*******************************************************************\
+ * Product Side Sweeps                                             *
+ *******************************************************************/
+
+void qsweep_init(qsweep_t *sw, int mod, size_t ord)
+{
+    memset(sw, 0, sizeof(*sw));
+    sw->mod = mod;
+    sw->ord = ord;
+    for (int r = 0; r < mod && r < QSWEEP_MAX_MOD; r++) {
+        sw->lo[r] = -1;
+        sw->hi[r] = 1;
+    }
+    sw->threads = 1;
+}
+
+uint64_t qsweep_count(const qsweep_t *sw)
+{
+    uint64_t num = 1;
+
+    for (int r = 0; r < sw->mod; r++)
+        num *= sw->hi[r] - sw->lo[r] + 1;
+    return num;
+}
+
+void qsweep_pattern(const qsweep_t *sw, uint64_t i, int cong[])
+{
+    /*
+     * Digit r of i (mixed radix, r = 0 the lowest), reflected when
+     * the digits above it make an odd number.
+     */
+    for (int r = 0; r < sw->mod; r++) {
+        uint64_t radix = sw->hi[r] - sw->lo[r] + 1, a = i % radix;
+        i /= radix;
+        cong[r] = sw->lo[r] + ((i & 1) ? radix - 1 - a : a);
+    }
+}
+
+/* A range [first, last) of the Gray code, for one thread. */
+typedef struct {
+    const qsweep_t *sw;
+    int thread;
+    uint64_t first, last;
+    int err;
+} sweep_range_t;
+
+static void *sweep_thread(void *arg)
+{
+    sweep_range_t *job = arg;
+    const qsweep_t *sw = job->sw;
+    int mod = sw->mod, cong[mod], next[mod];
+    qseries_t s;
+
+    if (alloc_qseries(&s, sw->ord)) {
+        job->err = -1;
+        return NULL;
+    }
+    qsweep_pattern(sw, job->first, cong);
+    product_side(mod, cong, &s);
+    for (uint64_t i = job->first; ; i++) {
+        sw->visit(cong, &s, job->thread, sw->arg);
+        if (i + 1 == job->last)
+            break;
+        qsweep_pattern(sw, i + 1, next);
+        for (int r = 0; r < mod; r++) {
+            int d = next[r] - cong[r];
+            if (d == 0)
+                continue;
+            for (size_t n = r ? r : mod; n < s.ord; n += mod)
+                multiply_factor_inplace_qseries(&s, 1, n, d);
+            cong[r] = next[r];
+        }
+    }
+    free_qseries(&s);
+    return NULL;
+}
+
+int qsweep_run(const qsweep_t *sw)
+{
+    uint64_t num;
+    int T = sw->threads, err = 0, started;
+
+    if (sw->mod < 1 || sw->mod > QSWEEP_MAX_MOD || sw->ord < 1)
+        return -1;
+    for (int r = 0; r < sw->mod; r++)
+        if (sw->lo[r] > sw->hi[r])
+            return -1;
+    num = qsweep_count(sw);
+    if (T < 1)
+        T = 1;
+    if ((uint64_t) T > num)
+        T = num;
+
+    pthread_t thread[T];
+    sweep_range_t job[T];
+
+    for (int t = 0; t < T; t++)
+        job[t] = (sweep_range_t) {sw, t, num * t / T, num * (t + 1) / T, 0};
+    if (T == 1) {
+        sweep_thread(&job[0]);
+        return job[0].err;
+    }
+    for (started = 0; started < T; started++)
+        if (pthread_create(&thread[started], NULL, sweep_thread,
+                    &job[started]))
+            break;
+    for (int t = 0; t < started; t++) {
+        pthread_join(thread[t], NULL);
+        err |= job[t].err;
+    }
+    return (started < T || err) ? -1 : 0;
+}
+
+/*******************************************************************\
+ * q-Hypergeometric Sums                                           *
+ *******************************************************************/
+
+int qhyper_sum(const qhyper_t *h, qseries_t *ans)
+{
+    qws_t *ws;
+    qws_mark_t m;
+    qseries_t term;
+    int64_t cn = 1;
+    int err = 0;
+
+    if (h->num_num > QHYPER_MAX || h->num_den > QHYPER_MAX)
+        return -1;
+    for (size_t j = 0; j < h->num_den; j++)
+        if (h->den[j].k <= 0 || h->den[j].m < 0)
+            return -1;
+    ws = qws_default();
+    m = qws_mark(ws);
+    scratch_series(ws, ans->ord, &term, "qhyper_sum");
+    /*
+     * term = prod num[i]_n / prod den[j]_n, updated from n to n + 1
+     * by one factor (1 - a q^(k + n m)) each, in O(ord); the term of
+     * the sum is c^n q^Q(n) term (its lowest degree is Q(n)).
+     */
+    term.c[0] = 1;
+    init_qseries(ans, 0);
+    for (long long n = 0; ; n++) {
+        long long Q2 = (long long) h->a2 * n * n + (long long) h->a1 * n;
+        bool rising = 2LL * h->a2 * n + h->a2 + h->a1 > 0;
+        if (Q2 < 0 || Q2 % 2) {
+            err = -1;
+            break;
+        }
+        if ((size_t) (Q2 / 2) >= ans->ord) {
+            /* No more terms below the order once Q rises. */
+            if (rising && h->a2 >= 0)
+                break;
+        } else {
+            for (size_t deg = Q2 / 2, i = 0; deg < ans->ord; deg++, i++)
+                ans->c[deg] += cn * term.c[i];
+        }
+        if (! rising && h->a2 <= 0) {
+            /* Q(n) never rises: no q-adic convergence. */
+            err = -1;
+            break;
+        }
+        cn *= h->c;
+        for (size_t i = 0; i < h->num_num; i++) {
+            long long e = h->num[i].k + n * h->num[i].m;
+            if (e >= 0 && (size_t) e < ans->ord)
+                multiply_factor_inplace_qseries(&term, h->num[i].a, e, 1);
+        }
+        for (size_t j = 0; j < h->num_den; j++) {
+            long long e = h->den[j].k + n * h->den[j].m;
+            if ((size_t) e < ans->ord)
+                multiply_factor_inplace_qseries(&term, h->den[j].a, e, -1);
+        }
+        if (cn == 0)
+            break;
+    }
+    qws_release(ws, m);
+    return err;
+}
+
+/*******************************************************************\
+ * Lazy Series                                                     *
+ *******************************************************************/
+
+void free_lazy_qseries(lazy_qseries_t *s)
+{
+    free(s->c);
+    free(s->nz);
+    if (s->free_data)
+        s->free_data(s->data);
+    memset(s, 0, sizeof(*s));
+}
+
+/* Set up `s` with no coefficients known yet. */
+static inline void lazy_init(lazy_qseries_t *s, lazy_coef_f *coef,
+        void *data, void (*free_data)(void *))
+{
+    memset(s, 0, sizeof(*s));
+    s->coef = coef;
+    s->data = data;
+    s->free_data = free_data;
+}
+
+int64_t lazy_coef(lazy_qseries_t *s, size_t n)
+{
+    int64_t *c_new;
+    size_t *nz_new;
+
+    while (s->num <= n && ! s->err) {
+        int64_t c = s->coef(s, s->num);
+        if (s->err)
+            break;
+        if (s->num == s->cap) {
+            size_t cap = s->cap ? 2 * s->cap : 64;
+            if ((c_new = realloc(s->c, cap * sizeof(int64_t))) == NULL) {
+                s->err = ENOMEM;
+                break;
+            }
+            s->c = c_new;
+            if ((nz_new = realloc(s->nz, cap * sizeof(size_t))) == NULL) {
+                s->err = ENOMEM;
+                break;
+            }
+            s->nz = nz_new;
+            s->cap = cap;
+        }
+        if (c)
+            s->nz[s->num_nz++] = s->num;
+        s->c[s->num++] = c;
+    }
+    return (n < s->num) ? s->c[n] : 0;
+}
+
+/*
+ * Take the error of an operand of `s` that stopped before degree `n`
+ * (read up to it), if any; returns it.
+ */
+static inline int lazy_operand_err(lazy_qseries_t *s, size_t n)
+{
+    if (n >= s->a->num)
+        s->err = s->a->err;
+    else if (n >= s->b->num)
+        s->err = s->b->err;
+    return s->err;
+}
+
+size_t lazy_first_difference(lazy_qseries_t *s, lazy_qseries_t *t,
+        size_t ord)
+{
+    for (size_t n = 0; n < ord; n++)
+        if (lazy_coef(s, n) != lazy_coef(t, n) || n >= s->num ||
+                n >= t->num)
+            return n;
+    return ord;
+}
+
+static int64_t dense_coef(lazy_qseries_t *s, size_t n)
+{
+    const qseries_t *t = s->data;
+
+    if (n >= t->ord) {
+        s->err = EDOM;
+        return 0;
+    }
+    return t->c[n];
+}
+
+void lazy_from_qseries(lazy_qseries_t *s, const qseries_t *t)
+{
+    lazy_init(s, dense_coef, (void *) t, NULL);
+}
+
+static int64_t sparse_coef(lazy_qseries_t *s, size_t n)
+{
+    const sparse_qseries_t *t = s->data;
+
+    if (n >= t->ord) {
+        s->err = EDOM;
+        return 0;
+    }
+    /* The terms are read in order: s->num_nz of them are behind. */
+    if (s->num_nz < t->num && t->deg[s->num_nz] == n)
+        return t->c[s->num_nz];
+    return 0;
+}
+
+void lazy_from_sparse(lazy_qseries_t *s, const sparse_qseries_t *t)
+{
+    lazy_init(s, sparse_coef, (void *) t, NULL);
+}
+
+/* A function and its argument (data of `func_coef`). */
+typedef struct {
+    int64_t (*func)(size_t n, void *arg);
+    void *arg;
+} lazy_func_t;
+
+static int64_t func_coef(lazy_qseries_t *s, size_t n)
+{
+    lazy_func_t *f = s->data;
+
+    return f->func(n, f->arg);
+}
+
+void lazy_from_func(lazy_qseries_t *s, int64_t (*func)(size_t n, void *arg),
+        void *arg)
+{
+    lazy_func_t *f;
+
+    if ((f = malloc(sizeof(lazy_func_t))) == NULL) {
+        lazy_init(s, func_coef, NULL, NULL);
+        s->err = ENOMEM;
+        return;
+    }
+    f->func = func;
+    f->arg = arg;
+    lazy_init(s, func_coef, f, free);
+}
+
+static int64_t multiply_coef(lazy_qseries_t *s, size_t n)
+{
+    lazy_qseries_t *a = s->a, *b = s->b, *t;
+    int64_t sum = 0;
+
+    lazy_coef(a, n);
+    lazy_coef(b, n);
+    if (lazy_operand_err(s, n))
+        return 0;
+    /* Run over the nonzero terms of the sparser operand. */
+    if (b->num_nz < a->num_nz) {
+        t = a;
+        a = b;
+        b = t;
+    }
+    for (size_t i = 0; i < a->num_nz && a->nz[i] <= n; i++)
+        sum += a->c[a->nz[i]] * b->c[n - a->nz[i]];
+    return sum;
+}
+
+void lazy_multiply(lazy_qseries_t *a, lazy_qseries_t *b,
+        lazy_qseries_t *ans)
+{
+    lazy_init(ans, multiply_coef, NULL, NULL);
+    ans->a = a;
+    ans->b = b;
+}
+
+static int64_t divide_coef(lazy_qseries_t *s, size_t n)
+{
+    lazy_qseries_t *a = s->a, *b = s->b;
+    int64_t sum = lazy_coef(a, n);
+
+    lazy_coef(b, n);
+    if (lazy_operand_err(s, n))
+        return 0;
+    if (b->c[0] == 0) {
+        s->err = EDOM;
+        return 0;
+    }
+    for (size_t i = 1; i < b->num_nz && b->nz[i] <= n; i++)
+        sum -= b->c[b->nz[i]] * s->c[n - b->nz[i]];
+    return sum / b->c[0];
+}
+
+void lazy_divide(lazy_qseries_t *a, lazy_qseries_t *b, lazy_qseries_t *ans)
+{
+    lazy_init(ans, divide_coef, NULL, NULL);
+    ans->a = a;
+    ans->b = b;
+}
+
+/* Data of `product_coef`: the pattern and the log-derivative. */
+typedef struct {
+    int mod;
+    int *cong;
+    size_t cap;
+    int64_t *d;         /* q S'/S = sum d[k] q^k. */
+} lazy_product_t;
+
+static int64_t product_coef(lazy_qseries_t *s, size_t n)
+{
+    lazy_product_t *p = s->data;
+    __int128 sum = 0;
+    int64_t d = 0;
+
+    if (n == 0)
+        return 1;
+    /*
+     * With S = prod (1 - q^j)^e_j, e_j = cong[j % mod],
+     *   q S'/S = sum_k d_k q^k,  d_k = - sum_{j | k} j e_j,
+     * and so  n s_n = sum_{k=1}^n d_k s_{n-k}.
+     */
+    for (size_t j = 1; j * j <= n; j++) {
+        if (n % j)
+            continue;
+        d -= j * p->cong[j % p->mod];
+        if (j * j != n)
+            d -= (n / j) * p->cong[(n / j) % p->mod];
+    }
+    if (n >= p->cap) {
+        int64_t *d_new = realloc(p->d, 2 * n * sizeof(int64_t));
+        if (d_new == NULL) {
+            s->err = ENOMEM;
+            return 0;
+        }
+        p->d = d_new;
+        p->cap = 2 * n;
+    }
+    p->d[n] = d;
+    for (size_t k = 1; k <= n; k++)
+        sum += (__int128) p->d[k] * s->c[n - k];
+    if (sum / n > INT64_MAX || sum / n < INT64_MIN) {
+        s->err = ERANGE;
+        return 0;
+    }
+    return sum / (__int128) n;
+}
+
+static void free_product(void *data)
+{
+    lazy_product_t *p = data;
+
+    free(p->cong);
+    free(p->d);
+    free(p);
+}
+
+int lazy_product_side(lazy_qseries_t *s, int mod, const int cong[mod])
+{
+    lazy_product_t *p;
+
+    if ((p = calloc(1, sizeof(lazy_product_t))) == NULL)
+        return -1;
+    if ((p->cong = malloc(mod * sizeof(int))) == NULL) {
+        free(p);
+        return -1;
+    }
+    p->mod = mod;
+    memcpy(p->cong, cong, mod * sizeof(int));
+    lazy_init(s, product_coef, p, free_product);
+    return 0;
+}
+
+/*******************************************************************\
+ * Miscellaneous                                                   *
+ *******************************************************************/
+
+/*
+ * The factors (1 - q^n)^cong[n % mod] are grouped by residue class r
+ * (the product over the class is (q^r;q^mod)_oo, with r = 0 standing
+ * for (q^mod;q^mod)_oo) and taken out, as far as possible, as sparse
+ * series:
+ *   1. the most common exponent of the classes as (q;q)_oo,
+ *   2. pairs of classes r, mod - r with exponents of the same sign
+ *      as Jacobi triple products (q^r, q^(mod-r), q^mod; q^mod)_oo,
+ *   3. the class mod/2 (mod even) as (q^(mod/2);q^(mod/2))_oo,
+ *   4. the class 0 as (q^mod;q^mod)_oo,
+ * each applied to the dense result in O(ord sqrt(ord)).  Whatever is
+ * left is applied factor by factor, O(ord) each.
+ */
+void product_side(int mod, const int cong[mod], qseries_t *ans)
+{
+    int e[mod], best = 0, best_num = 0, s;
+    sparse_qseries_t sp;
+
+    for (int r = 0; r < mod; r++)
+        e[r] = cong[r];
+    for (int r = 0; r < mod; r++) {
+        int num = 0;
+        for (int t = 0; t < mod; t++)
+            num += (e[t] == e[r]);
+        if (num > best_num || (num == best_num && e[r] && ! best)) {
+            best = e[r];
+            best_num = num;
+        }
+    }
+    init_qseries(ans, 0);
+    ans->c[0] = 1;
+    if (best && euler_sparse(1, ans->ord, &sp) == 0) {
+        apply_sparse(&sp, best, ans);
+        free_sparse_qseries(&sp);
+        for (int r = 0; r < mod; r++)
+            e[r] -= best;
+    }
+    for (int r = 1; 2 * r < mod; r++) {
+        while (e[r] && e[mod-r] && (e[r] > 0) == (e[mod-r] > 0) &&
+                theta_sparse(r, mod, ans->ord, &sp) == 0) {
+            s = (e[r] > 0) ? 1 : -1;
+            apply_sparse(&sp, s, ans);
+            free_sparse_qseries(&sp);
+            e[r] -= s;
+            e[mod-r] -= s;
+            e[0] -= s;
+        }
+    }
+    if (mod % 2 == 0 && mod > 2 && e[mod/2] &&
+            euler_sparse(mod / 2, ans->ord, &sp) == 0) {
+        apply_sparse(&sp, e[mod/2], ans);
+        free_sparse_qseries(&sp);
+        e[0] -= e[mod/2];
+        e[mod/2] = 0;
+    }
+    if (e[0] && euler_sparse(mod, ans->ord, &sp) == 0) {
+        apply_sparse(&sp, e[0], ans);
+        free_sparse_qseries(&sp);
+        e[0] = 0;
+    }
+    for (size_t n = 1; n < ans->ord; n++)
+        if (e[n % mod])
+            multiply_factor_inplace_qseries(ans, 1, n, e[n % mod]);
+}
+
+int prodmake(const qseries_t *s, int64_t a[])
+{
+    qws_t *ws = qws_default();
+    qws_mark_t mark = qws_mark(ws);
+    size_t M = s->ord;
+    int64_t *c;
+
+    if (M == 0 || s->c[0] != 1 ||
+            (c = qws_alloc(ws, M * sizeof(int64_t))) == NULL)
+        return -1;
+    /*
+     * With S = prod (1 - q^n)^(-a_n), the logarithmic derivative gives
+     *   q S'/S = sum_m c_m q^m,  c_m = sum_{d | m} d a_d,
+     * and so  m s_m = sum_{k=1}^m c_k s_{m-k}.
+     */
+    for (size_t m = 1; m < M; m++) {
+        __int128 sum = (__int128) m * s->c[m];
+        for (size_t k = 1; k < m; k++)
+            sum -= (__int128) c[k] * s->c[m-k];
+        if (sum > INT64_MAX || sum < INT64_MIN) {
+            qws_release(ws, mark);
+            return -1;
+        }
+        c[m] = sum;
+    }
+    /* Moebius inversion, sieving out each d a_d from its multiples. */
+    a[0] = 0;
+    for (size_t d = 1; d < M; d++) {
+        if (c[d] % (int64_t) d) {
+            qws_release(ws, mark);
+            return -1;
+        }
+        a[d] = c[d] / (int64_t) d;
+        for (size_t m = 2 * d; m < M; m += d)
+            c[m] -= c[d];
+    }
+    qws_release(ws, mark);
+    return 0;
+}
+
+int prodmake_cong(size_t ord, const int64_t a[], int max_mod, int cong[])
+{
+    for (int mod = 1; mod <= max_mod && 2 * (size_t) mod < ord; mod++) {
+        size_t n;
+        for (n = mod + 1; n < ord; n++)
+            if (a[n] != a[n - mod])
+                break;
+        if (n < ord)
+            continue;
+        for (int r = 0; r < mod; r++)
+            cong[r] = -a[r ? r : mod];
+        return mod;
     }
+    return 0;
 }
 
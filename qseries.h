@@ -3,87 +3,592 @@
  *
  * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
  * Created:  2016-07-05
- * Modified: 2016-07-13
+ * Modified: 2026-10-18
  * License:  MIT License (see LICENSE.txt)
  *
  * Note: We are only dealing with q-series with integer coefficients
  *   (64-bit).
+ *
+ * Note: The order of a q-series is chosen at runtime when it is
+ *   allocated.  An operation computes its result `ans` up to the
+ *   order `ans->ord`; its operands must have (at least) that order.
  */
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
-/* The maximum order = highest degree + 1. */
-#define MAXORD 256
-
-/* Coefficient array to represent a q-series. */
-typedef int64_t qseries_t[MAXORD];
+/* A q-series truncated at order `ord` (= highest degree + 1). */
+typedef struct {
+    size_t ord;
+    int64_t *c;
+} qseries_t;
 
 /*******************************************************************\
  * Initializers                                                    *
  *******************************************************************/
 
+/*
+ * Allocate a q-series of order `ord` with all coefficients zero.
+ * Returns 0 on success and -1 if the allocation failed.
+ */
+int alloc_qseries(qseries_t *s, size_t ord);
+
+/* Free the coefficients of a q-series allocated by `alloc_qseries`. */
+void free_qseries(qseries_t *s);
+
 /* Initialize the coefficients of a q-series to `initial_val`. */
-void init_qseries(qseries_t s, int64_t initial_val);
+void init_qseries(qseries_t *s, int64_t initial_val);
 
 /*
  * Make a q-series from `num` consecutive elements, starting at
  * index `start`, of an array `a[]`, with coeffs shifted by `offset`.
  */
 void mk_qseries(const int64_t a[], size_t start, size_t num,
-        size_t offset, qseries_t s);
+        size_t offset, qseries_t *s);
 
 /* Copy a q-series `s` into another `t`. */
-void cp_qseries(const qseries_t s, qseries_t t);
+void cp_qseries(const qseries_t *s, qseries_t *t);
+
+/*******************************************************************\
+ * Workspaces                                                      *
+ *******************************************************************/
+
+/*
+ * A workspace (arena) of scratch memory.  Blocks are taken from it in
+ * stack order and given back all at once by going back to a mark, so
+ * that once it has grown to what a computation needs, running it
+ * again takes nothing from the heap.  It grows by chunks (each twice
+ * the last), which never move: blocks stay valid until released.
+ *
+ * The operations below that need scratch memory take it from the
+ * workspace of their thread (`qws_default`), and give it back before
+ * they return.
+ */
+#define QWS_CHUNKS 48
+
+typedef struct {
+    size_t size;
+    size_t top;         /* Bytes in use. */
+    char *mem;
+} qws_chunk_t;
+
+typedef struct {
+    size_t num;         /* Chunks allocated. */
+    size_t cur;         /* Chunk in use (the later ones are free). */
+    qws_chunk_t chunk[QWS_CHUNKS];
+} qws_t;
+
+/* A position in a workspace, to go back to. */
+typedef struct {
+    size_t cur;
+    size_t top;
+} qws_mark_t;
+
+/* Make an empty workspace. */
+void qws_init(qws_t *ws);
+
+/* Free the memory of a workspace (it is left empty). */
+void qws_free(qws_t *ws);
+
+/* The workspace of the calling thread (freed when the thread exits). */
+qws_t *qws_default(void);
+
+/* Take `size` bytes (aligned to 64) from `ws`; NULL if out of memory. */
+void *qws_alloc(qws_t *ws, size_t size);
+
+/*
+ * Take a q-series of order `ord` (all coefficients zero) from `ws`;
+ * it must not be freed.  Returns 0 on success, -1 if out of memory.
+ */
+int qws_series(qws_t *ws, size_t ord, qseries_t *s);
+
+/* The current position of `ws`. */
+qws_mark_t qws_mark(const qws_t *ws);
+
+/* Give back all that was taken from `ws` since the mark `m`. */
+void qws_release(qws_t *ws, qws_mark_t m);
 
 /*******************************************************************\
  * Input/Output                                                    *
  *******************************************************************/
 
-/* Print a q-series upto order `ord`. */
-void print_qseries(const qseries_t s, size_t ord);
+/*
+ * Print a q-series upto order `ord`, e.g. "1 - q - 2*q^3 + O(5)" (the
+ * output is buffered and formatted by hand: a million terms take a
+ * fraction of a second).
+ */
+void fprint_qseries(FILE *fp, const qseries_t *s, size_t ord);
+void print_qseries(const qseries_t *s, size_t ord);
 
 /* Print a q-series upto order `ord` (with a newline). */
-void println_qseries(const qseries_t s, size_t ord);
+void println_qseries(const qseries_t *s, size_t ord);
 
-/* Print the coefficient array of the q-series `s`. */
-void print_coeffs(const qseries_t s, size_t ord);
+/* Print the coefficient array of the q-series `s`, e.g. "[1, -1, 0]". */
+void fprint_coeffs(FILE *fp, const qseries_t *s, size_t ord);
+void print_coeffs(const qseries_t *s, size_t ord);
 
 /* Print the coefficient array of the q-series `s` (with newline). */
-void println_coeffs(const qseries_t s, size_t ord);
+void println_coeffs(const qseries_t *s, size_t ord);
+
+/*
+ * The readers below fill `s` up to its order (terms beyond it are
+ * dropped, and missing ones are zero); if `s->c` is NULL, `s` is
+ * allocated with the order of the input instead.  They return 0 on
+ * success and -1 on a syntax error, a coefficient that does not fit in
+ * 64 bits or out of memory.
+ */
+
+/*
+ * Read a q-series written as by `print_qseries`: terms [C][*]q[^D]
+ * (in any order; like terms add up), white space anywhere, and an
+ * optional last term O(N) or O(q^N) giving the order (else the
+ * highest degree + 1).
+ */
+int read_qseries(const char *buf, qseries_t *s);
+
+/*
+ * Read a list of coefficients, separated by white space or commas, as
+ * written by `print_coeffs` (the brackets are optional).
+ */
+int read_coeffs(const char *buf, qseries_t *s);
+
+/*
+ * Read an OEIS b-file: lines "n a(n)" (a(n) the coefficient of q^n;
+ * the order is the highest n + 1), blank lines and comments '#'.
+ */
+int read_bfile(FILE *fp, qseries_t *s);
+
+/*
+ * Binary series files hold a header (magic, byte order mark, order,
+ * checksum), an optional extension (up to 64 KiB of data of the
+ * caller, e.g. the key of a cached series) and the coefficients, in
+ * the byte order of the machine, so that a file can be mapped into
+ * memory and used as it is.
+ */
+
+/* A q-series mapped from a file (read-only). */
+typedef struct {
+    qseries_t s;        /* `s.c` points into the mapping. */
+    const void *ext;    /* The extension (NULL if none). */
+    size_t ext_len;
+    void *map;
+    size_t len;
+} qseries_map_t;
+
+/*
+ * Write `s` to the binary file `path` (through a temporary file,
+ * renamed into place).  Returns 0 on success, -1 on failure.
+ */
+int save_qseries(const char *path, const qseries_t *s);
+
+/* The same with the extension `ext` of `ext_len` bytes. */
+int save_qseries_ext(const char *path, const qseries_t *s,
+        const void *ext, size_t ext_len);
+
+/*
+ * Map the binary file `path` into `m`.  Returns 0 on success, -1 if
+ * it cannot be read or is not a valid series file (of this byte order).
+ */
+int map_qseries(const char *path, qseries_map_t *m);
+
+/* Unmap a series mapped by `map_qseries`. */
+void unmap_qseries(qseries_map_t *m);
 
-/* Read a q-series into `s`. */
-void read_qseries(const char *buf, qseries_t s);
+/*******************************************************************\
+ * Large Orders                                                    *
+ *******************************************************************/
+
+/*
+ * Products of large orders go by Karatsuba from 96 terms, and by
+ * number theoretic transforms (modulo 3 primes, put together by CRT:
+ * still exact modulo 2^64) from 16384; inverses with constant term
+ * +-1 by Newton's iteration from 512 terms (quotients from 1024), and
+ * powers by these products.  From 4096 terms, the work is split over
+ * threads started for each operation: set how many (0, the default:
+ * all the online CPUs).
+ */
+void set_qseries_threads(int threads);
+int qseries_threads(void);
 
 /*******************************************************************\
  * Basic Operations                                                *
  *******************************************************************/
 
 /* Shift the power series by `shift` to the right, result in `ans` */
-void shift_qseries(const qseries_t s, int shift, qseries_t ans);
+void shift_qseries(const qseries_t *s, int shift, qseries_t *ans);
 
 /* Scale a q-series `s` by a scalar `c`, put the result in `ans`. */
-void scale_qseries(int64_t c, const qseries_t s, qseries_t ans);
+void scale_qseries(int64_t c, const qseries_t *s, qseries_t *ans);
 
 /* Add two q-series, put the result in `ans`. */
-void add_qseries(const qseries_t s, const qseries_t t, qseries_t ans);
+void add_qseries(const qseries_t *s, const qseries_t *t,
+        qseries_t *ans);
 
 /* Subtract q-sries `t` from the q-series `s`, result in `ans`. */
-void subtract_qseries(const qseries_t s, const qseries_t t, qseries_t ans);
+void subtract_qseries(const qseries_t *s, const qseries_t *t,
+        qseries_t *ans);
 
-/* Multiply two q-series, put the resutl in `ans`. */
-void multiply_qseries(const qseries_t s, const qseries_t t, qseries_t ans);
+/*
+ * Multiply two q-series, put the result in `ans` (may be `s` and/or
+ * `t`, with no scratch memory below 96 terms).
+ */
+void multiply_qseries(const qseries_t *s, const qseries_t *t,
+        qseries_t *ans);
+
+/* Invert a q-series, put the result in `ans` (may be `s`). */
+void invert_qseries(const qseries_t *s, qseries_t *ans);
 
-/* Invert a q-series, put the result in `ans`. */
-void invert_qseries(const qseries_t s, qseries_t ans);
+/*
+ * Divide a q-series `s` by another `t`, put the result in `ans` (may
+ * be `s` or `t`).  For t->c[0] = +-1, `ans` other than `t` and below
+ * 1024 terms, this is a long division with no scratch memory.
+ */
+void divide_qseries(const qseries_t *s, const qseries_t *t,
+        qseries_t *ans);
 
-/* Divide a q-series `s` by another `t`, put the result in `ans`. */
-void divide_qseries(const qseries_t s, const qseries_t t, qseries_t ans);
+/*
+ * In place: `s` = `s` * `t` (`t` may be `s`), `s` = `s` / `t`
+ * (t->c[0] = +-1), and `s` = `s` * (1 - a q^n)^k (in O(ord |k|)),
+ * with no scratch memory for small orders (see above).
+ */
+void multiply_inplace_qseries(qseries_t *s, const qseries_t *t);
+void divide_inplace_qseries(qseries_t *s, const qseries_t *t);
+void multiply_factor_inplace_qseries(qseries_t *s, int64_t a, size_t n,
+        int k);
 
-/* Compute q-series `s`, raised to the power `n`, result in `ans`. */
-/* Right now, n is assumed to be an integer. */
-void pow_qseries(const qseries_t s, int n, qseries_t ans);
+/*
+ * Compute q-series `s`, raised to the power `n`, result in `ans` (may
+ * be `s`).  With s->c[0] = +-1 this uses J.C.P. Miller's recurrence,
+ * O(ord nnz(s)) for any n; if the coefficients overflow 64 bits, or
+ * for other s->c[0] (n >= 0), binary powering, O(M(ord) log |n|)
+ * with M(ord) the cost of a product (see above).
+ */
+void pow_qseries(const qseries_t *s, int n, qseries_t *ans);
+
+/*
+ * Compute `s`^(p/q), q > 0, for s->c[0] = 1 (Miller's recurrence),
+ * result in `ans` (may be `s`).  Returns 0 on success, and -1 if the
+ * result does not have (64-bit) integer coefficients, or s->c[0] != 1
+ * (`ans` is then undefined).
+ */
+int powq_qseries(const qseries_t *s, int p, int q, qseries_t *ans);
+
+/*******************************************************************\
+ * Sparse Series and Products                                      *
+ *******************************************************************/
+
+/*
+ * A sparse q-series: the terms c[i] q^deg[i], i < num, with deg[]
+ * increasing, truncated at order `ord`.  The theta-type products
+ * below have O(sqrt(ord)) terms, so that multiplying (or dividing) a
+ * dense series by one takes O(ord sqrt(ord)) instead of O(ord^2).
+ */
+typedef struct {
+    size_t ord;
+    size_t num;
+    size_t *deg;
+    int64_t *c;
+} sparse_qseries_t;
+
+/* Free the terms of a sparse q-series. */
+void free_sparse_qseries(sparse_qseries_t *s);
+
+/*
+ * The sparse constructors below make `s` of order `ord`; they return
+ * 0 on success and -1 if out of memory.
+ */
+
+/* Euler's product (q^m;q^m)_oo = sum (-1)^k q^(m k (3k - 1) / 2). */
+int euler_sparse(int m, size_t ord, sparse_qseries_t *s);
+
+/*
+ * Jacobi's triple product (q^a, q^(m-a), q^m; q^m)_oo
+ *      = sum (-1)^k q^(m k (k - 1) / 2 + a k),  0 < a < m.
+ */
+int theta_sparse(int a, int m, size_t ord, sparse_qseries_t *s);
+
+/*
+ * The quintuple product, 0 < 2a < m,
+ *      (q^a, q^(m-a), q^m; q^m)_oo (q^(m-2a), q^(m+2a); q^(2m))_oo
+ *      = sum q^(m k (3k + 1) / 2) (q^(-3ak) - q^(3ak + a)).
+ */
+int quintuple_sparse(int a, int m, size_t ord, sparse_qseries_t *s);
+
+/* Multiply the dense `t` by the sparse `s`; `ans` may be `t`. */
+void multiply_sparse_qseries(const sparse_qseries_t *s,
+        const qseries_t *t, qseries_t *ans);
+
+/*
+ * Divide the dense `t` by the sparse `s` (with s->deg[0] = 0 and
+ * s->c[0] = +-1); `ans` may be `t`.
+ */
+void divide_sparse_qseries(const qseries_t *t, const sparse_qseries_t *s,
+        qseries_t *ans);
+
+/*
+ * The q-Pochhammer symbol (a q^k; q^m)_oo
+ *      = Product over j >= 0: (1 - a q^(k + j m)),  0 <= k, 0 < m,
+ * put in `ans`.
+ */
+void qpochhammer_qseries(int64_t a, int k, int m, qseries_t *ans);
+
+/*
+ * The eta-product (quotient)
+ *      Product over i < num: (q^delta[i]; q^delta[i])_oo^r[i],
+ * put in `ans`, in O(ord sqrt(ord) sum |r[i]|).
+ */
+void eta_quotient(size_t num, const int delta[num], const int r[num],
+        qseries_t *ans);
+
+/*******************************************************************\
+ * Batched Series                                                  *
+ *******************************************************************/
+
+/*
+ * A batch of `num` q-series of the same order, interleaved (structure
+ * of arrays): the coefficient of q^deg of series b is
+ * c[deg * num + b].  An operation on the batch is one pass over the
+ * degrees whose inner loop runs over `num` contiguous coefficients,
+ * which the compiler vectorizes; screening many series against the
+ * same factor or target thus costs one loop instead of `num`.
+ */
+typedef struct {
+    size_t ord;
+    size_t num;
+    int64_t *c;
+} qbatch_t;
+
+/*
+ * Allocate a batch of `num` series of order `ord`, all zero.  Returns
+ * 0 on success and -1 if the allocation failed.
+ */
+int alloc_qbatch(size_t num, size_t ord, qbatch_t *s);
+
+/* Free a batch allocated by `alloc_qbatch`. */
+void free_qbatch(qbatch_t *s);
+
+/* Set series `b` of the batch `s` to `t`, or get it into `t`. */
+void set_qbatch(qbatch_t *s, size_t b, const qseries_t *t);
+void get_qbatch(const qbatch_t *s, size_t b, qseries_t *t);
+
+/*
+ * Add two batches, and scale a batch by `c`, result in `ans` (may be
+ * an operand).
+ */
+void add_qbatch(const qbatch_t *s, const qbatch_t *t, qbatch_t *ans);
+void scale_qbatch(int64_t c, const qbatch_t *s, qbatch_t *ans);
+
+/* Multiply each series of `t` by the sparse `s`; `ans` may be `t`. */
+void multiply_sparse_qbatch(const sparse_qseries_t *s, const qbatch_t *t,
+        qbatch_t *ans);
+
+/*
+ * Divide each series of `t` by the sparse `s` (with s->deg[0] = 0 and
+ * s->c[0] = +-1); `ans` may be `t`.
+ */
+void divide_sparse_qbatch(const qbatch_t *t, const sparse_qseries_t *s,
+        qbatch_t *ans);
+
+/*
+ * In place: multiply series b of `s` by (1 - q^n)^k[b], n > 0, for
+ * all b at once (k[b] = 0 leaves it as it is).
+ */
+void multiply_factors_qbatch(qbatch_t *s, size_t n, const int k[]);
+
+/*
+ * The product sides of `num` patterns of the same modulus, series b
+ * being `product_side(mod, cong + b * mod)`, put in `ans` (of `num`
+ * series).
+ */
+void product_side_qbatch(int mod, const int cong[], qbatch_t *ans);
+
+/*
+ * Compare each series of `s` with `t`: first[b] is the first degree
+ * where series b differs from `t`, or the order if there is none.
+ * Returns the number of series equal to `t` up to the order.
+ */
+size_t compare_qbatch(const qbatch_t *s, const qseries_t *t,
+        size_t first[]);
+
+/*******************************************************************\
+ * Product Side Sweeps                                             *
+ *******************************************************************/
+
+/* Largest modulus of a sweep. */
+#define QSWEEP_MAX_MOD 32
+
+/*
+ * A sweep over the patterns cong[] of `product_side` of modulus `mod`
+ * with lo[r] <= cong[r] <= hi[r] (e.g. all 3^mod in {-1, 0, 1}^mod),
+ * in (reflected, mixed-radix) Gray code order: from one pattern to
+ * the next, one cong[r] changes by +-1, and so the product side by the
+ * factor (q^r;q^mod)_oo^(+-1) (q^mod for r = 0), applied as the
+ * single factors (1 - q^n)^(+-1), n = r (mod `mod`), in
+ * O(ord^2 / mod) instead of a product side from scratch.  The Gray
+ * code is cut into `threads` ranges, one per thread, each starting
+ * from `product_side`; the visitor may filter the patterns further.
+ */
+typedef struct {
+    int mod;
+    size_t ord;
+    int lo[QSWEEP_MAX_MOD];
+    int hi[QSWEEP_MAX_MOD];
+    int threads;
+    /*
+     * Called with each pattern and its product side (of order `ord`),
+     * by the thread `thread` (its patterns in Gray code order).
+     */
+    void (*visit)(const int cong[], const qseries_t *s, int thread,
+            void *arg);
+    void *arg;
+} qsweep_t;
+
+/*
+ * Set up `sw` for all the patterns in {-1, 0, 1}^mod, of order `ord`,
+ * with one thread (the visitor is left to the caller).
+ */
+void qsweep_init(qsweep_t *sw, int mod, size_t ord);
+
+/* The number of patterns of the sweep. */
+uint64_t qsweep_count(const qsweep_t *sw);
+
+/* The pattern number `i` of the sweep (in Gray code order). */
+void qsweep_pattern(const qsweep_t *sw, uint64_t i, int cong[]);
+
+/*
+ * Run the sweep.  Returns 0 on success, and -1 if it is invalid
+ * (mod, lo[], hi[]), out of memory or a thread cannot be started.
+ */
+int qsweep_run(const qsweep_t *sw);
+
+/*******************************************************************\
+ * q-Hypergeometric Sums                                           *
+ *******************************************************************/
+
+/* Most q-Pochhammer symbols in the numerator (denominator) of a sum. */
+#define QHYPER_MAX 4
+
+/* The q-Pochhammer symbol (a q^k; q^m)_n of a term of a sum. */
+typedef struct {
+    int64_t a;
+    int k;
+    int m;
+} qhyper_poch_t;
+
+/*
+ * The q-hypergeometric sum, over n >= 0, of
+ *      c^n q^((a2 n^2 + a1 n) / 2) prod num[i]_n / prod den[j]_n,
+ * e.g. the first Rogers-Ramanujan sum, sum q^(n^2) / (q;q)_n, is
+ *      {.a2 = 2, .a1 = 0, .c = 1, .num_den = 1, .den = {{1, 1, 1}}}.
+ */
+typedef struct {
+    int a2, a1;
+    int64_t c;
+    size_t num_num;
+    qhyper_poch_t num[QHYPER_MAX];
+    size_t num_den;
+    qhyper_poch_t den[QHYPER_MAX];
+} qhyper_t;
+
+/*
+ * Evaluate the sum `h` up to the order of `ans`, term by term: the
+ * q-Pochhammer symbols of term n + 1 are those of term n times one
+ * factor each (in O(ord)), and the terms stop once their lowest
+ * degree (a2 n^2 + a1 n) / 2 passes the order, so quadratic exponents
+ * take O(ord sqrt(ord)).  Returns 0 on success, and -1 if the
+ * exponents are not nonnegative integers, the sum does not converge
+ * (the exponents do not rise), or a denominator has k < 1 or m < 0.
+ */
+int qhyper_sum(const qhyper_t *h, qseries_t *ans);
+
+/*******************************************************************\
+ * Lazy Series                                                     *
+ *******************************************************************/
+
+/*
+ * A lazy (online) q-series: its coefficients are computed on demand,
+ * in increasing degree, and kept.  Coefficient n of a product or a
+ * quotient needs only the coefficients up to n of the operands, so a
+ * series built from others is evaluated only as far as it is read,
+ * e.g. when two series are compared up to their first difference.
+ * The operands are read through their own caches, and products visit
+ * only the nonzero terms of the sparser operand (known so far), so
+ * sparse factors cost O(nnz) per coefficient.
+ *
+ * A coefficient that cannot be computed sets `err` (see `lazy_coef`)
+ * instead of stopping the program, so the caller decides what to do.
+ *
+ * Note: Not thread-safe; reading a coefficient may extend the series
+ *   and its operands.
+ */
+typedef struct lazy_qseries lazy_qseries_t;
+
+/* Compute coefficient `n` of `s` (those below n are known). */
+typedef int64_t lazy_coef_f(lazy_qseries_t *s, size_t n);
+
+struct lazy_qseries {
+    size_t num;             /* Known coefficients c[0], ..., c[num-1]. */
+    size_t cap;
+    int64_t *c;
+    size_t num_nz;          /* Degrees of the nonzero known ones. */
+    size_t *nz;
+    lazy_coef_f *coef;
+    lazy_qseries_t *a, *b;  /* Operands of a product or quotient. */
+    void *data;             /* Data of `coef`. */
+    void (*free_data)(void *);  /* Frees `data` (NULL if not owned). */
+    int err;                /* 0, or why the series stopped. */
+};
+
+/* Free a lazy series (not its operands, nor borrowed series). */
+void free_lazy_qseries(lazy_qseries_t *s);
+
+/*
+ * Coefficient `n` of `s` (computed if it is not yet known).  If it
+ * cannot be computed, `s->err` is set and 0 is returned: ENOMEM if out
+ * of memory, ERANGE if a coefficient of `lazy_product_side` does not
+ * fit in 64 bits, EDOM for a degree beyond a dense or sparse series or
+ * a quotient by a series with zero constant term.  The error stays
+ * set (nothing more is computed), but the coefficients known before
+ * it are still returned.  A product or quotient fails where one of its
+ * operands does.
+ */
+int64_t lazy_coef(lazy_qseries_t *s, size_t n);
+
+/*
+ * The first degree n < `ord` where `s` and `t` differ (or where either
+ * one cannot be computed, see `lazy_coef`), or `ord` if they agree up
+ * to it; nothing beyond that degree is computed.
+ */
+size_t lazy_first_difference(lazy_qseries_t *s, lazy_qseries_t *t,
+        size_t ord);
+
+/*
+ * The constructors below borrow their series (which must outlive
+ * `s`): reading a dense or sparse series beyond its order is an error
+ * (EDOM).
+ */
+void lazy_from_qseries(lazy_qseries_t *s, const qseries_t *t);
+void lazy_from_sparse(lazy_qseries_t *s, const sparse_qseries_t *t);
+
+/* The series with coefficients func(n, arg), asked for in order. */
+void lazy_from_func(lazy_qseries_t *s, int64_t (*func)(size_t n, void *arg),
+        void *arg);
+
+/* The online product and quotient (b->c[0] = +-1) of `a` and `b`. */
+void lazy_multiply(lazy_qseries_t *a, lazy_qseries_t *b,
+        lazy_qseries_t *ans);
+void lazy_divide(lazy_qseries_t *a, lazy_qseries_t *b, lazy_qseries_t *ans);
+
+/*
+ * The product side of `product_side`, unbounded, O(n) per coefficient
+ * (a coefficient that does not fit in 64 bits is an error, ERANGE,
+ * where `product_side` wraps modulo 2^64).  Returns 0
+ * on success, -1 if out of memory.
+ */
+int lazy_product_side(lazy_qseries_t *s, int mod, const int cong[mod]);
 
 /*******************************************************************\
  * Miscellaneous                                                   *
@@ -93,7 +598,28 @@ void pow_qseries(const qseries_t s, int n, qseries_t ans);
  * Compute the product side, put the result in `ans`.
  *   Product over all natural number, n:
  *      (1 - q^n)^cong[n]
- *   cong[n] = -1, 0, or 1.
+ *   cong[n] = -1, 0, or 1 (any integer will do).
+ * Whole residue classes are taken out as sparse Euler and Jacobi
+ * products, so that typical products take O(ord sqrt(ord)).
+ */
+void product_side(int mod, const int cong[mod], qseries_t *ans);
+
+/*
+ * Find the product form of `s` (Andrews' prodmake): the exponents
+ * a[1], ..., a[ord-1] with
+ *      s = Product over n >= 1: (1 - q^n)^(-a[n])
+ * up to the order of `s` (a[0] is set to 0), in O(ord^2).  Returns 0
+ * on success, and -1 if s->c[0] != 1, some a[n] is not an integer
+ * (then `s` has no such product form), or out of memory.
+ */
+int prodmake(const qseries_t *s, int64_t a[]);
+
+/*
+ * Look for the smallest period `mod <= max_mod` of the exponents
+ * a[1], ..., a[ord-1] found by `prodmake`, seen at least twice (so
+ * 2 * mod < ord).  If there is one, fill `cong[0..mod-1]` for
+ * `product_side` (cong[n % mod] = -a[n]) and return `mod`, else
+ * return 0.
  */
-void product_side(int mod, const int cong[mod], qseries_t ans);
+int prodmake_cong(size_t ord, const int64_t a[], int max_mod, int cong[]);
 
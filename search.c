@@ -0,0 +1,862 @@
+/*
+ * search.c - Search for partition identities (partnsearch).
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   CC = gcc #(or clang)
+ *   CFLAGS = -std=gnu11 -Ofast #(or, -O2, -O3)
+ *   OBJS = partition.o qseries.o shard.o topology.o util.o
+ *   LIBS = -lpthread
+ *   $(CC) $(CFLAGS) -o partnsearch search.c $(OBJS) $(LIBS)
+ *
+ * Usage: ./partnsearch [OPTIONS] N
+ *
+ *   -d, --dists LO:HI     Distances of the differences (default: 1:2).
+ *   -k, --diffs K         Forbidden differences are the non-empty
+ *                         subsets of 0, ..., K-1 (default: 3).
+ *   -m, --mods LO:HI      Moduli of the window sums (default: 2:8).
+ *   -b, --bank LO:HI      Moduli of the products (default: 1:12).
+ *   -t, --time SECS       Time budget (default: 60; 0: none).
+ *   -T, --threads T       Threads (default: the online CPUs).
+ *   -p, --prodmake        Also find the product form of the sum sides
+ *                         that match nothing in the bank.
+ *   -g, --signed          Bank of signed products (see below).
+ *
+ * A rule, in the form of the identities in partnid.c, forbids the
+ * (ascending) partitions with a part a[i], i >= d, such that
+ *
+ *   a[i] - a[i-d] is in D  and  a[i-d] + ... + a[i] = r (mod m),
+ *
+ * and those starting with the initial condition (IC) none, (1) or
+ * (1,1).  All the rules with d, D, m, r and IC in the ranges above
+ * are counted in one pass over the partitions of each n <= N: for a
+ * partition, the residues of the window sums are collected per
+ * distance, difference and modulus as bit sets, and each rule that
+ * rejects it gets one count (most rules reject few partitions, so
+ * counting the rejections is cheaper than counting the survivors).
+ *
+ * The sum sides are then looked up (by a hash of their coefficients)
+ * in a bank of product sides: all the products over parts not in
+ * some set of residues mod M, with M in the --bank range (patterns
+ * that are periodic mod a divisor of M are left to that divisor).
+ * With --prodmake, the product form of every other sum side is found
+ * directly (see `prodmake` in qseries.h) and reported if its
+ * exponents are periodic: this also finds products with exponents
+ * other than 0 and 1, or with moduli beyond the bank.
+ *
+ * With --signed, the bank holds instead the products
+ * prod_{n >= 1} (1 - q^n)^cong[n mod M] for all the cong[] in
+ * {-1, 0, 1}^M (3^M of them, swept in Gray code order by all the
+ * threads, see `qsweep_t`), less the periodic ones and those with a
+ * negative coefficient up to q^N (no sum side has one).
+ *
+ * The work is split into the units of the shard planner (see
+ * shard.h), in increasing n, taken by the threads one at a time.
+ * When the time budget runs out the threads stop after their current
+ * unit, and the matches are reported for the n that were completed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "partition.h"
+#include "qseries.h"
+#include "shard.h"
+#include "topology.h"
+#include "util.h"
+
+/*******************************************************************\
+ * Types                                                           *
+\*******************************************************************/
+
+typedef enum {
+    E_SUCCESS,
+    E_INVALID_ARGS,
+    E_THREAD_FAILURE,
+    E_OUT_OF_MEMORY,
+} err_t;
+
+/* Initial conditions: none, (1) and (1,1). */
+#define IC_NUM 3
+
+/* Limits of the options (the residues are bits of a uint32_t). */
+#define MAX_DIST 8
+#define MAX_DIFFS 6
+#define MAX_MOD 32
+#define MAX_BANK_MOD 20
+
+/* Products of the bank computed together (see `qbatch_t`). */
+#define BANK_BATCH 64
+
+/* Options. */
+typedef struct {
+    int N;
+    int d_lo, d_hi;     /* Distances. */
+    int diffs;          /* Differences 0, ..., diffs-1. */
+    int m_lo, m_hi;     /* Moduli of the window sums. */
+    int b_lo, b_hi;     /* Moduli of the products. */
+    double time;        /* Time budget (s), 0 for none. */
+    int threads;
+    bool prodmake;      /* Product forms of the unmatched sum sides. */
+    bool signed_bank;   /* Products with cong[] in {-1, 0, 1}^M. */
+} options_t;
+
+/*
+ * The rules (without IC), indexed by (d, D, m, r) with D a non-empty
+ * mask of differences, in this order of the loops.
+ */
+typedef struct {
+    int num_dists, num_masks, num_mods;
+    int num_rules;
+    int *base;          /* Index of (d, D, m, 0). */
+} family_t;
+
+/*
+ * A product side: the parts = i (mod `mod`) allowed iff bit i of
+ * `allowed`, and the factors (1 - q^n), n = i (mod `mod`), in the
+ * numerator iff bit i of `numer` (signed products only).
+ */
+typedef struct {
+    int mod;
+    uint32_t allowed;
+    uint32_t numer;
+} product_t;
+
+/* The bank of product sides (coefficients of n = 0, ..., N). */
+typedef struct {
+    size_t num;
+    product_t *prods;
+    int64_t *coefs;     /* `num` rows of `row` = N + 1. */
+    size_t row;
+    size_t size;        /* Of the hash table (a power of 2). */
+    int64_t *table;     /* Indices into `prods` (-1 if empty). */
+    bool built;         /* Coefficients computed (else by the workers). */
+} bank_t;
+
+/* The products kept by a thread of the sweep of the signed bank. */
+typedef struct {
+    size_t num, cap;
+    product_t *prods;
+    int64_t *coefs;
+    int err;
+} bank_part_t;
+
+/* A sweep of the signed bank (modulus `mod`). */
+typedef struct {
+    int mod, N;
+    bank_part_t *parts;     /* [thread] */
+} bank_sweep_t;
+
+/* Counts of a thread (for all n). */
+typedef struct {
+    uint64_t *rej;      /* [n][v][rule]: rejected, with IC level v. */
+    uint64_t *icnt;     /* [n][v]: partitions with IC level v. */
+    uint32_t *occ;      /* [d][diff][m]: residues of the window sums. */
+    uint32_t *uni;      /* [D]: residues for a set of differences. */
+} counts_t;
+
+/* The search (shared by the threads). */
+typedef struct {
+    /* Next work item and bank entry, each on a cache line of its own. */
+    struct {
+        size_t i;
+    } __attribute__((aligned(CACHE_LINE))) next_item, next_prod;
+    const options_t *opt;
+    family_t fam;
+    bank_t bank;
+    shard_plan_t *plans;    /* [n] */
+    size_t *first_item;     /* [n]: first item of n (and total at N+1). */
+    size_t *units_done;     /* [n] */
+    uint64_t deadline;      /* nanotime() (0 for none). */
+    volatile bool expired;
+} search_t;
+
+/* A thread. */
+typedef struct {
+    search_t *s;
+    counts_t ct;
+    pthread_t thread;
+} __attribute__((aligned(CACHE_LINE))) worker_t;
+
+/*******************************************************************\
+ * Declarations                                                    *
+\*******************************************************************/
+
+static inline void usage(const char *com);
+static inline err_t parse_args(int argc, char *argv[], options_t *opt);
+
+static inline int plan_family(family_t *fam, const options_t *opt);
+static inline int plan_bank(bank_t *bank, const options_t *opt);
+static inline int sweep_bank(bank_t *bank, const options_t *opt);
+static inline void product_coefs(const product_t p[], size_t num, int N,
+        int64_t coefs[], size_t row);
+
+static void count_visit(const partition_t *p, void *argres);
+static void *run_worker(void *arg);
+
+static inline int done_upto(const search_t *s);
+static inline void hash_bank(bank_t *bank, int N);
+static inline size_t report_matches(const search_t *s,
+        const worker_t *w, int N);
+
+/*******************************************************************\
+ * Main                                                            *
+\*******************************************************************/
+
+int main(int argc, char *argv[])
+{
+    options_t opt;
+    search_t s;
+    worker_t *w;
+    uint64_t t0;
+    size_t matches;
+    int N, done;
+    err_t err;
+
+    if ((err = parse_args(argc, argv, &opt))) {
+        usage(argv[0]);
+        return err;
+    }
+    N = opt.N;
+    memset(&s, 0, sizeof(s));
+    s.opt = &opt;
+    t0 = nanotime();
+    s.deadline = opt.time > 0 ? t0 + (uint64_t) (opt.time * 1e9) : 0;
+    s.plans = calloc(N + 1, sizeof(shard_plan_t));
+    s.first_item = calloc(N + 2, sizeof(size_t));
+    s.units_done = calloc(N + 1, sizeof(size_t));
+    w = aligned_alloc(CACHE_LINE, opt.threads * sizeof(worker_t));
+    if (s.plans == NULL || s.first_item == NULL || s.units_done == NULL ||
+            w == NULL || plan_family(&s.fam, &opt) ||
+            plan_bank(&s.bank, &opt)) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        return E_OUT_OF_MEMORY;
+    }
+    for (int n = 0; n <= N; n++) {
+        if (plan_shards(&s.plans[n], n, opt.threads)) {
+            fprintf(stderr, "[ERR] Out of memory!\n");
+            return E_OUT_OF_MEMORY;
+        }
+        s.first_item[n+1] = s.first_item[n] + s.plans[n].num_units;
+    }
+
+    printf("Rules: %d (d = %d..%d, D in 0..%d, m = %d..%d, r, IC)\n",
+            s.fam.num_rules * IC_NUM, opt.d_lo, opt.d_hi, opt.diffs - 1,
+            opt.m_lo, opt.m_hi);
+    printf("Products: %zu (mod %d..%d%s)\n", s.bank.num, opt.b_lo,
+            opt.b_hi, opt.signed_bank ? ", signed" : "");
+    fflush(stdout);
+
+    for (int t = 0; t < opt.threads; t++) {
+        w[t].s = &s;
+        w[t].ct.rej = calloc((size_t) (N + 1) * IC_NUM * s.fam.num_rules,
+                sizeof(uint64_t));
+        w[t].ct.icnt = calloc((N + 1) * IC_NUM, sizeof(uint64_t));
+        w[t].ct.occ = malloc(s.fam.num_dists * opt.diffs *
+                s.fam.num_mods * sizeof(uint32_t));
+        w[t].ct.uni = malloc((1u << opt.diffs) * sizeof(uint32_t));
+        if (w[t].ct.rej == NULL || w[t].ct.icnt == NULL ||
+                w[t].ct.occ == NULL || w[t].ct.uni == NULL) {
+            fprintf(stderr, "[ERR] Out of memory!\n");
+            return E_OUT_OF_MEMORY;
+        }
+        if (pthread_create(&w[t].thread, NULL, run_worker, &w[t])) {
+            fprintf(stderr, "[ERR] Failed to create thread!\n");
+            return E_THREAD_FAILURE;
+        }
+    }
+    for (int t = 0; t < opt.threads; t++)
+        pthread_join(w[t].thread, NULL);
+    for (int t = 1; t < opt.threads; t++) {
+        size_t len = (size_t) (N + 1) * IC_NUM * s.fam.num_rules;
+        for (size_t i = 0; i < len; i++)
+            w[0].ct.rej[i] += w[t].ct.rej[i];
+        for (size_t i = 0; i < (size_t) (N + 1) * IC_NUM; i++)
+            w[0].ct.icnt[i] += w[t].ct.icnt[i];
+    }
+
+    done = done_upto(&s);
+    printf("Done: n <= %d%s in %.1f s with %d threads.\n\n", done,
+            done < N ? " (time budget exhausted)" : "",
+            (nanotime() - t0) / 1e9, opt.threads);
+    if (done < 0)
+        return E_SUCCESS;
+    hash_bank(&s.bank, done);
+    matches = report_matches(&s, &w[0], done);
+    printf("\n%zu match%s.\n", matches, matches == 1 ? "" : "es");
+
+    for (int t = 0; t < opt.threads; t++) {
+        free(w[t].ct.rej);
+        free(w[t].ct.icnt);
+        free(w[t].ct.occ);
+        free(w[t].ct.uni);
+    }
+    for (int n = 0; n <= N; n++)
+        free_shard_plan(&s.plans[n]);
+    free(w);
+    free(s.plans);
+    free(s.first_item);
+    free(s.units_done);
+    free(s.fam.base);
+    free(s.bank.prods);
+    free(s.bank.coefs);
+    free(s.bank.table);
+    return E_SUCCESS;
+}
+
+static inline void usage(const char *com)
+{
+    fprintf(stderr, "Search for partition identities.\n\n");
+    fprintf(stderr, "Usage: %s [OPTIONS] N\n\n", com);
+    fprintf(stderr, "  -d, --dists LO:HI\tDistances of the differences ");
+    fprintf(stderr, "(default: 1:2).\n");
+    fprintf(stderr, "  -k, --diffs K\t\tForbidden differences: subsets ");
+    fprintf(stderr, "of 0..K-1 (default: 3).\n");
+    fprintf(stderr, "  -m, --mods LO:HI\tModuli of the window sums ");
+    fprintf(stderr, "(default: 2:8).\n");
+    fprintf(stderr, "  -b, --bank LO:HI\tModuli of the products ");
+    fprintf(stderr, "(default: 1:12).\n");
+    fprintf(stderr, "  -t, --time SECS\tTime budget (default: 60; ");
+    fprintf(stderr, "0: none).\n");
+    fprintf(stderr, "  -T, --threads T\tThreads (default: the online ");
+    fprintf(stderr, "CPUs, %d).\n", online_cpus());
+    fprintf(stderr, "  -p, --prodmake\t\tAlso find the product form ");
+    fprintf(stderr, "of the sum sides\n\t\t\tmatching nothing in ");
+    fprintf(stderr, "the bank.\n");
+    fprintf(stderr, "  -g, --signed\t\tBank of the products with ");
+    fprintf(stderr, "cong[] in {-1, 0, 1}^M.\n");
+}
+
+/* Parse "LO:HI" (or "LO") into `*lo`, `*hi`. */
+static inline bool parse_range(const char *s, int *lo, int *hi)
+{
+    int c = sscanf(s, "%d:%d", lo, hi);
+
+    if (c == 1)
+        *hi = *lo;
+    return c >= 1 && *lo <= *hi;
+}
+
+static inline err_t parse_args(int argc, char *argv[], options_t *opt)
+{
+    static const struct option longopts[] = {
+        {"dists",   required_argument, NULL, 'd'},
+        {"diffs",   required_argument, NULL, 'k'},
+        {"mods",    required_argument, NULL, 'm'},
+        {"bank",    required_argument, NULL, 'b'},
+        {"time",    required_argument, NULL, 't'},
+        {"threads", required_argument, NULL, 'T'},
+        {"prodmake", no_argument,      NULL, 'p'},
+        {"signed",  no_argument,       NULL, 'g'},
+        {"help",    no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int c;
+
+    opt->d_lo = 1;
+    opt->d_hi = 2;
+    opt->diffs = 3;
+    opt->m_lo = 2;
+    opt->m_hi = 8;
+    opt->b_lo = 1;
+    opt->b_hi = 12;
+    opt->time = 60;
+    opt->threads = online_cpus();
+    opt->prodmake = false;
+    opt->signed_bank = false;
+
+    while ((c = getopt_long(argc, argv, "d:k:m:b:t:T:pgh", longopts,
+                    NULL)) != -1) {
+        switch (c) {
+            case 'd':
+                if (! parse_range(optarg, &opt->d_lo, &opt->d_hi))
+                    return E_INVALID_ARGS;
+                break;
+            case 'k':
+                opt->diffs = atoi(optarg);
+                break;
+            case 'm':
+                if (! parse_range(optarg, &opt->m_lo, &opt->m_hi))
+                    return E_INVALID_ARGS;
+                break;
+            case 'b':
+                if (! parse_range(optarg, &opt->b_lo, &opt->b_hi))
+                    return E_INVALID_ARGS;
+                break;
+            case 't':
+                opt->time = atof(optarg);
+                break;
+            case 'T':
+                opt->threads = atoi(optarg);
+                break;
+            case 'p':
+                opt->prodmake = true;
+                break;
+            case 'g':
+                opt->signed_bank = true;
+                break;
+            default:
+                return E_INVALID_ARGS;
+        }
+    }
+    if (optind + 1 != argc || sscanf(argv[optind], "%d", &opt->N) != 1 ||
+            opt->N < 0 || opt->d_lo < 1 || opt->d_hi > MAX_DIST ||
+            opt->diffs < 1 || opt->diffs > MAX_DIFFS ||
+            opt->m_lo < 1 || opt->m_hi > MAX_MOD ||
+            opt->b_lo < 1 || opt->b_hi > MAX_BANK_MOD ||
+            opt->time < 0 || opt->threads < 1) {
+        fprintf(stderr, "[ERR] Invalid arguments.\n");
+        return E_INVALID_ARGS;
+    }
+    return E_SUCCESS;
+}
+
+/*******************************************************************\
+ * Rules and Products                                              *
+\*******************************************************************/
+
+static inline int plan_family(family_t *fam, const options_t *opt)
+{
+    int k = 0;
+
+    fam->num_dists = opt->d_hi - opt->d_lo + 1;
+    fam->num_masks = (1 << opt->diffs) - 1;
+    fam->num_mods = opt->m_hi - opt->m_lo + 1;
+    fam->base = malloc(fam->num_dists * fam->num_masks * fam->num_mods *
+            sizeof(int));
+    if (fam->base == NULL)
+        return -1;
+    for (int d = 0; d < fam->num_dists; d++)
+        for (int D = 0; D < fam->num_masks; D++)
+            for (int m = 0; m < fam->num_mods; m++) {
+                fam->base[(d * fam->num_masks + D) * fam->num_mods + m] = k;
+                k += opt->m_lo + m;
+            }
+    fam->num_rules = k;
+    return 0;
+}
+
+/*
+ * Is the pattern (`bits`, `numer`) of residues mod `m` periodic mod
+ * some p < m?
+ */
+static inline bool periodic(uint32_t bits, uint32_t numer, int m)
+{
+    for (int p = 1; p < m; p++) {
+        bool same = true;
+        if (m % p)
+            continue;
+        for (int i = p; same && i < m; i++)
+            same = ((bits >> i) & 1) == ((bits >> (i - p)) & 1) &&
+                ((numer >> i) & 1) == ((numer >> (i - p)) & 1);
+        if (same)
+            return true;
+    }
+    return false;
+}
+
+static inline int plan_bank(bank_t *bank, const options_t *opt)
+{
+    size_t max = 0;
+
+    if (opt->signed_bank)
+        return sweep_bank(bank, opt);
+    for (int m = opt->b_lo; m <= opt->b_hi; m++)
+        max += (size_t) 1 << m;
+    bank->num = 0;
+    bank->row = opt->N + 1;
+    bank->coefs = NULL;
+    bank->table = NULL;
+    bank->built = false;
+    if ((bank->prods = malloc(max * sizeof(product_t))) == NULL)
+        return -1;
+    for (int m = opt->b_lo; m <= opt->b_hi; m++)
+        for (uint32_t bits = 0; bits < ((uint32_t) 1 << m); bits++) {
+            /* All parts allowed is the trivial "identity". */
+            if (periodic(bits, 0, m) || (m == 1 && bits))
+                continue;
+            bank->prods[bank->num++] = (product_t) {m, bits, 0};
+        }
+    bank->coefs = malloc(bank->num * bank->row * sizeof(int64_t));
+    return bank->coefs ? 0 : -1;
+}
+
+/* Keep the product `cong[]` of the sweep if it can be a sum side. */
+static void sweep_visit(const int cong[], const qseries_t *s, int thread,
+        void *arg)
+{
+    const bank_sweep_t *sw = arg;
+    bank_part_t *part = &sw->parts[thread];
+    uint32_t allowed = 0, numer = 0;
+    size_t row = sw->N + 1;
+
+    for (int r = 0; r < sw->mod; r++) {
+        allowed |= (uint32_t) (cong[r] < 0) << r;
+        numer |= (uint32_t) (cong[r] > 0) << r;
+    }
+    if (periodic(allowed, numer, sw->mod) || (sw->mod == 1 && allowed))
+        return;
+    for (size_t n = 0; n < row; n++)
+        if (s->c[n] < 0)
+            return;
+    if (part->num == part->cap) {
+        size_t cap = part->cap ? 2 * part->cap : 256;
+        product_t *prods = realloc(part->prods, cap * sizeof(product_t));
+        int64_t *coefs = realloc(part->coefs,
+                cap * row * sizeof(int64_t));
+        if (prods)
+            part->prods = prods;
+        if (coefs)
+            part->coefs = coefs;
+        if (prods == NULL || coefs == NULL) {
+            part->err = -1;
+            return;
+        }
+        part->cap = cap;
+    }
+    part->prods[part->num] = (product_t) {sw->mod, allowed, numer};
+    memcpy(part->coefs + part->num++ * row, s->c, row * sizeof(int64_t));
+}
+
+/*
+ * Build the signed bank: for each modulus, a sweep over the threads,
+ * with the products of each thread appended in turn (so the bank is
+ * in Gray code order, whatever the number of threads).
+ */
+static inline int sweep_bank(bank_t *bank, const options_t *opt)
+{
+    bank_part_t parts[opt->threads];
+    bank_sweep_t arg;
+    qsweep_t sw;
+    int err = 0;
+
+    memset(bank, 0, sizeof(*bank));
+    bank->row = opt->N + 1;
+    bank->built = true;
+    for (int m = opt->b_lo; ! err && m <= opt->b_hi; m++) {
+        memset(parts, 0, sizeof(parts));
+        arg = (bank_sweep_t) {m, opt->N, parts};
+        qsweep_init(&sw, m, bank->row);
+        sw.threads = opt->threads;
+        sw.visit = sweep_visit;
+        sw.arg = &arg;
+        err = qsweep_run(&sw);
+        for (int t = 0; t < opt->threads; t++) {
+            size_t num = bank->num + parts[t].num;
+            product_t *prods;
+            int64_t *coefs;
+            err |= parts[t].err;
+            if (! err && parts[t].num) {
+                prods = realloc(bank->prods, num * sizeof(product_t));
+                if (prods)
+                    bank->prods = prods;
+                coefs = realloc(bank->coefs,
+                        num * bank->row * sizeof(int64_t));
+                if (coefs)
+                    bank->coefs = coefs;
+                if (prods && coefs) {
+                    memcpy(bank->prods + bank->num, parts[t].prods,
+                            parts[t].num * sizeof(product_t));
+                    memcpy(bank->coefs + bank->num * bank->row,
+                            parts[t].coefs,
+                            parts[t].num * bank->row * sizeof(int64_t));
+                    bank->num = num;
+                } else {
+                    err = -1;
+                }
+            }
+            free(parts[t].prods);
+            free(parts[t].coefs);
+        }
+    }
+    return err;
+}
+
+/*
+ * Coefficients of the product sides `p[0..num-1]` up to q^N, into
+ * the rows (of length `row`) of `coefs`, as one batch: the factor
+ * 1/(1 - q^k) is applied to all the products allowing k at once.
+ */
+static inline void product_coefs(const product_t p[], size_t num, int N,
+        int64_t coefs[], size_t row)
+{
+    qbatch_t b;
+    qseries_t c;
+    int k[num];
+
+    if (alloc_qbatch(num, N + 1, &b)) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    for (size_t j = 0; j < num; j++)
+        b.c[j] = 1;
+    for (int n = 1; n <= N; n++) {
+        for (size_t j = 0; j < num; j++)
+            k[j] = -(int) ((p[j].allowed >> (n % p[j].mod)) & 1);
+        multiply_factors_qbatch(&b, n, k);
+    }
+    c.ord = N + 1;
+    for (size_t j = 0; j < num; j++) {
+        c.c = coefs + j * row;
+        get_qbatch(&b, j, &c);
+    }
+    free_qbatch(&b);
+}
+
+/*******************************************************************\
+ * Counting                                                        *
+\*******************************************************************/
+
+/*
+ * Count the rules rejecting the (ascending) partition `p`, for its
+ * IC level v: 2 if it starts with (1,1), 1 if with (1), else 0.
+ */
+static void count_visit(const partition_t *p, void *argres)
+{
+    const worker_t *w = argres;
+    const options_t *opt = w->s->opt;
+    const family_t *fam = &w->s->fam;
+    const int *a = p->a;
+    int len = p->len, nm = fam->num_mods, diffs = opt->diffs;
+    int v = (len > 0 && a[0] == 1) ? ((len > 1 && a[1] == 1) ? 2 : 1) : 0;
+    uint64_t *rej = w->ct.rej + ((size_t) p->n * IC_NUM + v) *
+        fam->num_rules;
+    uint32_t *occ = w->ct.occ, *uni = w->ct.uni;
+
+    w->ct.icnt[p->n * IC_NUM + v]++;
+    for (int d = 0; d < fam->num_dists; d++) {
+        int dist = opt->d_lo + d;
+        uint32_t *od = occ + d * diffs * nm;
+        bool any = false;
+        memset(od, 0, diffs * nm * sizeof(uint32_t));
+        for (int i = dist; i < len; i++) {
+            int diff = a[i] - a[i-dist], s = 0;
+            if (diff >= diffs)
+                continue;
+            for (int j = i - dist; j <= i; j++)
+                s += a[j];
+            for (int m = 0; m < nm; m++)
+                od[diff * nm + m] |= 1u << (s % (opt->m_lo + m));
+            any = true;
+        }
+        if (! any)
+            continue;
+        for (int m = 0; m < nm; m++) {
+            uni[0] = 0;
+            for (int D = 1; D <= fam->num_masks; D++) {
+                uint32_t u = uni[D] = uni[D & (D - 1)] |
+                    od[__builtin_ctz(D) * nm + m];
+                uint64_t *r = rej + fam->base[(d * fam->num_masks + D - 1)
+                    * nm + m];
+                while (u) {
+                    r[__builtin_ctz(u)]++;
+                    u &= u - 1;
+                }
+            }
+        }
+    }
+}
+
+static void *run_worker(void *arg)
+{
+    worker_t *w = arg;
+    search_t *s = w->s;
+    int N = s->opt->N, n = 0;
+    size_t i;
+    int *buf;
+
+    /* The bank first: it is small and always needed. */
+    while (! s->bank.built && (i = __sync_fetch_and_add(&s->next_prod.i,
+                    BANK_BATCH)) < s->bank.num)
+        product_coefs(&s->bank.prods[i], (s->bank.num - i < BANK_BATCH) ?
+                s->bank.num - i : BANK_BATCH, N,
+                s->bank.coefs + i * s->bank.row, s->bank.row);
+
+    if ((buf = malloc(PARTN_BUFLEN(N) * sizeof(int))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    while (! s->expired && (i = __sync_fetch_and_add(&s->next_item.i, 1))
+            < s->first_item[N+1]) {
+        while (s->first_item[n+1] <= i)
+            n++;
+        gen_shard_unit(&s->plans[n], i - s->first_item[n], buf,
+                count_visit, w);
+        __sync_fetch_and_add(&s->units_done[n], 1);
+        if (s->deadline && nanotime() > s->deadline)
+            s->expired = true;
+    }
+    free(buf);
+    return NULL;
+}
+
+/*******************************************************************\
+ * Matching                                                        *
+\*******************************************************************/
+
+/* The largest n such that all the units of 0, ..., n are done. */
+static inline int done_upto(const search_t *s)
+{
+    int n = 0;
+
+    while (n <= s->opt->N && s->units_done[n] == s->plans[n].num_units)
+        n++;
+    return n - 1;
+}
+
+/* FNV-1a of the coefficients of q^0, ..., q^N. */
+static inline uint64_t hash_coefs(const int64_t c[], int N)
+{
+    uint64_t h = fnv1a(FNV1A_BASIS, c, (N + 1) * sizeof(int64_t));
+
+    return h ^ (h >> 29);
+}
+
+/* Hash the bank on the coefficients up to q^N (open addressing). */
+static inline void hash_bank(bank_t *bank, int N)
+{
+    bank->size = 1;
+    while (bank->size < 2 * bank->num)
+        bank->size <<= 1;
+    if ((bank->table = malloc(bank->size * sizeof(int64_t))) == NULL) {
+        fprintf(stderr, "[ERR] Out of memory!\n");
+        exit(E_OUT_OF_MEMORY);
+    }
+    for (size_t j = 0; j < bank->size; j++)
+        bank->table[j] = -1;
+    for (size_t i = 0; i < bank->num; i++) {
+        size_t j = hash_coefs(bank->coefs + i * bank->row, N) &
+            (bank->size - 1);
+        while (bank->table[j] >= 0)
+            j = (j + 1) & (bank->size - 1);
+        bank->table[j] = i;
+    }
+}
+
+/* Print the rule (d, D, m, r, ic) as in the comments of partnid.c. */
+static inline void print_rule(int dist, int D, int m, int r, int ic)
+{
+    static const char *ics[IC_NUM] = {"none", "(1)", "(1,1)"};
+    char diffs[64];
+    int len = 0;
+
+    for (int k = 0; D >> k; k++)
+        if ((D >> k) & 1)
+            len += snprintf(diffs + len, sizeof(diffs) - len, "%s%d",
+                    len ? ", " : "", k);
+    printf("  diff@%d = %s for sum@%d cong to %d (mod %d), IC: %s\n",
+            dist, diffs, dist + 1, r, m, ics[ic]);
+}
+
+/*
+ * Print the product side `p`: its forbidden residues, or its cong[]
+ * if it is signed.
+ */
+static inline void print_product(const product_t *p)
+{
+    bool first = true;
+
+    if (p->numer) {
+        printf("    <-> product: mod %d, cong = {", p->mod);
+        for (int i = 0; i < p->mod; i++)
+            printf("%s%d", i ? ", " : "", ((p->numer >> i) & 1) -
+                    (int) ((p->allowed >> i) & 1));
+        printf("}\n");
+        return;
+    }
+    printf("    <-> parts cong to ");
+    for (int i = 0; i < p->mod; i++)
+        if (! ((p->allowed >> i) & 1)) {
+            printf("%s%d", first ? "" : ", ", i);
+            first = false;
+        }
+    printf(" (mod %d)\n", p->mod);
+}
+
+/*
+ * The period `mod` and `cong[]` of the product form of the sum side
+ * `sum` (n = 0, ..., N), or 0 if it is not periodic (or trivial: all
+ * parts allowed).
+ */
+static inline int product_form(int64_t sum[], int N, int cong[])
+{
+    qseries_t s = {N + 1, sum};
+    int64_t a[N + 1];
+    int mod;
+
+    if (prodmake(&s, a) || (mod = prodmake_cong(N + 1, a, N, cong)) == 0
+            || (mod == 1 && cong[0] == -1))
+        return 0;
+    return mod;
+}
+
+/*
+ * Look up the sum side of every rule, for n = 0, ..., N, in the bank
+ * and print the matches (and, with --prodmake, the periodic product
+ * forms of the others).  Returns the number of matches.
+ */
+static inline size_t report_matches(const search_t *s,
+        const worker_t *w, int N)
+{
+    /* IC levels v of the partitions allowed by each IC. */
+    static const bool ic_allows[IC_NUM][IC_NUM] = {
+        {true, true, true}, {true, false, false}, {true, true, false},
+    };
+    const options_t *opt = s->opt;
+    const family_t *fam = &s->fam;
+    const bank_t *bank = &s->bank;
+    const uint64_t *rej = w->ct.rej, *icnt = w->ct.icnt;
+    int64_t sum[N + 1];
+    size_t matches = 0;
+
+    printf("Forbidden (sum side)\n    <-> Forbidden (product side)\n");
+    for (int i = 0; i < 44; i++)
+        printf("=");
+    printf("\n");
+    for (int d = 0; d < fam->num_dists; d++)
+    for (int D = 0; D < fam->num_masks; D++)
+    for (int m = 0; m < fam->num_mods; m++)
+    for (int r = 0; r < opt->m_lo + m; r++)
+    for (int ic = 0; ic < IC_NUM; ic++) {
+        int rule = fam->base[(d * fam->num_masks + D) * fam->num_mods + m]
+            + r;
+        size_t j, found = matches;
+        int cong[N + 1], mod;
+        for (int n = 0; n <= N; n++) {
+            sum[n] = 0;
+            for (int v = 0; v < IC_NUM; v++)
+                if (ic_allows[ic][v])
+                    sum[n] += icnt[n * IC_NUM + v] - rej[((size_t) n *
+                            IC_NUM + v) * fam->num_rules + rule];
+        }
+        j = hash_coefs(sum, N) & (bank->size - 1);
+        for (; bank->table[j] >= 0; j = (j + 1) & (bank->size - 1)) {
+            const product_t *p = &bank->prods[bank->table[j]];
+            if (memcmp(sum, bank->coefs + bank->table[j] * bank->row,
+                        (N + 1) * sizeof(int64_t)))
+                continue;
+            print_rule(opt->d_lo + d, D + 1, opt->m_lo + m, r, ic);
+            print_product(p);
+            matches++;
+        }
+        if (opt->prodmake && matches == found &&
+                (mod = product_form(sum, N, cong))) {
+            print_rule(opt->d_lo + d, D + 1, opt->m_lo + m, r, ic);
+            printf("    <-> product form (prodmake): mod %d, cong = {",
+                    mod);
+            for (int k = 0; k < mod; k++)
+                printf("%s%d", k ? ", " : "", cong[k]);
+            printf("}\n");
+            matches++;
+        }
+    }
+    return matches;
+}
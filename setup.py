@@ -0,0 +1,29 @@
+# Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+# Created:  2026-10-18
+# Modified: 2026-10-18
+# License:  MIT License (See LICENSE.txt)
+#
+# Build the `cpartition` Python extension (see partitionmodule.c):
+#
+#   python3 setup.py build_ext --inplace     #(or, make python)
+
+from setuptools import setup, Extension
+import numpy
+
+cpartition = Extension(
+    'cpartition',
+    sources=['partitionmodule.c', 'partition.c'],
+    include_dirs=['.', numpy.get_include()],
+    extra_compile_args=['-std=gnu11', '-O3'],
+    libraries=['pthread'],
+)
+
+setup(
+    name='cpartition',
+    version='0.1',
+    description='Fast integer partition generators (C, NumPy batches)',
+    author='Debajyoti Nandi',
+    author_email='debajyoti.nandi@gmail.com',
+    license='MIT',
+    ext_modules=[cpartition],
+)
@@ -0,0 +1,486 @@
+/*
+ * shard.c - Sharded enumeration of partitions.
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   CC = gcc #( or clang)
+ *   CFLAGS = -std=gnu11 -O3 #(or, -O2)
+ *   $(CC) $(CFLAGS) -c shard.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "shard.h"
+
+/* Units per shard aimed at by the planner (for balance). */
+#define SHARD_UNITS_PER_SHARD 64
+
+/* Version of the result file format. */
+#define SHARD_FORMAT 1
+
+/*******************************************************************\
+ *  Shard Plan                                                     *
+\*******************************************************************/
+
+/* State of the planner. */
+typedef struct {
+    int n;
+    double *cnt;        /* cnt[m*(n+2) + lo]: p(m, parts >= lo) */
+    double limit;       /* Largest unit (unless it is a leaf). */
+    int *prefix;        /* Current prefix. */
+    size_t plen;
+    shard_plan_t *plan;
+    size_t cap_units;
+    size_t cap_pool;
+    size_t len_pool;
+} planner_t;
+
+static inline double count_at(const planner_t *pl, int m, int lo)
+{
+    return pl->cnt[(size_t) m * (pl->n + 2) + lo];
+}
+
+/* Fill the table of the numbers of partitions of m into parts >= lo. */
+static inline void count_table(planner_t *pl)
+{
+    int n = pl->n;
+    size_t w = n + 2;
+
+    for (int lo = 1; lo <= n + 1; lo++)
+        pl->cnt[lo] = 1;
+    for (int m = 1; m <= n; m++) {
+        pl->cnt[m*w + m + 1] = 0;
+        for (int lo = m; lo >= 1; lo--)
+            pl->cnt[m*w + lo] = pl->cnt[m*w + lo + 1]
+                + pl->cnt[(m - lo)*w + lo];
+        for (int lo = m + 2; lo <= n + 1; lo++)
+            pl->cnt[m*w + lo] = 0;
+    }
+}
+
+/* Append the current prefix, extended by `last` if > 0, as a unit. */
+static int add_unit(planner_t *pl, int last, int lo, double weight)
+{
+    shard_plan_t *plan = pl->plan;
+    size_t plen = pl->plen + (last > 0);
+    shard_unit_t *u;
+    void *tmp;
+
+    if (plan->num_units == pl->cap_units) {
+        pl->cap_units = pl->cap_units ? 2 * pl->cap_units : 1024;
+        tmp = realloc(plan->units, pl->cap_units * sizeof(shard_unit_t));
+        if (tmp == NULL)
+            return -1;
+        plan->units = tmp;
+    }
+    if (pl->len_pool + plen > pl->cap_pool) {
+        pl->cap_pool = 2 * (pl->len_pool + plen) + 1024;
+        tmp = realloc(plan->pool, pl->cap_pool * sizeof(int));
+        if (tmp == NULL)
+            return -1;
+        plan->pool = tmp;
+    }
+    u = &plan->units[plan->num_units++];
+    u->prefix = pl->len_pool;
+    u->plen = plen;
+    u->lo = lo;
+    u->weight = weight;
+    if (pl->plen)
+        memcpy(plan->pool + pl->len_pool, pl->prefix,
+                pl->plen * sizeof(int));
+    if (last > 0)
+        plan->pool[pl->len_pool + pl->plen] = last;
+    pl->len_pool += plen;
+    plan->total += weight;
+    return 0;
+}
+
+/*
+ * Cut the subtree of the current prefix (remainder `m`, next part
+ * `>= lo`) into units, in lexicographic order.
+ */
+static int expand(planner_t *pl, int m, int lo)
+{
+    double weight = count_at(pl, m, lo);
+
+    if (m == 0 || weight <= pl->limit)
+        return add_unit(pl, 0, lo, weight);
+    for (int x = lo; 2*x <= m; x++) {
+        pl->prefix[pl->plen++] = x;
+        if (expand(pl, m - x, x))
+            return -1;
+        pl->plen--;
+    }
+    /* The last child is the prefix completed by the part `m`. */
+    return add_unit(pl, m, m, 1);
+}
+
+int plan_shards(shard_plan_t *plan, int n, int k)
+{
+    planner_t pl;
+    int err;
+
+    plan->n = n;
+    plan->num_units = 0;
+    plan->units = NULL;
+    plan->pool = NULL;
+    plan->total = 0;
+    if (n < 0)
+        return 0;
+    if (k < 1)
+        k = 1;
+    pl.n = n;
+    pl.plan = plan;
+    pl.plen = 0;
+    pl.cap_units = 0;
+    pl.cap_pool = 0;
+    pl.len_pool = 0;
+    pl.cnt = malloc((size_t) (n + 1) * (n + 2) * sizeof(double));
+    pl.prefix = malloc(PARTN_BUFLEN(n) * sizeof(int));
+    if (pl.cnt == NULL || pl.prefix == NULL) {
+        free(pl.cnt);
+        free(pl.prefix);
+        return -1;
+    }
+    count_table(&pl);
+    pl.limit = count_at(&pl, n, 1) / ((double) k * SHARD_UNITS_PER_SHARD);
+    if (pl.limit < 1)
+        pl.limit = 1;
+    err = expand(&pl, n, 1);
+    free(pl.cnt);
+    free(pl.prefix);
+    if (err) {
+        free_shard_plan(plan);
+        return -1;
+    }
+    return 0;
+}
+
+void free_shard_plan(shard_plan_t *plan)
+{
+    free(plan->units);
+    free(plan->pool);
+    plan->units = NULL;
+    plan->pool = NULL;
+    plan->num_units = 0;
+}
+
+/*
+ * The first unit of shard `i`: the first one whose middle lies at or
+ * after the fraction i/k of all the partitions.
+ */
+static size_t shard_start(const shard_plan_t *plan, int i, int k)
+{
+    double target = plan->total * i / k;
+    double cum = 0;
+    size_t u;
+
+    if (i <= 0)
+        return 0;
+    if (i >= k)
+        return plan->num_units;
+    for (u = 0; u < plan->num_units; u++) {
+        if (cum + plan->units[u].weight / 2 >= target)
+            break;
+        cum += plan->units[u].weight;
+    }
+    return u;
+}
+
+void shard_range(const shard_plan_t *plan, int i, int k,
+        size_t *first, size_t *last)
+{
+    *first = shard_start(plan, i, k);
+    *last = shard_start(plan, i + 1, k);
+}
+
+uint64_t gen_shard_unit(const shard_plan_t *plan, size_t u, int buf[],
+        partn_visitor_f *visit, void *argres)
+{
+    const shard_unit_t *unit = &plan->units[u];
+
+    return accel_asc_subtree(plan->n, plan->pool + unit->prefix,
+            unit->plen, unit->lo, buf, visit, argres);
+}
+
+bool parse_shard(const char *spec, int *i, int *k)
+{
+    int len = 0;
+
+    if (sscanf(spec, "%d/%d%n", i, k, &len) != 2 || spec[len] != '\0')
+        return false;
+    return *k >= 1 && *i >= 0 && *i < *k;
+}
+
+
+/*******************************************************************\
+ *  Results                                                        *
+\*******************************************************************/
+
+uint64_t partn_fingerprint(const partition_t *p)
+{
+    /* FNV-1a over the parts, then the splitmix64 finalizer. */
+    uint64_t h = 0xcbf29ce484222325ULL ^ p->len;
+
+    for (size_t i = 0; i < p->len; i++)
+        h = (h ^ (uint64_t) p->a[i]) * 0x100000001b3ULL;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+int alloc_shard_result(shard_result_t *res, const char *program,
+        int shard, int shards, size_t num_rows)
+{
+    snprintf(res->program, sizeof(res->program), "%s", program);
+    res->shard = shard;
+    res->shards = shards;
+    res->num_rows = num_rows;
+    res->rows = calloc(num_rows ? num_rows : 1, sizeof(shard_row_t));
+    return (res->rows == NULL) ? -1 : 0;
+}
+
+void free_shard_result(shard_result_t *res)
+{
+    free(res->rows);
+    res->rows = NULL;
+    res->num_rows = 0;
+}
+
+int write_shard_result(const char *path, const shard_result_t *res)
+{
+    char tmp[4096];
+    FILE *fp;
+    int err = 0;
+
+    /* Write a temporary file and rename it, so that a result file
+     * that exists is complete. */
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int) sizeof(tmp))
+        return -1;
+    if ((fp = fopen(tmp, "w")) == NULL)
+        return -1;
+    fprintf(fp, "partn-shard %d\n", SHARD_FORMAT);
+    fprintf(fp, "program %s\n", res->program);
+    if (res->shard < 0)
+        fprintf(fp, "shard merged/%d\n", res->shards);
+    else
+        fprintf(fp, "shard %d/%d\n", res->shard, res->shards);
+    for (size_t r = 0; r < res->num_rows; r++) {
+        const shard_row_t *row = &res->rows[r];
+        fprintf(fp, "row %d %zu %zu %zu %" PRIu64 " %" PRId64
+                " %016" PRIx64 "\n", row->n, row->first, row->last,
+                row->total, row->count, row->sum, row->fingerprint);
+    }
+    fprintf(fp, "end\n");
+    if (ferror(fp))
+        err = -1;
+    if (fclose(fp))
+        err = -1;
+    if (err || rename(tmp, path)) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int read_shard_result(const char *path, shard_result_t *res)
+{
+    char line[512], word[32];
+    size_t cap = 0, lineno = 0;
+    bool ended = false;
+    int version;
+    FILE *fp;
+    void *tmp;
+
+    memset(res, 0, sizeof(*res));
+    res->shard = -2;
+    if ((fp = fopen(path, "r")) == NULL) {
+        fprintf(stderr, "[ERR] %s: cannot open!\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        shard_row_t row;
+
+        lineno++;
+        if (lineno == 1) {
+            if (sscanf(line, "partn-shard %d", &version) != 1 ||
+                    version != SHARD_FORMAT)
+                goto malformed;
+        } else if (ended) {
+            goto malformed;
+        } else if (strncmp(line, "program ", 8) == 0) {
+            if (sscanf(line + 8, "%31s", res->program) != 1)
+                goto malformed;
+        } else if (strncmp(line, "shard merged/", 13) == 0) {
+            res->shard = -1;
+            if (sscanf(line + 13, "%d", &res->shards) != 1)
+                goto malformed;
+        } else if (strncmp(line, "shard ", 6) == 0) {
+            if (sscanf(line + 6, "%d/%d", &res->shard, &res->shards) != 2
+                    || res->shard < 0 || res->shard >= res->shards)
+                goto malformed;
+        } else if (strncmp(line, "row ", 4) == 0) {
+            if (sscanf(line + 4, "%d %zu %zu %zu %" SCNu64 " %" SCNd64
+                        " %" SCNx64, &row.n, &row.first, &row.last,
+                        &row.total, &row.count, &row.sum,
+                        &row.fingerprint) != 7 ||
+                    row.first > row.last || row.last > row.total)
+                goto malformed;
+            if (res->num_rows == cap) {
+                cap = cap ? 2 * cap : 64;
+                if ((tmp = realloc(res->rows,
+                                cap * sizeof(shard_row_t))) == NULL) {
+                    fprintf(stderr, "[ERR] %s: out of memory!\n", path);
+                    goto fail;
+                }
+                res->rows = tmp;
+            }
+            res->rows[res->num_rows++] = row;
+        } else if (sscanf(line, "%31s", word) == 1 &&
+                strcmp(word, "end") == 0) {
+            ended = true;
+        } else {
+            goto malformed;
+        }
+    }
+    if (! ended || res->program[0] == '\0' || res->shard < -1) {
+        fprintf(stderr, "[ERR] %s: incomplete result file!\n", path);
+        goto fail;
+    }
+    fclose(fp);
+    return 0;
+
+malformed:
+    fprintf(stderr, "[ERR] %s:%zu: malformed line!\n", path, lineno);
+fail:
+    fclose(fp);
+    free_shard_result(res);
+    return -1;
+}
+
+static int cmp_rows(const void *x, const void *y)
+{
+    const shard_row_t *r = x, *s = y;
+
+    if (r->n != s->n)
+        return (r->n < s->n) ? -1 : 1;
+    if (r->first != s->first)
+        return (r->first < s->first) ? -1 : 1;
+    return (r->last < s->last) ? -1 : (r->last > s->last);
+}
+
+/* Is there a row for `n` in `res`? */
+static bool has_row(const shard_result_t *res, int n)
+{
+    for (size_t r = 0; r < res->num_rows; r++)
+        if (res->rows[r].n == n)
+            return true;
+    return false;
+}
+
+shard_merge_t merge_shard_results(const shard_result_t res[], size_t num,
+        shard_result_t *out)
+{
+    shard_row_t *all, *row, *cur = NULL;
+    size_t total = 0, a = 0;
+    shard_merge_t status = SHARD_MERGE_COMPLETE;
+
+    for (size_t f = 0; f < num; f++) {
+        if (strcmp(res[f].program, res[0].program) ||
+                res[f].shards != res[0].shards) {
+            fprintf(stderr, "[ERR] Results of different runs "
+                    "(%s with %d shards and %s with %d shards)!\n",
+                    res[0].program, res[0].shards,
+                    res[f].program, res[f].shards);
+            return SHARD_MERGE_MISMATCH;
+        }
+        for (size_t r = 0; r < res[f].num_rows; r++) {
+            for (size_t g = 0; g < num; g++) {
+                if (! has_row(&res[g], res[f].rows[r].n)) {
+                    fprintf(stderr, "[ERR] Results for different N "
+                            "(N = %d is missing in one)!\n",
+                            res[f].rows[r].n);
+                    return SHARD_MERGE_MISMATCH;
+                }
+            }
+        }
+        total += res[f].num_rows;
+    }
+    if ((all = malloc((total ? total : 1) * sizeof(shard_row_t))) == NULL)
+        return SHARD_MERGE_NOMEM;
+    for (size_t f = 0; f < num; f++)
+        for (size_t r = 0; r < res[f].num_rows; r++)
+            all[a++] = res[f].rows[r];
+    qsort(all, total, sizeof(shard_row_t), cmp_rows);
+    if (alloc_shard_result(out, num ? res[0].program : "",
+                -1, num ? res[0].shards : 1, total)) {
+        free(all);
+        return SHARD_MERGE_NOMEM;
+    }
+    out->num_rows = 0;
+    for (size_t r = 0; r < total; r++) {
+        row = &all[r];
+        if (cur && cur->n == row->n) {
+            if (cur->total != row->total) {
+                fprintf(stderr, "[ERR] Different plans for N = %d!\n",
+                        row->n);
+                status = SHARD_MERGE_MISMATCH;
+                break;
+            }
+            if (row->first == row->last)
+                continue;
+            if (cur->first == cur->last) {
+                *cur = *row;
+                continue;
+            }
+            if (row->first < cur->last) {
+                fprintf(stderr, "[ERR] Units %zu to %zu of N = %d are "
+                        "covered more than once!\n", row->first,
+                        (row->last < cur->last ? row->last : cur->last) - 1,
+                        row->n);
+                status = SHARD_MERGE_OVERLAP;
+                break;
+            }
+            if (row->first == cur->last) {
+                cur->last = row->last;
+                cur->count += row->count;
+                cur->sum += row->sum;
+                cur->fingerprint += row->fingerprint;
+                continue;
+            }
+        }
+        cur = &out->rows[out->num_rows++];
+        *cur = *row;
+    }
+    free(all);
+    if (status != SHARD_MERGE_COMPLETE) {
+        free_shard_result(out);
+        return status;
+    }
+    /* Look for gaps. */
+    for (size_t r = 0; r < out->num_rows; r++) {
+        row = &out->rows[r];
+        bool first_of_n = (r == 0 || out->rows[r-1].n != row->n);
+        bool last_of_n = (r + 1 == out->num_rows ||
+                out->rows[r+1].n != row->n);
+        size_t gap_lo = first_of_n ? 0 : out->rows[r-1].last;
+
+        if (row->first > gap_lo) {
+            fprintf(stderr, "[WARN] Units %zu to %zu of N = %d are "
+                    "missing.\n", gap_lo, row->first - 1, row->n);
+            status = SHARD_MERGE_PARTIAL;
+        }
+        if (last_of_n && row->last < row->total) {
+            fprintf(stderr, "[WARN] Units %zu to %zu of N = %d are "
+                    "missing.\n", row->last, row->total - 1, row->n);
+            status = SHARD_MERGE_PARTIAL;
+        }
+    }
+    return status;
+}
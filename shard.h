@@ -0,0 +1,158 @@
+/*
+ * shard.h - Sharded enumeration of partitions (header file).
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * The (ascending) partitions of n form a tree: the children of a
+ * prefix a[0] <= ... <= a[j-1] are its extensions by one part.  The
+ * shard planner cuts this tree into "units" (subtrees, given by a
+ * prefix and the least allowed next part) small enough for balancing,
+ * lists them in lexicographic order, and gives shard i of k a
+ * contiguous range of units of about 1/k of the partitions.  The plan
+ * depends only on n and k, so separate processes (or machines) agree
+ * on it without talking to each other.
+ *
+ * Each shard writes a result file with, for every n it covered, the
+ * range of units, the number of partitions visited, a sum (e.g. the
+ * sum side of an identity) and an order independent fingerprint of
+ * the partitions counted in the sum.  Result files are merged by
+ * adding up these numbers; `partnmerge` does that and checks that the
+ * shards together cover every unit exactly once.
+ *
+ * Result file format (text, one record per line):
+ *
+ *   partn-shard 1
+ *   program NAME
+ *   shard I/K               (or: shard merged/K)
+ *   row N FIRST LAST TOTAL COUNT SUM FINGERPRINT
+ *   ...
+ *   end
+ *
+ * where a row covers units FIRST, ..., LAST-1 of the TOTAL units of
+ * the plan for N (FINGERPRINT in hex).  A merged file (of K shards)
+ * has "shard merged/K", and one row [0, TOTAL) for each N if it is
+ * complete.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "partition.h"
+
+/*******************************************************************\
+ *  Shard Plan                                                     *
+\*******************************************************************/
+
+/*
+ * A unit: the partitions of `n` starting with `plen` parts stored at
+ * `prefix` in the plan's pool, continued by parts `>= lo`.
+ */
+typedef struct {
+    size_t prefix;      /* Offset in `shard_plan_t.pool`. */
+    size_t plen;
+    int lo;
+    double weight;      /* Number of partitions (approx. if huge). */
+} shard_unit_t;
+
+/* Plan of the units for the partitions of `n`. */
+typedef struct {
+    int n;
+    size_t num_units;
+    shard_unit_t *units;    /* In lexicographic order. */
+    int *pool;              /* Prefixes. */
+    double total;           /* p(n) (approximate if huge). */
+} shard_plan_t;
+
+/*
+ * Cut the partitions of `n` into units for (up to) `k` shards.
+ * Returns 0 on success, -1 if out of memory.
+ */
+int plan_shards(shard_plan_t *plan, int n, int k);
+
+/* Free a plan. */
+void free_shard_plan(shard_plan_t *plan);
+
+/* The units [*first, *last) of shard `i` (0 <= i < k) of `k`. */
+void shard_range(const shard_plan_t *plan, int i, int k,
+        size_t *first, size_t *last);
+
+/*
+ * Generate the partitions of unit `u` (ascending, in the order of
+ * accel_asc).  `buf` as for the generators in partition.h.
+ */
+uint64_t gen_shard_unit(const shard_plan_t *plan, size_t u, int buf[],
+        partn_visitor_f *visit, void *argres);
+
+/*
+ * Parse a shard spec "I/K" (0 <= I < K).  Returns false if it is
+ * malformed.
+ */
+bool parse_shard(const char *spec, int *i, int *k);
+
+
+/*******************************************************************\
+ *  Results                                                        *
+\*******************************************************************/
+
+/* Results for the units [first, last) of the plan for `n`. */
+typedef struct {
+    int n;
+    size_t first, last, total;
+    uint64_t count;         /* Partitions visited. */
+    int64_t sum;            /* E.g. the sum side at n. */
+    uint64_t fingerprint;   /* Sum of partn_fingerprint over `sum`. */
+} shard_row_t;
+
+/* The results of a shard (or of merged shards). */
+typedef struct {
+    char program[32];
+    int shard, shards;
+    size_t num_rows;
+    shard_row_t *rows;
+} shard_result_t;
+
+/*
+ * An order independent fingerprint of a set of partitions is the sum
+ * (mod 2^64) of this hash of each of its (ascending) partitions.
+ */
+uint64_t partn_fingerprint(const partition_t *p);
+
+/*
+ * Initialize `res` with room for `num_rows` rows.  Returns 0 on
+ * success, -1 if out of memory.
+ */
+int alloc_shard_result(shard_result_t *res, const char *program,
+        int shard, int shards, size_t num_rows);
+
+/* Free a result. */
+void free_shard_result(shard_result_t *res);
+
+/* Write a result file.  Returns 0 on success, -1 on I/O errors. */
+int write_shard_result(const char *path, const shard_result_t *res);
+
+/*
+ * Read a result file.  Returns 0 on success, -1 if it cannot be read
+ * or is malformed (with a message on stderr).
+ */
+int read_shard_result(const char *path, shard_result_t *res);
+
+/* Outcome of a merge. */
+typedef enum {
+    SHARD_MERGE_COMPLETE,   /* Every unit covered exactly once. */
+    SHARD_MERGE_PARTIAL,    /* Some units are missing. */
+    SHARD_MERGE_OVERLAP,    /* Some units are covered twice. */
+    SHARD_MERGE_MISMATCH,   /* Different programs or plans. */
+    SHARD_MERGE_NOMEM,
+} shard_merge_t;
+
+/*
+ * Merge `num` results into `out` (adjacent ranges are coalesced).
+ * Problems are described on stderr.
+ */
+shard_merge_t merge_shard_results(const shard_result_t res[], size_t num,
+        shard_result_t *out);
@@ -0,0 +1,234 @@
+/*
+ * stats.c - Statistics of partitions.
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   CC = gcc #( or clang)
+ *   CFLAGS = -std=gnu11 -O3 #(or, -O2)
+ *   $(CC) $(CFLAGS) -c stats.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include "shard.h"
+#include "stats.h"
+#include "util.h"
+
+const char *pstat_names[PSTAT_NUM] = {
+    "parts", "largest", "distinct", "mult", "sizes", "durfee",
+};
+
+bool parse_pstat_kinds(const char *list, unsigned *kinds)
+{
+    const char *s = list;
+    size_t len;
+    int k;
+
+    *kinds = 0;
+    while (*s) {
+        len = strcspn(s, ",");
+        if (len == 3 && strncmp(s, "all", 3) == 0) {
+            *kinds |= PSTAT_ALL;
+        } else {
+            for (k = 0; k < PSTAT_NUM; k++)
+                if (strlen(pstat_names[k]) == len &&
+                        strncmp(s, pstat_names[k], len) == 0)
+                    break;
+            if (k == PSTAT_NUM)
+                return false;
+            *kinds |= 1u << k;
+        }
+        s += len;
+        if (*s == ',')
+            s++;
+    }
+    return *kinds != 0;
+}
+
+int alloc_partn_stats(partn_stats_t *st, int n, unsigned kinds)
+{
+    /* Whole cache lines, so that no two threads' histograms share
+     * one. */
+    size_t size = ((n + 1) * sizeof(uint64_t) + CACHE_LINE - 1)
+        / CACHE_LINE * CACHE_LINE;
+
+    st->n = n;
+    st->kinds = kinds;
+    st->count = 0;
+    /* All NULL first, so that a failure frees only what was got. */
+    for (int s = 0; s < PSTAT_NUM; s++)
+        st->hist[s] = NULL;
+    for (int s = 0; s < PSTAT_NUM; s++) {
+        if (! (kinds & (1u << s)))
+            continue;
+        if ((st->hist[s] = aligned_alloc(CACHE_LINE, size)) == NULL) {
+            free_partn_stats(st);
+            return -1;
+        }
+        memset(st->hist[s], 0, size);
+    }
+    return 0;
+}
+
+void free_partn_stats(partn_stats_t *st)
+{
+    for (int s = 0; s < PSTAT_NUM; s++) {
+        free(st->hist[s]);
+        st->hist[s] = NULL;
+    }
+}
+
+void partn_stats_visit(const partition_t *p, void *argres)
+{
+    partn_stats_t *st = argres;
+    const int *a = p->a;
+    int len = p->len;
+    unsigned kinds = st->kinds;
+
+    st->count++;
+    if (kinds & (1u << PSTAT_PARTS))
+        st->hist[PSTAT_PARTS][len]++;
+    if (kinds & (1u << PSTAT_LARGEST))
+        st->hist[PSTAT_LARGEST][len ? a[len-1] : 0]++;
+    if (kinds & ((1u << PSTAT_DISTINCT) | (1u << PSTAT_MULT) |
+                (1u << PSTAT_SIZES))) {
+        uint64_t *mult = st->hist[PSTAT_MULT];
+        uint64_t *sizes = st->hist[PSTAT_SIZES];
+        int d = 0;
+        for (int i = 0, j; i < len; i = j) {
+            for (j = i + 1; j < len && a[j] == a[i]; j++)
+                ;
+            d++;
+            if (mult)
+                mult[j - i]++;
+            if (sizes)
+                sizes[a[i]] += j - i;
+        }
+        if (kinds & (1u << PSTAT_DISTINCT))
+            st->hist[PSTAT_DISTINCT][d]++;
+    }
+    if (kinds & (1u << PSTAT_DURFEE)) {
+        /* Largest d with d parts >= d (the parts are ascending). */
+        int d = 0;
+        while (d < len && a[len-1-d] > d)
+            d++;
+        st->hist[PSTAT_DURFEE][d]++;
+    }
+}
+
+void merge_partn_stats(partn_stats_t *into, const partn_stats_t *from)
+{
+    into->count += from->count;
+    for (int s = 0; s < PSTAT_NUM; s++)
+        if (into->hist[s] && from->hist[s])
+            for (int k = 0; k <= into->n; k++)
+                into->hist[s][k] += from->hist[s][k];
+}
+
+void print_partn_stats(const partn_stats_t *st)
+{
+    printf("  %4s", "k");
+    for (int s = 0; s < PSTAT_NUM; s++)
+        if (st->hist[s])
+            printf(" %16s", pstat_names[s]);
+    printf("\n");
+    for (int k = 0; k <= st->n; k++) {
+        bool nonzero = false;
+        for (int s = 0; s < PSTAT_NUM; s++)
+            if (st->hist[s] && st->hist[s][k])
+                nonzero = true;
+        if (! nonzero)
+            continue;
+        printf("  %4d", k);
+        for (int s = 0; s < PSTAT_NUM; s++)
+            if (st->hist[s])
+                printf(" %16" PRIu64, st->hist[s][k]);
+        printf("\n");
+    }
+}
+
+
+/*******************************************************************\
+ *  Threads                                                        *
+\*******************************************************************/
+
+/* Accumulator of a thread (its own cache lines). */
+typedef struct {
+    partn_stats_t st;
+    pthread_t thread;
+    const shard_plan_t *plan;
+    size_t *next;
+    bool nomem;
+} __attribute__((aligned(CACHE_LINE))) stats_slot_t;
+
+static void *stats_thread(void *arg)
+{
+    stats_slot_t *slot = arg;
+    const shard_plan_t *plan = slot->plan;
+    size_t u;
+    int *buf;
+
+    if ((buf = malloc(PARTN_BUFLEN(plan->n) * sizeof(int))) == NULL) {
+        slot->nomem = true;
+        return NULL;
+    }
+    while ((u = __sync_fetch_and_add(slot->next, 1)) < plan->num_units)
+        gen_shard_unit(plan, u, buf, partn_stats_visit, &slot->st);
+    free(buf);
+    return NULL;
+}
+
+int partn_stats(int n, unsigned kinds, int threads, partn_stats_t *st)
+{
+    shard_plan_t plan;
+    stats_slot_t *slots;
+    size_t next = 0;
+    int started = 0, err = 0;
+
+    if (threads < 1)
+        threads = 1;
+    if (alloc_partn_stats(st, n, kinds))
+        return -1;
+    if (plan_shards(&plan, n, threads)) {
+        free_partn_stats(st);
+        return -1;
+    }
+    slots = aligned_alloc(CACHE_LINE, threads * sizeof(stats_slot_t));
+    if (slots == NULL) {
+        free_shard_plan(&plan);
+        free_partn_stats(st);
+        return -1;
+    }
+    for (int t = 0; t < threads; t++) {
+        slots[t].plan = &plan;
+        slots[t].next = &next;
+        slots[t].nomem = false;
+        if (alloc_partn_stats(&slots[t].st, n, kinds) ||
+                pthread_create(&slots[t].thread, NULL, stats_thread,
+                    &slots[t])) {
+            free_partn_stats(&slots[t].st);
+            err = -1;
+            break;
+        }
+        started++;
+    }
+    for (int t = 0; t < started; t++) {
+        pthread_join(slots[t].thread, NULL);
+        if (slots[t].nomem)
+            err = -1;
+        merge_partn_stats(st, &slots[t].st);
+        free_partn_stats(&slots[t].st);
+    }
+    free(slots);
+    free_shard_plan(&plan);
+    if (err)
+        free_partn_stats(st);
+    return err;
+}
@@ -0,0 +1,78 @@
+/*
+ * stats.h - Statistics of partitions (header file).
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Histograms over all the partitions of n, computed while they are
+ * generated.  `partn_stats` spreads the units of the shard planner
+ * (see shard.h) over threads; each thread updates its own histograms
+ * (cache-line aligned, so that threads never share a line) and they
+ * are added up at the end.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "partition.h"
+
+/* The statistics (histograms indexed by k = 0, ..., n). */
+typedef enum {
+    PSTAT_PARTS,        /* Partitions with k parts. */
+    PSTAT_LARGEST,      /* Partitions with largest part k. */
+    PSTAT_DISTINCT,     /* Partitions with k distinct parts. */
+    PSTAT_MULT,         /* Distinct parts occurring k times. */
+    PSTAT_SIZES,        /* Occurrences of the part k. */
+    PSTAT_DURFEE,       /* Partitions with a Durfee square of side k. */
+    PSTAT_NUM,
+} pstat_t;
+
+#define PSTAT_ALL ((1u << PSTAT_NUM) - 1)
+
+/* Names of the statistics (indexed by `pstat_t`). */
+extern const char *pstat_names[PSTAT_NUM];
+
+/* Histograms of the selected statistics of partitions of `n`. */
+typedef struct {
+    int n;
+    unsigned kinds;             /* Bit `1u << s` selects statistic s. */
+    uint64_t count;             /* Partitions visited. */
+    uint64_t *hist[PSTAT_NUM];  /* NULL if not selected. */
+} partn_stats_t;
+
+/*
+ * Parse a comma separated list of names of statistics (or "all")
+ * into `*kinds`.  Returns false if a name is unknown.
+ */
+bool parse_pstat_kinds(const char *list, unsigned *kinds);
+
+/*
+ * Allocate (zeroed) histograms.  Returns 0 on success, -1 if out of
+ * memory.
+ */
+int alloc_partn_stats(partn_stats_t *st, int n, unsigned kinds);
+
+/* Free the histograms. */
+void free_partn_stats(partn_stats_t *st);
+
+/*
+ * Visitor adding an (ascending) partition to the `partn_stats_t`
+ * passed as `argres`.
+ */
+void partn_stats_visit(const partition_t *p, void *argres);
+
+/* Add the histograms of `from` to those of `into`. */
+void merge_partn_stats(partn_stats_t *into, const partn_stats_t *from);
+
+/* Print the histograms as a table (rows with all zeros omitted). */
+void print_partn_stats(const partn_stats_t *st);
+
+/*
+ * Compute the statistics `kinds` of all the partitions of `n` with
+ * `threads` threads into `st` (allocated here).  Returns 0 on
+ * success, -1 if out of memory or a thread could not be started.
+ */
+int partn_stats(int n, unsigned kinds, int threads, partn_stats_t *st);
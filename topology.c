@@ -0,0 +1,141 @@
+/*
+ * topology.c - CPU topology and thread pinning.
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   CC = gcc #( or clang)
+ *   CFLAGS = -std=gnu11 -O3 #(or, -O2)
+ *   $(CC) $(CFLAGS) -c topology.c
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE     /* sched_getaffinity, pthread_setaffinity_np */
+#include <sched.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "topology.h"
+
+int online_cpus(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (n < 1) ? 1 : (int) n;
+}
+
+/* Read an integer from /sys/devices/system/cpu/cpuCPU/topology/NAME. */
+static int read_topo_id(int cpu, const char *name)
+{
+    char path[128];
+    FILE *fp;
+    int id = 0;
+
+    snprintf(path, sizeof(path),
+            "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    if ((fp = fopen(path, "r")) == NULL)
+        return 0;
+    if (fscanf(fp, "%d", &id) != 1)
+        id = 0;
+    fclose(fp);
+    return id;
+}
+
+static int cmp_cpus(const void *x, const void *y)
+{
+    const topo_cpu_t *a = x, *b = y;
+
+    if (a->socket != b->socket)
+        return (a->socket < b->socket) ? -1 : 1;
+    if (a->smt != b->smt)
+        return (a->smt < b->smt) ? -1 : 1;
+    if (a->core != b->core)
+        return (a->core < b->core) ? -1 : 1;
+    return (a->cpu > b->cpu) - (a->cpu < b->cpu);
+}
+
+int read_topology(topology_t *topo)
+{
+    size_t num = 0;
+    int max = online_cpus();
+    int *sockets;
+
+#ifdef __linux__
+    cpu_set_t mask;
+    bool have_mask = sched_getaffinity(0, sizeof(mask), &mask) == 0;
+
+    if (have_mask)
+        max = CPU_SETSIZE;
+#endif
+    topo->cpus = malloc(max * sizeof(topo_cpu_t));
+    sockets = malloc(max * sizeof(int));
+    if (topo->cpus == NULL || sockets == NULL) {
+        free(topo->cpus);
+        free(sockets);
+        return -1;
+    }
+    for (int cpu = 0; cpu < max; cpu++) {
+        topo_cpu_t *c;
+#ifdef __linux__
+        if (have_mask && ! CPU_ISSET(cpu, &mask))
+            continue;
+#endif
+        c = &topo->cpus[num++];
+        c->cpu = cpu;
+        c->socket = read_topo_id(cpu, "physical_package_id");
+        c->core = read_topo_id(cpu, "core_id");
+        c->smt = 0;
+        for (size_t i = 0; i + 1 < num; i++)
+            if (topo->cpus[i].socket == c->socket &&
+                    topo->cpus[i].core == c->core)
+                c->smt++;
+    }
+
+    /* Renumber the sockets 0, 1, ... */
+    topo->num_sockets = 0;
+    for (size_t i = 0; i < num; i++) {
+        int s;
+        for (s = 0; s < topo->num_sockets; s++)
+            if (sockets[s] == topo->cpus[i].socket)
+                break;
+        if (s == topo->num_sockets)
+            sockets[topo->num_sockets++] = topo->cpus[i].socket;
+    }
+    for (size_t i = 0; i < num; i++)
+        for (int s = 0; s < topo->num_sockets; s++)
+            if (sockets[s] == topo->cpus[i].socket) {
+                topo->cpus[i].socket = s;
+                break;
+            }
+    free(sockets);
+    if (topo->num_sockets == 0)
+        topo->num_sockets = 1;
+    topo->num_cpus = num;
+    qsort(topo->cpus, num, sizeof(topo_cpu_t), cmp_cpus);
+    return 0;
+}
+
+void free_topology(topology_t *topo)
+{
+    free(topo->cpus);
+    topo->cpus = NULL;
+    topo->num_cpus = 0;
+}
+
+int pin_thread(pthread_t thread, int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread, sizeof(set), &set) ? -1 : 0;
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,53 @@
+/*
+ * topology.h - CPU topology and thread pinning (header file).
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * The CPUs this process may run on, with their socket (package) and
+ * core as listed in /sys/devices/system/cpu (Linux).  Elsewhere, or
+ * if /sys cannot be read, all the online CPUs are taken to be
+ * separate cores of one socket, and pinning is not supported.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+
+/* A CPU. */
+typedef struct {
+    int cpu;        /* Number of the CPU (for pinning). */
+    int socket;     /* Index of its socket (0, 1, ...). */
+    int core;       /* Core id (within the socket). */
+    int smt;        /* Its rank among the hardware threads of the core. */
+} topo_cpu_t;
+
+/*
+ * The usable CPUs in pinning order: socket by socket, and within a
+ * socket one hardware thread of every core before the second ones.
+ * Pinning threads 0, 1, ... in this order fills one socket at a time
+ * and uses all of its cores before sharing any.
+ */
+typedef struct {
+    size_t num_cpus;
+    topo_cpu_t *cpus;
+    int num_sockets;
+} topology_t;
+
+/* The number of online CPUs (at least 1). */
+int online_cpus(void);
+
+/* Read the topology.  Returns 0 on success, -1 if out of memory. */
+int read_topology(topology_t *topo);
+
+/* Free the topology. */
+void free_topology(topology_t *topo);
+
+/*
+ * Pin `thread` to the CPU numbered `cpu`.  Returns 0 on success, -1
+ * if that is not possible.
+ */
+int pin_thread(pthread_t thread, int cpu);
@@ -3,7 +3,7 @@
  *
  * Author:   Debajyoti Nandi
  * Created:  2016-07-08
- * Modified: 2016-07-13
+ * Modified: 2026-10-18
  * License:  MIT License (see LICENSE.txt)
  *
  * Compilation Suggestions:
@@ -15,6 +15,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 #include "util.h"
 
 void print_array(size_t len, const int a[len])
@@ -100,3 +104,30 @@ void init_array_uint64(size_t len, uint64_t a[len], uint64_t x)
     for (size_t i = 0; i < len; i++)
         a[i] = x;
 }
+
+uint64_t fnv1a(uint64_t h, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+uint64_t nanotime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t cpucycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
@@ -3,7 +3,7 @@
  *
  * Author:   Debajyoti Nandi
  * Created:  2016-07-08
- * Modified: 2016-07-13
+ * Modified: 2026-10-18
  * License:  MIT License (see LICENSE.txt)
  *
  */
@@ -25,3 +25,18 @@ void println_array_uint64(size_t len, const uint64_t a[len]);
 void init_array(size_t len, int a[len], int x);
 void init_array_int64(size_t len, int64_t a[len], int64_t x);
 void init_array_uint64(size_t len, uint64_t a[len], uint64_t x);
+
+/* Size of a cache line (for padding data shared between threads). */
+#define CACHE_LINE 64
+
+/* Hashing */
+/* Offset basis of FNV-1a (64 bits). */
+#define FNV1A_BASIS 14695981039346656037ULL
+/* Continue the FNV-1a hash `h` over the `len` bytes at `data`. */
+uint64_t fnv1a(uint64_t h, const void *data, size_t len);
+
+/* Timing */
+/* Monotonic wall-clock time in nanoseconds. */
+uint64_t nanotime(void);
+/* The CPU time-stamp counter (always 0 where there is none). */
+uint64_t cpucycles(void);
@@ -0,0 +1,119 @@
+/*
+ * vdb.c - Database of verified sum sides.
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * Compilation Suggestions:
+ *   CC = gcc #( or clang)
+ *   CFLAGS = -std=gnu11 -O3 #(or, -O2)
+ *   $(CC) $(CFLAGS) -c vdb.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "util.h"
+#include "vdb.h"
+
+#define VDB_HEADER "partn-vdb 2\n"
+
+/* Check of a record line (up to the check itself). */
+static inline uint64_t line_check(const char *s, size_t len)
+{
+    return fnv1a(FNV1A_BASIS, s, len);
+}
+
+int vdb_open(vdb_t *db, const char *path, const char *spec)
+{
+    struct stat st;
+    char last;
+
+    db->path = path;
+    db->spec = spec;
+    if ((db->fd = open(path, O_RDWR | O_APPEND | O_CREAT, 0666)) < 0)
+        return -1;
+    if (fstat(db->fd, &st))
+        goto fail;
+    if (st.st_size == 0) {
+        if (write(db->fd, VDB_HEADER, strlen(VDB_HEADER)) !=
+                (ssize_t) strlen(VDB_HEADER))
+            goto fail;
+    } else if (pread(db->fd, &last, 1, st.st_size - 1) == 1 &&
+            last != '\n') {
+        /* End the line torn by a crash, so that it stays alone. */
+        if (write(db->fd, "\n", 1) != 1)
+            goto fail;
+    }
+    return 0;
+fail:
+    close(db->fd);
+    db->fd = -1;
+    return -1;
+}
+
+void vdb_close(vdb_t *db)
+{
+    if (db->fd >= 0)
+        close(db->fd);
+    db->fd = -1;
+}
+
+int vdb_load(const vdb_t *db, int N, vdb_record_t rec[], bool have[])
+{
+    char line[1024], spec[512];
+    uint64_t check;
+    vdb_record_t r;
+    int found = 0, len;
+    FILE *fp;
+
+    if ((fp = fopen(db->path, "r")) == NULL)
+        return -1;
+    for (int n = 0; n <= N; n++)
+        have[n] = false;
+    if (fgets(line, sizeof(line), fp) == NULL ||
+            strcmp(line, VDB_HEADER)) {
+        fclose(fp);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        if (strchr(line, '\n') == NULL ||
+                sscanf(line, "R %511s %d %" SCNd64 " %" SCNu64 " %" SCNu64
+                    " %" SCNd64 " %n%" SCNx64, spec, &r.n, &r.sum, &r.count,
+                    &r.ns, &r.time, &len, &check) != 7 ||
+                check != line_check(line, len) ||
+                strcmp(spec, db->spec) || r.n < 0 || r.n > N)
+            continue;
+        if (! have[r.n])
+            found++;
+        have[r.n] = true;
+        rec[r.n] = r;
+    }
+    fclose(fp);
+    return found;
+}
+
+int vdb_append(vdb_t *db, const vdb_record_t *r)
+{
+    char line[1024];
+    int len;
+
+    len = snprintf(line, sizeof(line), "R %s %d %" PRId64 " %" PRIu64
+            " %" PRIu64 " %" PRId64 " ", db->spec, r->n, r->sum, r->count,
+            r->ns, (int64_t) time(NULL));
+    if (len >= (int) sizeof(line) - 18)
+        return -1;
+    len += snprintf(line + len, sizeof(line) - len, "%016" PRIx64 "\n",
+            line_check(line, len));
+    /* One write with O_APPEND: records of threads never interleave. */
+    if (write(db->fd, line, len) != len || fdatasync(db->fd))
+        return -1;
+    return 0;
+}
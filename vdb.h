@@ -0,0 +1,70 @@
+/*
+ * vdb.h - Database of verified sum sides (header file).
+ *
+ * Author:   Debajyoti Nandi <debajyoti.nandi@gmail.com>
+ * Created:  2026-10-18
+ * Modified: 2026-10-18
+ * License:  MIT License (see LICENSE.txt)
+ *
+ * The sum side of an identity at n depends only on the identity (the
+ * filter) and n, so once counted it need not be counted again.  The
+ * database keeps, for each identity ("spec", e.g. the PROGRAM of
+ * partnid and a fingerprint of its filter) and n, the sum side, the
+ * partitions visited and how long that took.
+ *
+ * File format (text, append-only):
+ *
+ *   partn-vdb 2
+ *   R SPEC N SUM COUNT NS TIME CHECK
+ *   ...
+ *
+ * where NS is the time of the computation in nanoseconds, TIME the
+ * Unix time it was stored and CHECK (hex) a hash of the rest of the
+ * line.  Records are only ever appended, each with one write() and
+ * flushed to disk, so a crash can at worst leave a torn last line;
+ * readers skip lines that do not check out, and a writer first ends
+ * a torn line.  For the same (SPEC, N) the last record wins.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* A record. */
+typedef struct {
+    int n;
+    int64_t sum;        /* Sum side. */
+    uint64_t count;     /* Partitions visited. */
+    uint64_t ns;        /* Time of the computation. */
+    int64_t time;       /* Unix time when stored. */
+} vdb_record_t;
+
+/* An open database (for one spec). */
+typedef struct {
+    int fd;
+    const char *path;
+    const char *spec;   /* No white space. */
+} vdb_t;
+
+/*
+ * Open (or create) the database `path` for records of `spec`.
+ * Returns 0 on success, -1 on failure.
+ */
+int vdb_open(vdb_t *db, const char *path, const char *spec);
+
+/* Close the database. */
+void vdb_close(vdb_t *db);
+
+/*
+ * Load the records of the spec with n <= N into `rec[n]`, setting
+ * `have[n]` for those found.  Returns the number of n found, or -1 if
+ * the file cannot be read.
+ */
+int vdb_load(const vdb_t *db, int N, vdb_record_t rec[], bool have[]);
+
+/*
+ * Append a record (stamped with the current time).  Returns 0 on
+ * success, -1 on failure.  Safe to call from several threads.
+ */
+int vdb_append(vdb_t *db, const vdb_record_t *r);